@@ -26,6 +26,9 @@
 #include "filesystem/Filesystem.h"
 #include "log/Log.h"
 #include "log/LogAddon.h"
+#include "metrics/LockProfiler.h"
+#include "metrics/Metrics.h"
+#include "metrics/Tracer.h"
 #include "settings/Settings.h"
 #include "storage/StorageManager.h"
 #include "utils/CommonIncludes.h" // for libXBMC_addon.h
@@ -37,16 +40,57 @@
 #include "kodi_peripheral_utils.hpp"
 
 #include <algorithm>
+#include <stdlib.h>
+#include <string>
 #include <vector>
 
 using namespace JOYSTICK;
 
+#define ANNOUNCE_SENDER             "peripheral.joystick"
+#define ANNOUNCE_DUMP_INPUT_TRACE   "DumpInputTrace"
+#define ANNOUNCE_LOG_LOCK_PROFILE   "LogLockProfile"
+#define ANNOUNCE_LOG_MEMORY         "LogMemoryFootprint"
+#define ANNOUNCE_DUMP_METRICS       "DumpMetrics"
+#define ANNOUNCE_START_TRACE        "StartTrace"
+#define ANNOUNCE_STOP_TRACE         "StopTrace"
+
+#define LOCK_PROFILE_REPORT_SIZE  10 // Number of locks in the report
+
+#define METRICS_FILE       "metrics.prom"
+#define METRICS_JSON_FILE  "metrics.json"
+#define TRACE_FILE         "trace.json"
+
+// Set to a file path to trace from startup
+#define TRACE_FILE_ENVIRONMENT_VARIABLE  "JOYSTICK_TRACE_FILE"
+
+namespace
+{
+  // Pass the stored device configuration to the joysticks' drivers
+  void UpdateDeviceConfiguration(const ADDON::Joystick& joystick)
+  {
+    PrimitiveVector primitives;
+    CStorageManager::Get().GetIgnoredPrimitives(joystick, primitives);
+    CJoystickManager::Get().SetIgnoredPrimitives(joystick, primitives);
+
+    AxisConfigurationMap axes;
+    CStorageManager::Get().GetAxisConfigurations(joystick, axes);
+    for (const auto& axis : axes)
+    {
+      if (axis.second.fuzz != 0 || axis.second.flat != 0)
+        CJoystickManager::Get().SetAxisCalibration(joystick, axis.first, axis.second.fuzz, axis.second.flat);
+    }
+
+    CJoystickManager::Get().SetExclusiveGrab(joystick, CStorageManager::Get().GetExclusiveGrab(joystick));
+  }
+}
+
 extern "C"
 {
 
 ADDON::CHelper_libXBMC_addon*      FRONTEND;
 ADDON::CHelper_libKODI_peripheral* PERIPHERAL;
 CPeripheralScanner*                SCANNER;
+std::string                        USER_PATH;
 
 ADDON_STATUS ADDON_Create(void* callbacks, void* props)
 {
@@ -72,7 +116,15 @@ ADDON_STATUS ADDON_Create(void* callbacks, void* props)
     return status;
   }
 
+  if (peripheralProps->user_path)
+    USER_PATH = peripheralProps->user_path;
+
   CLog::Get().SetPipe(new CLogAddon(FRONTEND));
+  CLog::Get().StartAsync();
+
+  const char* traceFile = getenv(TRACE_FILE_ENVIRONMENT_VARIABLE);
+  if (traceFile != nullptr && *traceFile != '\0')
+    CTracer::Get().Start(traceFile);
 
   if (!CFilesystem::Initialize(FRONTEND))
     return ADDON_STATUS_PERMANENT_FAILURE;
@@ -97,6 +149,14 @@ void ADDON_Destroy()
   CJoystickManager::Get().Deinitialize();
   CFilesystem::Deinitialize();
 
+  CTracer::Get().Stop();
+  CMetrics::Get().StopDump();
+
+#if defined(JOYSTICK_LOCK_PROFILING)
+  CLockProfiler::Get().LogReport(LOCK_PROFILE_REPORT_SIZE);
+#endif
+
+  CLog::Get().StopAsync();
   CLog::Get().SetType(SYS_LOG_TYPE_CONSOLE);
 
   SAFE_DELETE(PERIPHERAL);
@@ -128,8 +188,18 @@ unsigned int ADDON_GetSettings(ADDON_StructSetting ***sSet)
 ADDON_STATUS ADDON_SetSetting(const char* settingName, const void* settingValue)
 {
   if (settingName && settingValue)
+  {
     CSettings::Get().SetSetting(settingName, settingValue);
 
+    // Applies to open joysticks, and to joysticks opened later
+    CJoystickManager::Get().SetExclusiveGrab(CSettings::Get().ExclusiveGrab());
+
+    if (CSettings::Get().DumpMetrics() && !USER_PATH.empty())
+      CMetrics::Get().StartDump(USER_PATH + "/" METRICS_FILE);
+    else
+      CMetrics::Get().StopDump();
+  }
+
   return ADDON_STATUS_OK;
 }
 
@@ -139,6 +209,27 @@ void ADDON_FreeSettings()
 
 void ADDON_Announce(const char* flag, const char* sender, const char* message, const void* data)
 {
+  if (!sender || !message)
+    return;
+
+  // Triggered by JSONRPC.NotifyAll with sender "peripheral.joystick"
+  if (std::string(sender) != ANNOUNCE_SENDER)
+    return;
+
+  if (std::string(message) == ANNOUNCE_DUMP_INPUT_TRACE)
+    CJoystickManager::Get().DumpInputTraces(USER_PATH);
+  else if (std::string(message) == ANNOUNCE_START_TRACE)
+    CTracer::Get().Start(USER_PATH + "/" TRACE_FILE);
+  else if (std::string(message) == ANNOUNCE_STOP_TRACE)
+    CTracer::Get().Stop();
+  else if (std::string(message) == ANNOUNCE_LOG_MEMORY)
+    CStorageManager::Get().LogMemoryFootprint();
+  else if (std::string(message) == ANNOUNCE_DUMP_METRICS)
+    CMetrics::Get().WriteJson(USER_PATH + "/" METRICS_JSON_FILE);
+#if defined(JOYSTICK_LOCK_PROFILING)
+  else if (std::string(message) == ANNOUNCE_LOG_LOCK_PROFILE)
+    CLockProfiler::Get().LogReport(LOCK_PROFILE_REPORT_SIZE);
+#endif
 }
 
 const char* GetPeripheralAPIVersion(void)
@@ -167,6 +258,8 @@ PERIPHERAL_ERROR PerformDeviceScan(unsigned int* peripheral_count, PERIPHERAL_IN
   if (!peripheral_count || !scan_results)
     return PERIPHERAL_ERROR_INVALID_PARAMETERS;
 
+  CMetricTimer timer(METRIC_PERFORM_DEVICE_SCAN);
+
   JoystickVector joysticks;
   if (!CJoystickManager::Get().PerformJoystickScan(joysticks))
     return PERIPHERAL_ERROR_FAILED;
@@ -174,7 +267,10 @@ PERIPHERAL_ERROR PerformDeviceScan(unsigned int* peripheral_count, PERIPHERAL_IN
   // Upcast array pointers
   std::vector<ADDON::Peripheral*> peripherals;
   for (JoystickVector::const_iterator it = joysticks.begin(); it != joysticks.end(); ++it)
+  {
+    UpdateDeviceConfiguration(**it);
     peripherals.push_back(it->get());
+  }
 
   *peripheral_count = peripherals.size();
   ADDON::Peripherals::ToStructs(peripherals, scan_results);
@@ -192,13 +288,19 @@ PERIPHERAL_ERROR GetEvents(unsigned int* event_count, PERIPHERAL_EVENT** events)
   if (!event_count || !events)
     return PERIPHERAL_ERROR_INVALID_PARAMETERS;
 
+  CMetricTimer timer(METRIC_GET_EVENTS);
+
   PERIPHERAL_ERROR result = PERIPHERAL_ERROR_FAILED;
 
-  std::vector<ADDON::PeripheralEvent> peripheralEvents;
+  // Reuse the event buffer's capacity across frames
+  static thread_local std::vector<ADDON::PeripheralEvent> peripheralEvents;
+  peripheralEvents.clear();
+
   if (CJoystickManager::Get().GetEvents(peripheralEvents))
   {
     *event_count = peripheralEvents.size();
     ADDON::PeripheralEvents::ToStructs(peripheralEvents, events);
+    CMetrics::Get().Increment(METRIC_COUNTER_EVENTS, peripheralEvents.size());
     result = PERIPHERAL_NO_ERROR;
   }
 
@@ -216,6 +318,8 @@ bool SendEvent(const PERIPHERAL_EVENT* event)
 {
   bool bHandled = false;
 
+  CMetricTimer timer(METRIC_SEND_EVENT);
+
   if (event != nullptr)
     bHandled = CJoystickManager::Get().SendEvent(*event);
 
@@ -251,6 +355,8 @@ PERIPHERAL_ERROR GetFeatures(const JOYSTICK_INFO* joystick, const char* controll
   if (!joystick || !controller_id || !feature_count || !features)
     return PERIPHERAL_ERROR_INVALID_PARAMETERS;
 
+  CMetricTimer timer(METRIC_GET_FEATURES);
+
   FeatureVector featureVector;
   CStorageManager::Get().GetFeatures(ADDON::Joystick(*joystick), controller_id,  featureVector);
 
@@ -271,6 +377,8 @@ PERIPHERAL_ERROR MapFeatures(const JOYSTICK_INFO* joystick, const char* controll
   if (!joystick || !controller_id || (feature_count > 0 && !features))
     return PERIPHERAL_ERROR_INVALID_PARAMETERS;
 
+  CMetricTimer timer(METRIC_MAP_FEATURES);
+
   FeatureVector featureVector(features, features + feature_count);
   bool bSuccess = CStorageManager::Get().MapFeatures(ADDON::Joystick(*joystick), controller_id, featureVector);
 
@@ -310,7 +418,12 @@ PERIPHERAL_ERROR SetIgnoredPrimitives(const JOYSTICK_INFO* joystick,
   for (unsigned int i = 0; i < primitive_count; i++)
     primitiveVector.emplace_back(*(primitives + i));
 
-  bool bSuccess = CStorageManager::Get().SetIgnoredPrimitives(ADDON::Joystick(*joystick), primitiveVector);
+  ADDON::Joystick addonJoystick(*joystick);
+
+  bool bSuccess = CStorageManager::Get().SetIgnoredPrimitives(addonJoystick, primitiveVector);
+
+  if (bSuccess)
+    CJoystickManager::Get().SetIgnoredPrimitives(addonJoystick, primitiveVector);
 
   return bSuccess ? PERIPHERAL_NO_ERROR : PERIPHERAL_ERROR_FAILED;
 }
@@ -320,6 +433,8 @@ void SaveButtonMap(const JOYSTICK_INFO* joystick)
   if (joystick == nullptr)
     return;
 
+  CMetricTimer timer(METRIC_SAVE_BUTTON_MAP);
+
   ADDON::Joystick addonJoystick(*joystick);
 
   CStorageManager::Get().SaveButtonMap(addonJoystick);
@@ -333,6 +448,8 @@ void RevertButtonMap(const JOYSTICK_INFO* joystick)
   ADDON::Joystick addonJoystick(*joystick);
 
   CStorageManager::Get().RevertButtonMap(addonJoystick);
+
+  UpdateDeviceConfiguration(addonJoystick);
 }
 
 void ResetButtonMap(const JOYSTICK_INFO* joystick, const char* controller_id)
@@ -343,6 +460,8 @@ void ResetButtonMap(const JOYSTICK_INFO* joystick, const char* controller_id)
   ADDON::Joystick addonJoystick(*joystick);
 
   CStorageManager::Get().ResetButtonMap(addonJoystick, controller_id);
+
+  UpdateDeviceConfiguration(addonJoystick);
 }
 
 void PowerOffJoystick(unsigned int index)
@@ -0,0 +1,78 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <vector>
+
+namespace JOYSTICK
+{
+  class CJoystick;
+
+  /*!
+   * \brief Waits on the fds of all joysticks at once, so that only joysticks
+   *        with pending input are scanned
+   *
+   * NOTE: Not thread-safe, the joystick manager calls it with its joystick
+   *       lock held
+   */
+  class IInputPoller
+  {
+  public:
+    virtual ~IInputPoller(void) { }
+
+    /*!
+     * \brief Get a short name for the poller
+     */
+    virtual const char* Name(void) const = 0;
+
+    /*!
+     * \brief Initialize the poller
+     *
+     * \return false if the poller isn't supported by the kernel
+     */
+    virtual bool Initialize(void) = 0;
+
+    /*!
+     * \brief Deinitialize the poller
+     */
+    virtual void Deinitialize(void) { }
+
+    /*!
+     * \brief Start polling a joystick's input fds
+     *
+     * \return false if the joystick has no fds, and must always be scanned
+     */
+    virtual bool AddJoystick(CJoystick* joystick) = 0;
+
+    /*!
+     * \brief Stop polling a joystick, before it's deinitialized
+     */
+    virtual void RemoveJoystick(CJoystick* joystick) = 0;
+
+    /*!
+     * \brief Get the joysticks that have input to read, without blocking
+     *
+     * \param readyJoysticks (out) the ready joysticks, sorted and without duplicates
+     *
+     * \return false if polling failed and all joysticks should be scanned
+     */
+    virtual bool Poll(std::vector<CJoystick*>& readyJoysticks) = 0;
+  };
+}
@@ -0,0 +1,261 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "InputHistory.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  inline int16_t QuantizeAxis(JOYSTICK_STATE_AXIS value)
+  {
+    const float clamped = std::max(-1.0f, std::min(value, 1.0f));
+    return static_cast<int16_t>(clamped * 32767.0f + (clamped < 0.0f ? -0.5f : 0.5f));
+  }
+}
+
+CInputHistory::CInputHistory(void)
+ : m_buttonCount(0),
+   m_hatCount(0),
+   m_axisCount(0),
+   m_hatOffset(0),
+   m_axisOffset(0),
+   m_stride(0),
+   m_mask(0),
+   m_writeCount(0),
+   m_firstSnapshot(0)
+{
+}
+
+void CInputHistory::Initialize(unsigned int buttonCount, unsigned int hatCount, unsigned int axisCount, unsigned int capacity)
+{
+  Deinitialize();
+
+  capacity = std::min(capacity, static_cast<unsigned int>(INPUT_HISTORY_MAX_SIZE));
+  if (capacity == 0)
+    return;
+
+  unsigned int roundedCapacity = 1;
+  while (roundedCapacity < capacity)
+    roundedCapacity <<= 1;
+
+  m_buttonCount = buttonCount;
+  m_hatCount    = hatCount;
+  m_axisCount   = axisCount;
+
+  // 32 buttons, 8 hats or 2 axes per word
+  m_hatOffset  = (buttonCount + 31) / 32;
+  m_axisOffset = m_hatOffset + (hatCount + 7) / 8;
+  m_stride     = std::max(m_axisOffset + (axisCount + 1) / 2, 1u);
+  m_mask       = roundedCapacity - 1;
+
+  m_times.assign(roundedCapacity, 0);
+  m_words.assign(static_cast<size_t>(roundedCapacity) * m_stride, 0);
+  m_scratch.assign(m_stride, 0);
+  m_initialState.assign(m_stride, 0);
+}
+
+void CInputHistory::Deinitialize(void)
+{
+  m_times.clear();
+  m_times.shrink_to_fit();
+  m_words.clear();
+  m_words.shrink_to_fit();
+  m_scratch.clear();
+  m_initialState.clear();
+
+  m_buttonCount   = 0;
+  m_hatCount      = 0;
+  m_axisCount     = 0;
+  m_stride        = 0;
+  m_mask          = 0;
+  m_writeCount    = 0;
+  m_firstSnapshot = 0;
+}
+
+void CInputHistory::Record(int64_t timeNs,
+                           const std::vector<JOYSTICK_STATE_BUTTON>& buttons,
+                           const std::vector<JOYSTICK_STATE_HAT>& hats,
+                           const std::vector<JOYSTICK_STATE_AXIS>& axes)
+{
+  if (!IsEnabled())
+    return;
+
+  std::fill(m_scratch.begin(), m_scratch.end(), 0);
+
+  const unsigned int buttonCount = std::min(m_buttonCount, static_cast<unsigned int>(buttons.size()));
+  for (unsigned int i = 0; i < buttonCount; i++)
+  {
+    if (buttons[i] == JOYSTICK_STATE_BUTTON_PRESSED)
+      m_scratch[i / 32] |= 1u << (i % 32);
+  }
+
+  const unsigned int hatCount = std::min(m_hatCount, static_cast<unsigned int>(hats.size()));
+  for (unsigned int i = 0; i < hatCount; i++)
+    m_scratch[m_hatOffset + i / 8] |= (static_cast<uint32_t>(hats[i]) & 0xf) << (i % 8 * 4);
+
+  const unsigned int axisCount = std::min(m_axisCount, static_cast<unsigned int>(axes.size()));
+  for (unsigned int i = 0; i < axisCount; i++)
+    m_scratch[m_axisOffset + i / 2] |= static_cast<uint32_t>(static_cast<uint16_t>(QuantizeAxis(axes[i]))) << (i % 2 * 16);
+
+  if (m_writeCount > m_firstSnapshot)
+  {
+    const uint64_t last = m_writeCount - 1;
+
+    // Changes smaller than the quantization don't make a new snapshot
+    if (memcmp(WordsAt(last), m_scratch.data(), m_stride * sizeof(uint32_t)) == 0)
+      return;
+
+    timeNs = std::max(timeNs, TimeAt(last));
+  }
+
+  m_times[m_writeCount & m_mask] = timeNs;
+  memcpy(m_words.data() + (m_writeCount & m_mask) * m_stride, m_scratch.data(), m_stride * sizeof(uint32_t));
+
+  m_writeCount++;
+  if (m_writeCount - m_firstSnapshot > m_mask + 1)
+    m_firstSnapshot++;
+}
+
+CInputHistorySnapshot CInputHistory::GetSnapshot(unsigned int index) const
+{
+  if (index >= Size())
+    return CInputHistorySnapshot();
+
+  return SnapshotAt(m_firstSnapshot + index);
+}
+
+CInputHistorySnapshot CInputHistory::GetState(int64_t timeNs) const
+{
+  const uint64_t snapshot = UpperBound(timeNs);
+  if (snapshot == m_firstSnapshot)
+    return CInputHistorySnapshot();
+
+  return SnapshotAt(snapshot - 1);
+}
+
+bool CInputHistory::GetChanges(int64_t fromNs, int64_t toNs, unsigned int peripheralIndex,
+                               std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs) const
+{
+  if (!IsEnabled())
+    return false;
+
+  bool bComplete = true;
+
+  uint64_t begin = UpperBound(fromNs);
+  const uint64_t end = UpperBound(toNs);
+
+  // The state before the first snapshot is the joystick's initial state,
+  // which is all zeros, unless the ring has overwritten snapshots since
+  const uint32_t* previous;
+  if (begin > m_firstSnapshot)
+  {
+    previous = WordsAt(begin - 1);
+  }
+  else if (m_firstSnapshot == 0)
+  {
+    previous = m_initialState.data();
+  }
+  else
+  {
+    if (begin >= end)
+      return false;
+
+    previous = WordsAt(begin++);
+    bComplete = false;
+  }
+
+  for (uint64_t snapshot = begin; snapshot < end; snapshot++)
+  {
+    const uint32_t* current = WordsAt(snapshot);
+    const int64_t timeNs = TimeAt(snapshot);
+
+    for (unsigned int word = 0; word < m_hatOffset; word++)
+    {
+      uint32_t changed = previous[word] ^ current[word];
+      for (unsigned int bit = 0; changed != 0; bit++, changed >>= 1)
+      {
+        if (changed & 1)
+        {
+          const unsigned int buttonIndex = word * 32 + bit;
+          const bool bPressed = ((current[word] >> bit) & 1) != 0;
+          events.push_back(ADDON::PeripheralEvent(peripheralIndex, buttonIndex,
+              bPressed ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED));
+          eventTimesNs.push_back(timeNs);
+        }
+      }
+    }
+
+    for (unsigned int hatIndex = 0; hatIndex < m_hatCount; hatIndex++)
+    {
+      const unsigned int word = m_hatOffset + hatIndex / 8;
+      const unsigned int shift = hatIndex % 8 * 4;
+      const uint32_t hat = (current[word] >> shift) & 0xf;
+      if (hat != ((previous[word] >> shift) & 0xf))
+      {
+        events.push_back(ADDON::PeripheralEvent(peripheralIndex, hatIndex, static_cast<JOYSTICK_STATE_HAT>(hat)));
+        eventTimesNs.push_back(timeNs);
+      }
+    }
+
+    for (unsigned int axisIndex = 0; axisIndex < m_axisCount; axisIndex++)
+    {
+      const unsigned int word = m_axisOffset + axisIndex / 2;
+      const unsigned int shift = axisIndex % 2 * 16;
+      const uint16_t axis = static_cast<uint16_t>(current[word] >> shift);
+      if (axis != static_cast<uint16_t>(previous[word] >> shift))
+      {
+        events.push_back(ADDON::PeripheralEvent(peripheralIndex, axisIndex, static_cast<int16_t>(axis) / 32767.0f));
+        eventTimesNs.push_back(timeNs);
+      }
+    }
+
+    previous = current;
+  }
+
+  return bComplete;
+}
+
+uint64_t CInputHistory::UpperBound(int64_t timeNs) const
+{
+  // Binary search over the ring's times, which are in time order
+  uint64_t first = m_firstSnapshot;
+  uint64_t count = m_writeCount - m_firstSnapshot;
+
+  while (count > 0)
+  {
+    const uint64_t half = count / 2;
+    const uint64_t middle = first + half;
+    if (TimeAt(middle) <= timeNs)
+    {
+      first = middle + 1;
+      count -= half + 1;
+    }
+    else
+    {
+      count = half;
+    }
+  }
+
+  return first;
+}
@@ -0,0 +1,177 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+#define INPUT_HISTORY_DEFAULT_SIZE  1024  // Snapshots per joystick
+#define INPUT_HISTORY_MAX_SIZE      65536 // Upper bound of the setting, in snapshots
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Read-only view of a snapshot in the input history
+   *
+   * Valid until the history records another snapshot.
+   */
+  class CInputHistorySnapshot
+  {
+  public:
+    CInputHistorySnapshot(void) : m_timeNs(-1), m_words(nullptr), m_hatOffset(0), m_axisOffset(0) { }
+    CInputHistorySnapshot(int64_t timeNs, const uint32_t* words, unsigned int hatOffset, unsigned int axisOffset) :
+      m_timeNs(timeNs), m_words(words), m_hatOffset(hatOffset), m_axisOffset(axisOffset) { }
+
+    bool IsValid(void) const { return m_words != nullptr; }
+
+    /*!
+     * \brief Time of the snapshot, in nanoseconds of the monotonic clock
+     */
+    int64_t TimeNs(void) const { return m_timeNs; }
+
+    JOYSTICK_STATE_BUTTON Button(unsigned int buttonIndex) const
+    {
+      return ((m_words[buttonIndex / 32] >> (buttonIndex % 32)) & 1) ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED;
+    }
+
+    JOYSTICK_STATE_HAT Hat(unsigned int hatIndex) const
+    {
+      return static_cast<JOYSTICK_STATE_HAT>((m_words[m_hatOffset + hatIndex / 8] >> (hatIndex % 8 * 4)) & 0xf);
+    }
+
+    /*!
+     * \brief Axis value, quantized to 16 bits
+     */
+    JOYSTICK_STATE_AXIS Axis(unsigned int axisIndex) const
+    {
+      const uint16_t bits = static_cast<uint16_t>(m_words[m_axisOffset + axisIndex / 2] >> (axisIndex % 2 * 16));
+      return static_cast<int16_t>(bits) / 32767.0f;
+    }
+
+  private:
+    int64_t         m_timeNs;
+    const uint32_t* m_words;
+    unsigned int    m_hatOffset;
+    unsigned int    m_axisOffset;
+  };
+
+  /*!
+   * \brief Fixed-capacity ring of timestamped joystick states
+   *
+   * A snapshot is recorded when a poll changes the joystick's state. Buttons
+   * are packed into bits, hats into nibbles and axes are quantized to 16 bits,
+   * so a gamepad's snapshot is a few words. Snapshot times are kept apart from
+   * the states so that searching by time only touches the times.
+   *
+   * When the ring is full, the oldest snapshots are overwritten. Memory is
+   * allocated once, in Initialize().
+   *
+   * The history is not synchronized. It is written from GetEvents(), and must
+   * only be read while GetEvents() can't run.
+   */
+  class CInputHistory
+  {
+  public:
+    CInputHistory(void);
+
+    /*!
+     * \brief Allocate the ring
+     *
+     * \param capacity The number of snapshots to keep, rounded up to a power
+     *        of two. The history is disabled if 0.
+     */
+    void Initialize(unsigned int buttonCount, unsigned int hatCount, unsigned int axisCount, unsigned int capacity);
+    void Deinitialize(void);
+
+    bool IsEnabled(void) const { return !m_times.empty(); }
+
+    /*!
+     * \brief Record the joystick's state, if it differs from the last snapshot
+     *
+     * Times earlier than the last snapshot's are clamped to keep the ring in
+     * time order.
+     */
+    void Record(int64_t timeNs,
+                const std::vector<JOYSTICK_STATE_BUTTON>& buttons,
+                const std::vector<JOYSTICK_STATE_HAT>& hats,
+                const std::vector<JOYSTICK_STATE_AXIS>& axes);
+
+    /*!
+     * \brief Number of snapshots in the ring
+     */
+    unsigned int Size(void) const { return static_cast<unsigned int>(m_writeCount - m_firstSnapshot); }
+
+    /*!
+     * \brief Get a snapshot by age, where 0 is the oldest snapshot in the ring
+     */
+    CInputHistorySnapshot GetSnapshot(unsigned int index) const;
+
+    /*!
+     * \brief Get the state the joystick was in at a time, in O(log n)
+     *
+     * \return The latest snapshot at or before timeNs, or an invalid snapshot
+     *         if the time is older than the ring
+     */
+    CInputHistorySnapshot GetState(int64_t timeNs) const;
+
+    /*!
+     * \brief Get the changes in the joystick's state after fromNs, up to and
+     *        including toNs
+     *
+     * Changes are appended in time order as driver events, with their times
+     * appended to eventTimesNs. Only the snapshots in the interval are
+     * visited, and unchanged button words are skipped.
+     *
+     * \return false if fromNs is older than the ring, in which case the
+     *         changes start at the oldest snapshot
+     */
+    bool GetChanges(int64_t fromNs, int64_t toNs, unsigned int peripheralIndex,
+                    std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs) const;
+
+  private:
+    /*!
+     * \brief Index of the first snapshot later than timeNs
+     */
+    uint64_t UpperBound(int64_t timeNs) const;
+
+    const int64_t& TimeAt(uint64_t snapshot) const { return m_times[snapshot & m_mask]; }
+    const uint32_t* WordsAt(uint64_t snapshot) const { return m_words.data() + (snapshot & m_mask) * m_stride; }
+    CInputHistorySnapshot SnapshotAt(uint64_t snapshot) const
+    {
+      return CInputHistorySnapshot(TimeAt(snapshot), WordsAt(snapshot), m_hatOffset, m_axisOffset);
+    }
+
+    unsigned int          m_buttonCount;
+    unsigned int          m_hatCount;
+    unsigned int          m_axisCount;
+    unsigned int          m_hatOffset;  // First word of the hats in a snapshot
+    unsigned int          m_axisOffset; // First word of the axes in a snapshot
+    unsigned int          m_stride;     // Words per snapshot
+    uint64_t              m_mask;       // Capacity - 1
+    std::vector<int64_t>  m_times;
+    std::vector<uint32_t> m_words;
+    std::vector<uint32_t> m_scratch;      // State being encoded by Record()
+    std::vector<uint32_t> m_initialState; // All zeros, the state before the first snapshot
+    uint64_t              m_writeCount;
+    uint64_t              m_firstSnapshot;
+  };
+}
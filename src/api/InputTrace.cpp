@@ -0,0 +1,81 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "InputTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+using namespace JOYSTICK;
+
+static_assert((INPUT_TRACE_SIZE & (INPUT_TRACE_SIZE - 1)) == 0, "INPUT_TRACE_SIZE must be a power of two");
+static_assert(sizeof(InputTraceRecord) == 16, "Trace record layout changed");
+
+CInputTrace::CInputTrace(void)
+ : m_records(INPUT_TRACE_SIZE),
+   m_writeCount(0),
+   m_timestampNs(0),
+   m_bPollPending(false)
+{
+}
+
+void CInputTrace::BeginPoll(void)
+{
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  m_timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  m_bPollPending = true;
+}
+
+bool CInputTrace::Dump(const std::string& path, const std::string& provider, const std::string& name) const
+{
+  const uint64_t recordCount = std::min(m_writeCount, static_cast<uint64_t>(INPUT_TRACE_SIZE));
+  const uint64_t firstRecord = m_writeCount - recordCount;
+
+  InputTraceHeader header = { };
+  memcpy(header.magic, INPUT_TRACE_MAGIC, sizeof(header.magic));
+  header.version      = INPUT_TRACE_VERSION;
+  header.recordSize   = sizeof(InputTraceRecord);
+  header.recordCount  = static_cast<uint32_t>(recordCount);
+  header.droppedCount = firstRecord;
+  strncpy(header.provider, provider.c_str(), sizeof(header.provider) - 1);
+  strncpy(header.name, name.c_str(), sizeof(header.name) - 1);
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr)
+    return false;
+
+  bool bSuccess = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+  // Write the ring from oldest to newest, in at most two contiguous runs
+  const size_t start = static_cast<size_t>(firstRecord & (INPUT_TRACE_SIZE - 1));
+  const size_t firstRun = std::min(static_cast<size_t>(recordCount), INPUT_TRACE_SIZE - start);
+  const size_t secondRun = static_cast<size_t>(recordCount) - firstRun;
+
+  if (bSuccess && firstRun > 0)
+    bSuccess = (fwrite(m_records.data() + start, sizeof(InputTraceRecord), firstRun, file) == firstRun);
+  if (bSuccess && secondRun > 0)
+    bSuccess = (fwrite(m_records.data(), sizeof(InputTraceRecord), secondRun, file) == secondRun);
+
+  if (fclose(file) != 0)
+    bSuccess = false;
+
+  return bSuccess;
+}
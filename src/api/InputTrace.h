@@ -0,0 +1,140 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define INPUT_TRACE_SIZE     4096 // Records per joystick, must be a power of two
+#define INPUT_TRACE_MAGIC    "JSTRACE1"
+#define INPUT_TRACE_VERSION  1
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Kinds of records in an input trace
+   *
+   * NOTE: Values are stored in trace files and must not be renumbered
+   */
+  enum INPUT_TRACE_KIND
+  {
+    INPUT_TRACE_POLL = 0,        // Start of a GetEvents() that recorded anything
+    INPUT_TRACE_RAW = 1,         // Backend event, with backend-specific type, code and value
+    INPUT_TRACE_BUTTON = 2,      // Button state set by the backend
+    INPUT_TRACE_HAT = 3,         // Hat state set by the backend
+    INPUT_TRACE_AXIS = 4,        // Axis value after filtering, value holds the float's bits
+    INPUT_TRACE_EMIT_BUTTON = 5, // Button event returned by GetEvents()
+    INPUT_TRACE_EMIT_HAT = 6,    // Hat event returned by GetEvents()
+    INPUT_TRACE_EMIT_AXIS = 7,   // Axis event returned by GetEvents(), value holds the float's bits
+  };
+
+  /*!
+   * \brief A single 16-byte trace record
+   */
+  struct InputTraceRecord
+  {
+    uint64_t timestampNs; // Monotonic time of the poll that produced the record
+    uint8_t  kind;        // INPUT_TRACE_KIND
+    uint8_t  type;        // Backend event type, for raw records
+    uint16_t index;       // Backend event code, or button/hat/axis index
+    int32_t  value;
+  };
+
+  /*!
+   * \brief Header at the start of a trace file, followed by the records from
+   *        oldest to newest
+   */
+  struct InputTraceHeader
+  {
+    char     magic[8];    // INPUT_TRACE_MAGIC
+    uint32_t version;     // INPUT_TRACE_VERSION
+    uint32_t recordSize;  // sizeof(InputTraceRecord)
+    uint32_t recordCount;
+    uint32_t reserved;
+    uint64_t droppedCount; // Records overwritten before the dump
+    char     provider[16];
+    char     name[64];
+  };
+
+  /*!
+   * \brief Always-on, fixed-size ring of recent input activity for a joystick
+   *
+   * Records are timestamped with the time of the current poll, which is read
+   * once per GetEvents(), so recording a record is a handful of stores. Only
+   * changes are recorded, and the poll marker is written before the first
+   * record of a poll, so idle polls don't wrap the ring. When the ring is
+   * full, the oldest records are overwritten.
+   *
+   * The trace is not synchronized. It is written from GetEvents(), and must
+   * only be dumped while GetEvents() can't run.
+   */
+  class CInputTrace
+  {
+  public:
+    CInputTrace(void);
+
+    /*!
+     * \brief Read the monotonic clock for records of the current poll
+     *
+     * The poll marker is deferred until the poll records something.
+     */
+    void BeginPoll(void);
+
+    void RecordRaw(unsigned int type, unsigned int code, int value) { Record(INPUT_TRACE_RAW, type, code, value); }
+    void Record(INPUT_TRACE_KIND kind, unsigned int index, int value) { Record(kind, 0, index, value); }
+    void Record(INPUT_TRACE_KIND kind, unsigned int index, float value)
+    {
+      int32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      Record(kind, 0, index, bits);
+    }
+
+    /*!
+     * \brief Write the trace to a file
+     *
+     * \return true if the file was written
+     */
+    bool Dump(const std::string& path, const std::string& provider, const std::string& name) const;
+
+  private:
+    void Record(INPUT_TRACE_KIND kind, unsigned int type, unsigned int index, int32_t value)
+    {
+      if (m_bPollPending)
+      {
+        m_bPollPending = false;
+        Record(INPUT_TRACE_POLL, 0, 0, 0);
+      }
+
+      InputTraceRecord& record = m_records[m_writeCount++ & (INPUT_TRACE_SIZE - 1)];
+      record.timestampNs = m_timestampNs;
+      record.kind        = static_cast<uint8_t>(kind);
+      record.type        = static_cast<uint8_t>(type);
+      record.index       = static_cast<uint16_t>(index);
+      record.value       = value;
+    }
+
+    std::vector<InputTraceRecord> m_records;
+    uint64_t                      m_writeCount;
+    uint64_t                      m_timestampNs;
+    bool                          m_bPollPending;
+  };
+}
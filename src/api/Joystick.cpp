@@ -19,19 +19,30 @@
 
 #include "Joystick.h"
 #include "AnomalousTrigger.h"
+#include "JoystickState.h"
 #include "log/Log.h"
+#include "metrics/Metrics.h"
 #include "settings/Settings.h"
 #include "utils/CommonMacros.h"
 #include "utils/StringUtils.h"
 
 #include "p8-platform/util/timeutils.h"
 
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <utility>
+
 using namespace JOYSTICK;
 
 #define ANALOG_EPSILON  0.0001f
 
 CJoystick::CJoystick(const std::string& strProvider)
- : m_discoverTimeMs(P8PLATFORM::GetTimeMs()),
+ : m_stateArena(nullptr),
+   m_eventTimeNs(-1),
+   m_bStateChanged(false),
+   m_stateSequence(1),
+   m_discoverTimeMs(P8PLATFORM::GetTimeMs()),
    m_activateTimeMs(-1),
    m_firstEventTimeMs(-1),
    m_lastEventTimeMs(-1)
@@ -73,51 +84,99 @@ bool CJoystick::Initialize(void)
     return false;
   }
 
-  m_state.buttons.assign(ButtonCount(), JOYSTICK_STATE_BUTTON_UNPRESSED);
-  m_state.hats.assign(HatCount(), JOYSTICK_STATE_HAT_UNPRESSED);
-  m_state.axes.assign(AxisCount(), 0.0f);
+  m_hats.assign(HatCount(), JOYSTICK_STATE_HAT_UNPRESSED);
 
   m_stateBuffer.buttons.assign(ButtonCount(), JOYSTICK_STATE_BUTTON_UNPRESSED);
   m_stateBuffer.hats.assign(HatCount(), JOYSTICK_STATE_HAT_UNPRESSED);
   m_stateBuffer.axes.assign(AxisCount(), 0.0f);
 
+  m_stateTimes.buttons.assign(ButtonCount(), 0);
+  m_stateTimes.hats.assign(HatCount(), 0);
+  m_stateTimes.axes.assign(AxisCount(), 0);
+
   // Filter for anomalous triggers
   m_axisFilters.reserve(AxisCount());
   for (unsigned int i = 0; i < AxisCount(); i++)
     m_axisFilters.push_back(new CAnomalousTrigger(i, this));
 
+  m_history.Initialize(ButtonCount(), HatCount(), AxisCount(), CSettings::Get().InputHistorySize());
+
   return true;
 }
 
 void CJoystick::Deinitialize(void)
 {
-  m_state.buttons.clear();
-  m_state.hats.clear();
-  m_state.axes.clear();
+  m_hats.clear();
 
   m_stateBuffer.buttons.clear();
   m_stateBuffer.hats.clear();
   m_stateBuffer.axes.clear();
 
+  m_stateTimes.buttons.clear();
+  m_stateTimes.hats.clear();
+  m_stateTimes.axes.clear();
+
   for (std::vector<IJoystickAxisFilter*>::iterator it = m_axisFilters.begin(); it != m_axisFilters.end(); ++it)
     delete *it;
   m_axisFilters.clear();
+
+  m_history.Deinitialize();
 }
 
-bool CJoystick::GetEvents(std::vector<ADDON::PeripheralEvent>& events)
+bool CJoystick::ScanState(void)
 {
-  if (ScanEvents())
+  if (m_stateArena == nullptr)
+    return false;
+
+  m_trace.BeginPoll();
+
+  CMetricTimer timer(METRIC_SCAN_EVENTS);
+
+  // Backends that know the hardware's timestamps override this per event
+  m_eventTimeNs = GetEventTime();
+  const bool bScanned = ScanEvents();
+  m_eventTimeNs = -1;
+
+  if (!bScanned)
+    return false;
+
+  // Publish the buttons and axes for the arena's diff
+  uint32_t* buttonWords = m_stateArena->CurrentButtons(m_stateSlot);
+  std::fill(buttonWords, buttonWords + m_stateSlot.buttonWordCount, 0);
+  for (unsigned int i = 0; i < m_stateBuffer.buttons.size(); i++)
   {
-    GetButtonEvents(events);
-    GetHatEvents(events);
-    GetAxisEvents(events);
+    if (m_stateBuffer.buttons[i] == JOYSTICK_STATE_BUTTON_PRESSED)
+      buttonWords[i / 32] |= 1u << (i % 32);
+  }
 
-    UpdateTimers();
+  std::copy(m_stateBuffer.axes.begin(), m_stateBuffer.axes.end(), m_stateArena->CurrentAxes(m_stateSlot));
 
-    return true;
+  if (m_bStateChanged)
+  {
+    m_stateSequence++;
+    m_bStateChanged = false;
   }
 
-  return false;
+  return true;
+}
+
+void CJoystick::GetEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs)
+{
+  CMetricTimer timer(METRIC_EMIT_EVENTS);
+
+  const size_t begin = events.size();
+
+  GetButtonEvents(events, eventTimesNs);
+  GetHatEvents(events, eventTimesNs);
+  GetAxisEvents(events, eventTimesNs);
+
+  SortEvents(events, eventTimesNs, begin);
+
+  // Snapshot the state as of the poll's latest event
+  if (events.size() > begin)
+    m_history.Record(eventTimesNs.back(), m_stateBuffer.buttons, m_stateBuffer.hats, m_stateBuffer.axes);
+
+  UpdateTimers();
 }
 
 bool CJoystick::SendEvent(const ADDON::PeripheralEvent& event)
@@ -155,43 +214,124 @@ std::vector<CAnomalousTrigger*> CJoystick::GetAnomalousTriggers()
   return result;
 }
 
-void CJoystick::GetButtonEvents(std::vector<ADDON::PeripheralEvent>& events)
+bool CJoystick::DumpInputTrace(const std::string& path) const
+{
+  return m_trace.Dump(path, Provider(), Name());
+}
+
+size_t CJoystick::StateRecordSize(void) const
 {
-  const std::vector<JOYSTICK_STATE_BUTTON>& buttons = m_stateBuffer.buttons;
+  const size_t size = sizeof(JoystickStateRecord) +
+                      m_stateBuffer.axes.size() * sizeof(float) +
+                      m_stateBuffer.buttons.size() +
+                      m_hats.size();
 
-  for (unsigned int i = 0; i < buttons.size(); i++)
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+void CJoystick::CopyState(uint8_t* record) const
+{
+  const unsigned int axisCount = static_cast<unsigned int>(m_stateBuffer.axes.size());
+  const unsigned int buttonCount = static_cast<unsigned int>(m_stateBuffer.buttons.size());
+
+  JoystickStateRecord* header = reinterpret_cast<JoystickStateRecord*>(record);
+  header->recordSize      = static_cast<uint32_t>(StateRecordSize());
+  header->peripheralIndex = Index();
+  header->sequence        = m_stateSequence;
+  header->axisCount       = static_cast<uint16_t>(axisCount);
+  header->buttonCount     = static_cast<uint16_t>(buttonCount);
+  header->hatCount        = static_cast<uint16_t>(m_hats.size());
+  header->reserved        = 0;
+
+  uint8_t* data = record + sizeof(JoystickStateRecord);
+  uint8_t* const end = record + header->recordSize;
+
+  if (m_stateArena == nullptr)
   {
-    if (buttons[i] != m_state.buttons[i])
-      events.push_back(ADDON::PeripheralEvent(Index(), i, buttons[i]));
+    // Not polled yet, so the state is still the initial state
+    std::fill(data, end, 0);
+    return;
   }
 
-  m_state.buttons.assign(buttons.begin(), buttons.end());
+  if (axisCount > 0)
+    memcpy(data, m_stateArena->PreviousAxes(m_stateSlot), axisCount * sizeof(float));
+  data += axisCount * sizeof(float);
+
+  const uint32_t* buttonWords = m_stateArena->PreviousButtons(m_stateSlot);
+  for (unsigned int i = 0; i < buttonCount; i++)
+    *data++ = static_cast<uint8_t>((buttonWords[i / 32] >> (i % 32)) & 1 ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED);
+
+  for (JOYSTICK_STATE_HAT hat : m_hats)
+    *data++ = static_cast<uint8_t>(hat);
+
+  // Zero the padding
+  std::fill(data, end, 0);
+}
+
+void CJoystick::GetButtonEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs)
+{
+  const uint32_t* changes = m_stateArena->ButtonChanges(m_stateSlot);
+  const uint32_t* buttonWords = m_stateArena->CurrentButtons(m_stateSlot);
+
+  // Only visit the buttons whose bits differ
+  for (unsigned int word = 0; word < m_stateSlot.buttonWordCount; word++)
+  {
+    uint32_t changed = changes[word];
+    for (unsigned int bit = 0; changed != 0; bit++, changed >>= 1)
+    {
+      if (changed & 1)
+      {
+        const unsigned int i = word * 32 + bit;
+        const JOYSTICK_STATE_BUTTON state = (buttonWords[word] >> bit) & 1 ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED;
+
+        events.push_back(ADDON::PeripheralEvent(Index(), i, state));
+        eventTimesNs.push_back(m_stateTimes.buttons[i]);
+        m_trace.Record(INPUT_TRACE_EMIT_BUTTON, i, state);
+      }
+    }
+  }
 }
 
-void CJoystick::GetHatEvents(std::vector<ADDON::PeripheralEvent>& events)
+void CJoystick::GetHatEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs)
 {
   const std::vector<JOYSTICK_STATE_HAT>& hats = m_stateBuffer.hats;
 
   for (unsigned int i = 0; i < hats.size(); i++)
   {
-    if (hats[i] != m_state.hats[i])
+    if (hats[i] != m_hats[i])
+    {
       events.push_back(ADDON::PeripheralEvent(Index(), i, hats[i]));
+      eventTimesNs.push_back(m_stateTimes.hats[i]);
+      m_trace.Record(INPUT_TRACE_EMIT_HAT, i, hats[i]);
+    }
   }
 
-  m_state.hats.assign(hats.begin(), hats.end());
+  m_hats.assign(hats.begin(), hats.end());
 }
 
-void CJoystick::GetAxisEvents(std::vector<ADDON::PeripheralEvent>& events)
+void CJoystick::GetAxisEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs)
 {
-  const std::vector<JOYSTICK_STATE_AXIS>& axes = m_stateBuffer.axes;
+  const uint8_t* masks = m_stateArena->AxisMasks(m_stateSlot);
+  const float* axes = m_stateArena->CurrentAxes(m_stateSlot);
+  const float* previousAxes = m_stateArena->PreviousAxes(m_stateSlot);
 
-  for (unsigned int i = 0; i < axes.size(); i++)
+  // Only visit the axes that are or were off-center
+  for (unsigned int block = 0; block * CJoystickStateArena::LANES < m_stateSlot.axisCount; block++)
   {
-    if (axes[i] != 0.0f || m_state.axes[i] != 0.0f)
-      events.push_back(ADDON::PeripheralEvent(Index(), i, axes[i]));
+    uint8_t active = masks[block];
+    for (unsigned int i = block * CJoystickStateArena::LANES; active != 0; i++, active >>= 1)
+    {
+      if (active & 1)
+      {
+        events.push_back(ADDON::PeripheralEvent(Index(), i, axes[i]));
+        eventTimesNs.push_back(m_stateTimes.axes[i]);
+
+        // Held axes are re-emitted every poll, only trace the changes
+        if (axes[i] != previousAxes[i])
+          m_trace.Record(INPUT_TRACE_EMIT_AXIS, i, axes[i]);
+      }
+    }
   }
-
-  m_state.axes.assign(axes.begin(), axes.end());
 }
 
 void CJoystick::SetButtonValue(unsigned int buttonIndex, JOYSTICK_STATE_BUTTON buttonValue)
@@ -200,7 +340,15 @@ void CJoystick::SetButtonValue(unsigned int buttonIndex, JOYSTICK_STATE_BUTTON b
     m_activateTimeMs = P8PLATFORM::GetTimeMs();
 
   if (buttonIndex < m_stateBuffer.buttons.size())
+  {
+    if (m_stateBuffer.buttons[buttonIndex] != buttonValue)
+    {
+      m_stateTimes.buttons[buttonIndex] = GetEventTime();
+      m_bStateChanged = true;
+      m_trace.Record(INPUT_TRACE_BUTTON, buttonIndex, buttonValue);
+    }
     m_stateBuffer.buttons[buttonIndex] = buttonValue;
+  }
 }
 
 void CJoystick::SetHatValue(unsigned int hatIndex, JOYSTICK_STATE_HAT hatValue)
@@ -209,7 +357,15 @@ void CJoystick::SetHatValue(unsigned int hatIndex, JOYSTICK_STATE_HAT hatValue)
     m_activateTimeMs = P8PLATFORM::GetTimeMs();
 
   if (hatIndex < m_stateBuffer.hats.size())
+  {
+    if (m_stateBuffer.hats[hatIndex] != hatValue)
+    {
+      m_stateTimes.hats[hatIndex] = GetEventTime();
+      m_bStateChanged = true;
+      m_trace.Record(INPUT_TRACE_HAT, hatIndex, hatValue);
+    }
     m_stateBuffer.hats[hatIndex] = hatValue;
+  }
 }
 
 void CJoystick::SetAxisValue(unsigned int axisIndex, JOYSTICK_STATE_AXIS axisValue)
@@ -220,7 +376,16 @@ void CJoystick::SetAxisValue(unsigned int axisIndex, JOYSTICK_STATE_AXIS axisVal
   axisValue = CONSTRAIN(-1.0f, axisValue, 1.0f);
 
   if (axisIndex < m_stateBuffer.axes.size())
-    m_stateBuffer.axes[axisIndex] = m_axisFilters[axisIndex]->Filter(axisValue);
+  {
+    axisValue = m_axisFilters[axisIndex]->Filter(axisValue);
+    if (m_stateBuffer.axes[axisIndex] != axisValue)
+    {
+      m_stateTimes.axes[axisIndex] = GetEventTime();
+      m_bStateChanged = true;
+      m_trace.Record(INPUT_TRACE_AXIS, axisIndex, axisValue);
+    }
+    m_stateBuffer.axes[axisIndex] = axisValue;
+  }
 }
 
 void CJoystick::SetAxisValue(unsigned int axisIndex, long value, long maxAxisAmount)
@@ -231,6 +396,28 @@ void CJoystick::SetAxisValue(unsigned int axisIndex, long value, long maxAxisAmo
     SetAxisValue(axisIndex, 0.0f);
 }
 
+int64_t CJoystick::GetEventTime(void) const
+{
+  if (m_eventTimeNs >= 0)
+    return m_eventTimeNs;
+
+  // Values can be set outside of a scan by asynchronous backends
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CJoystick::SortEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs, size_t begin)
+{
+  // Insertion sort, a poll emits a handful of events that are mostly in order
+  for (size_t i = begin + 1; i < events.size(); i++)
+  {
+    for (size_t j = i; j > begin && eventTimesNs[j - 1] > eventTimesNs[j]; j--)
+    {
+      std::swap(events[j - 1], events[j]);
+      std::swap(eventTimesNs[j - 1], eventTimesNs[j]);
+    }
+  }
+}
+
 void CJoystick::UpdateTimers(void)
 {
   if (m_firstEventTimeMs < 0)
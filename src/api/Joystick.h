@@ -18,8 +18,14 @@
  */
 #pragma once
 
+#include "InputHistory.h"
+#include "InputTrace.h"
+#include "JoystickStateArena.h"
+#include "buttonmapper/ButtonMapTypes.h"
+
 #include "kodi_peripheral_utils.hpp"
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -76,10 +82,32 @@ namespace JOYSTICK
      */
     virtual void Deinitialize(void);
 
+    /*!
+     * Scan for events and publish the joystick's buttons and axes to its
+     * slot in the state arena. Returns false if the joystick wasn't scanned.
+     */
+    virtual bool ScanState(void);
+
     /*!
      * Get events that have occurred since the last call to GetEvents()
+     *
+     * Called after ScanState() succeeded and the state arena was diffed. The
+     * time of each event, in nanoseconds of the monotonic clock, is appended
+     * to eventTimesNs. The appended events are in time order.
+     *
+     * Also called without a scan for polled joysticks with no input, whose
+     * published state is unchanged, so that held axes keep being reported.
+     */
+    virtual void GetEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs);
+
+    /*!
+     * Give the joystick its lanes in the state arena. Called by the arena
+     * when it's laid out.
      */
-    virtual bool GetEvents(std::vector<ADDON::PeripheralEvent>& events);
+    void BindStateArena(CJoystickStateArena* arena, const JoystickStateSlot& slot) { m_stateArena = arena; m_stateSlot = slot; }
+    void UnbindStateArena(void) { m_stateArena = nullptr; }
+    bool HasStateSlot(void) const { return m_stateArena != nullptr; }
+    const JoystickStateSlot& StateSlot(void) const { return m_stateSlot; }
 
     /*!
      * Send an event to a joystick
@@ -96,8 +124,71 @@ namespace JOYSTICK
      */
     virtual void PowerOff() { }
 
+    /*!
+     * Set the driver primitives that the user has chosen to ignore. Backends
+     * can use this to stop the driver from reporting them.
+     */
+    virtual void SetIgnoredPrimitives(const PrimitiveVector& primitives) { }
+
+    /*!
+     * Set the noise filter (fuzz) and dead zone (flat) of an axis, in driver
+     * units. Backends that support it apply these in the driver instead of
+     * learning them.
+     */
+    virtual void SetAxisCalibration(unsigned int axisIndex, unsigned int fuzz, unsigned int flat) { }
+
+    /*!
+     * Grab the device so that other programs (and other drivers of the same
+     * device) stop receiving its input. Returns false if the backend can't.
+     */
+    virtual bool SetExclusiveGrab(bool bExclusive) { return false; }
+
+    /*!
+     * Get the fds that become readable when the joystick has input. Joysticks
+     * without fds are scanned on every call to GetEvents().
+     */
+    virtual void GetInputFds(std::vector<int>& fds) const { }
+
     std::vector<CAnomalousTrigger*> GetAnomalousTriggers();
 
+    /*!
+     * \brief Write the recent input trace to a file
+     *
+     * NOTE: Must not be called concurrently with GetEvents()
+     */
+    bool DumpInputTrace(const std::string& path) const;
+
+    /*!
+     * \brief Get the timestamped history of the joystick's state
+     *
+     * NOTE: Must not be called concurrently with GetEvents(). Outside the
+     *       input thread, use CJoystickManager::GetInputHistoryState() or
+     *       GetInputHistoryChanges(), which take the joystick lock.
+     */
+    const CInputHistory& InputHistory(void) const { return m_history; }
+
+    /*!
+     * \brief Sequence number of the state returned by the last GetEvents(),
+     *        incremented when a scan changes it
+     */
+    uint64_t StateSequence(void) const { return m_stateSequence; }
+
+    /*!
+     * \brief Bytes needed by CopyState()
+     */
+    size_t StateRecordSize(void) const;
+
+    /*!
+     * \brief Write the state returned by the last GetEvents() as a
+     *        JoystickStateRecord
+     *
+     * \param record Buffer of at least StateRecordSize() bytes, aligned for
+     *        JoystickStateRecord
+     *
+     * NOTE: Must not be called concurrently with GetEvents()
+     */
+    void CopyState(uint8_t* record) const;
+
   protected:
     /*!
      * Implemented by derived class to scan for events
@@ -111,10 +202,35 @@ namespace JOYSTICK
     virtual void SetAxisValue(unsigned int axisIndex, JOYSTICK_STATE_AXIS axisValue);
     void SetAxisValue(unsigned int axisIndex, long value, long maxAxisAmount);
 
+    /*!
+     * \brief Set the time of the values set next, in nanoseconds of the
+     *        monotonic clock
+     *
+     * Backends that know when the hardware reported an event call this before
+     * setting its value. Otherwise, values are stamped with the time of the
+     * scan.
+     */
+    void SetEventTime(int64_t timeNs) { m_eventTimeNs = timeNs; }
+
+    /*!
+     * \brief Get the time that values set now are stamped with
+     */
+    int64_t GetEventTime(void) const;
+
+    /*!
+     * \brief Record a raw backend event in the input trace
+     */
+    void TraceRawEvent(unsigned int type, unsigned int code, int value) { m_trace.RecordRaw(type, code, value); }
+
   private:
-    void GetButtonEvents(std::vector<ADDON::PeripheralEvent>& events);
-    void GetHatEvents(std::vector<ADDON::PeripheralEvent>& events);
-    void GetAxisEvents(std::vector<ADDON::PeripheralEvent>& events);
+    void GetButtonEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs);
+    void GetHatEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs);
+    void GetAxisEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs);
+
+    /*!
+     * \brief Sort events appended by this joystick by time
+     */
+    static void SortEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs, size_t begin);
 
     void UpdateTimers(void);
 
@@ -131,12 +247,30 @@ namespace JOYSTICK
       std::vector<JOYSTICK_STATE_AXIS>   axes;
     };
 
-    JoystickState                     m_state;
+    /*!
+     * \brief Time that each value in the state buffer last changed
+     */
+    struct JoystickStateTimes
+    {
+      std::vector<int64_t> buttons;
+      std::vector<int64_t> hats;
+      std::vector<int64_t> axes;
+    };
+
     JoystickState                     m_stateBuffer;
+    std::vector<JOYSTICK_STATE_HAT>   m_hats;        // Hats returned by the last GetEvents()
+    CJoystickStateArena*              m_stateArena;  // Buttons and axes as published and as returned by the last GetEvents()
+    JoystickStateSlot                 m_stateSlot;
+    JoystickStateTimes                m_stateTimes;
+    int64_t                           m_eventTimeNs; // Time of values being set, or -1 to use the current time
+    bool                              m_bStateChanged; // A value in the state buffer changed since the last poll
+    uint64_t                          m_stateSequence;
     std::vector<IJoystickAxisFilter*> m_axisFilters;
     int64_t                           m_discoverTimeMs;
     int64_t                           m_activateTimeMs;
     int64_t                           m_firstEventTimeMs;
     int64_t                           m_lastEventTimeMs;
+    CInputTrace                       m_trace;
+    CInputHistory                     m_history;
   };
 }
@@ -21,6 +21,7 @@
 #include "JoystickManager.h"
 #include "IJoystickInterface.h"
 #include "Joystick.h"
+#include "JoystickState.h"
 
 #if defined(HAVE_DIRECT_INPUT)
   #include "directinput/JoystickInterfaceDirectInput.h"
@@ -37,15 +38,30 @@
 #if defined(HAVE_UDEV)
   #include "udev/JoystickInterfaceUdev.h"
 #endif
+#if defined(HAVE_HIDRAW)
+  #include "hidraw/JoystickInterfaceHidraw.h"
+#endif
+#if defined(HAVE_IO_URING)
+  #include "poller/InputPollerIoUring.h"
+#endif
+#if defined(HAVE_EPOLL)
+  #include "poller/InputPollerEpoll.h"
+#endif
 
 #include "log/Log.h"
+#include "metrics/Metrics.h"
+#include "metrics/Tracer.h"
 #include "utils/CommonMacros.h"
 
 #include <algorithm>
+#include <sstream>
 
 using namespace JOYSTICK;
 using namespace P8PLATFORM;
 
+#define INPUT_TRACE_FILE_PREFIX     "input_trace_"
+#define INPUT_TRACE_FILE_EXTENSION  ".bin"
+
 // --- Utility functions -------------------------------------------------------
 
 namespace JOYSTICK
@@ -86,7 +102,12 @@ namespace JOYSTICK
 
 CJoystickManager::CJoystickManager(void)
   : m_scanner(NULL),
-    m_nextJoystickIndex(0)
+    m_poller(NULL),
+    m_nextJoystickIndex(0),
+    m_bExclusiveGrab(false),
+    m_stateSequence(1),
+    m_interfacesMutex("JoystickManager::interfaces"),
+    m_joystickMutex("JoystickManager::joysticks")
 {
 }
 
@@ -98,30 +119,42 @@ CJoystickManager& CJoystickManager::Get(void)
 
 bool CJoystickManager::Initialize(IScannerCallback* scanner)
 {
-  CLockObject lock(m_interfacesMutex);
-
-  m_scanner = scanner;
+  std::vector<IJoystickInterface*> interfaces;
 
   // Windows
 #if defined(HAVE_DIRECT_INPUT)
-  m_interfaces.push_back(new CJoystickInterfaceDirectInput);
+  interfaces.push_back(new CJoystickInterfaceDirectInput);
 #endif
 #if defined(HAVE_XINPUT)
-  m_interfaces.push_back(new CJoystickInterfaceXInput);
+  interfaces.push_back(new CJoystickInterfaceXInput);
 #endif
 
   // Linux
 #if defined(HAVE_LINUX_JOYSTICK)
-  m_interfaces.push_back(new CJoystickInterfaceLinux);
+  interfaces.push_back(new CJoystickInterfaceLinux);
 #elif defined(HAVE_UDEV)
-  m_interfaces.push_back(new CJoystickInterfaceUdev);
+  #if defined(HAVE_HIDRAW)
+  // Scanned first so that udev can skip the devices it opens
+  interfaces.push_back(new CJoystickInterfaceHidraw);
+  #endif
+  interfaces.push_back(new CJoystickInterfaceUdev);
 #endif
 
   // OSX
 #if defined(HAVE_COCOA)
-  m_interfaces.push_back(new CJoystickInterfaceCocoa);
+  interfaces.push_back(new CJoystickInterfaceCocoa);
 #endif
 
+  return Initialize(scanner, interfaces);
+}
+
+bool CJoystickManager::Initialize(IScannerCallback* scanner, const std::vector<IJoystickInterface*>& interfaces)
+{
+  CProfiledLockObject lock(m_interfacesMutex);
+
+  m_scanner = scanner;
+  m_interfaces = interfaces;
+
   if (m_interfaces.empty())
     dsyslog("No joystick APIs in use");
 
@@ -136,18 +169,57 @@ bool CJoystickManager::Initialize(IScannerCallback* scanner)
     }
   }
 
+  InitializePoller();
+
   return true;
 }
 
+void CJoystickManager::InitializePoller(void)
+{
+  CProfiledLockObject lock(m_joystickMutex);
+
+  // Prefer io_uring, then epoll, then scanning every joystick
+#if defined(HAVE_IO_URING)
+  if (m_poller == NULL)
+  {
+    m_poller = new CInputPollerIoUring;
+    if (!m_poller->Initialize())
+      safe_delete(m_poller);
+  }
+#endif
+#if defined(HAVE_EPOLL)
+  if (m_poller == NULL)
+  {
+    m_poller = new CInputPollerEpoll;
+    if (!m_poller->Initialize())
+      safe_delete(m_poller);
+  }
+#endif
+
+  if (m_poller != NULL)
+    isyslog("Polling joystick input with %s", m_poller->Name());
+}
+
 void CJoystickManager::Deinitialize(void)
 {
   {
-    CLockObject lock(m_joystickMutex);
+    CProfiledLockObject lock(m_joystickMutex);
+
+    if (m_poller != NULL)
+    {
+      for (const JoystickPtr& joystick : m_joysticks)
+        m_poller->RemoveJoystick(joystick.get());
+      m_polledJoysticks.clear();
+      safe_delete(m_poller);
+    }
+
+    m_stateArena.Clear(m_joysticks);
     m_joysticks.clear();
+    m_exclusiveJoysticks.clear();
   }
 
   {
-    CLockObject lock(m_interfacesMutex);
+    CProfiledLockObject lock(m_interfacesMutex);
     safe_delete_vector(m_interfaces);
   }
 
@@ -156,21 +228,41 @@ void CJoystickManager::Deinitialize(void)
 
 bool CJoystickManager::PerformJoystickScan(JoystickVector& joysticks)
 {
+  TRACE_SPAN("PerformJoystickScan");
+
   JoystickVector scanResults;
   {
-    CLockObject lock(m_interfacesMutex);
+    CProfiledLockObject lock(m_interfacesMutex);
     // Scan for joysticks (this can take a while, don't block)
     for (std::vector<IJoystickInterface*>::iterator itInterface = m_interfaces.begin(); itInterface != m_interfaces.end(); ++itInterface)
+    {
+      TRACE_SPAN("ScanForJoysticks");
       (*itInterface)->ScanForJoysticks(scanResults);
+    }
   }
 
-  CLockObject lock(m_joystickMutex);
+  CProfiledLockObject lock(m_joystickMutex);
+
+  bool bJoysticksChanged = false;
 
   // Unregister removed joysticks
   for (int i = (int)m_joysticks.size() - 1; i >= 0; i--)
   {
     if (std::find_if(scanResults.begin(), scanResults.end(), ScanResultEqual(m_joysticks.at(i))) == scanResults.end())
+    {
+      if (m_poller != NULL)
+      {
+        m_poller->RemoveJoystick(m_joysticks.at(i).get());
+        m_polledJoysticks.erase(m_joysticks.at(i).get());
+      }
+
+      m_exclusiveJoysticks.erase(m_joysticks.at(i).get());
+
+      m_joysticks.at(i)->UnbindStateArena();
       m_joysticks.erase(m_joysticks.begin() + i);
+      m_stateSequence++;
+      bJoysticksChanged = true;
+    }
   }
 
   // Register new joysticks
@@ -186,11 +278,23 @@ bool CJoystickManager::PerformJoystickScan(JoystickVector& joysticks)
                 (*itJoystick)->Index(), (*itJoystick)->Name().c_str(),
                 (*itJoystick)->AxisCount(), (*itJoystick)->HatCount(), (*itJoystick)->ButtonCount());
 
+        if (m_bExclusiveGrab)
+          (*itJoystick)->SetExclusiveGrab(true);
+
         m_joysticks.push_back(*itJoystick);
+        m_stateSequence++;
+        bJoysticksChanged = true;
+
+        if (m_poller != NULL && m_poller->AddJoystick(itJoystick->get()))
+          m_polledJoysticks.insert(itJoystick->get());
       }
     }
   }
 
+  // Lay out the state arena for the new set of joysticks
+  if (bJoysticksChanged)
+    m_stateArena.Rebuild(m_joysticks);
+
   joysticks = m_joysticks;
 
   // Work around bug on linux: Don't return disconnected Xbox 360 controllers
@@ -209,7 +313,7 @@ bool CJoystickManager::PerformJoystickScan(JoystickVector& joysticks)
 
 JoystickPtr CJoystickManager::GetJoystick(unsigned int index) const
 {
-  CLockObject lock(m_joystickMutex);
+  CProfiledLockObject lock(m_joystickMutex);
 
   for (JoystickVector::const_iterator it = m_joysticks.begin(); it != m_joysticks.end(); ++it)
   {
@@ -224,7 +328,7 @@ JoystickVector CJoystickManager::GetJoysticks(const ADDON::Joystick& joystickInf
 {
   JoystickVector result;
 
-  CLockObject lock(m_joystickMutex);
+  CProfiledLockObject lock(m_joystickMutex);
 
   for (const auto& joystick : m_joysticks)
   {
@@ -240,19 +344,237 @@ JoystickVector CJoystickManager::GetJoysticks(const ADDON::Joystick& joystickInf
 
 bool CJoystickManager::GetEvents(std::vector<ADDON::PeripheralEvent>& events)
 {
-  CLockObject lock(m_joystickMutex);
+  TRACE_SPAN("GetEvents");
+
+  CProfiledLockObject lock(m_joystickMutex);
+
+  bool bPolled = false;
+  if (m_poller != NULL)
+  {
+    CMetricTimer timer(METRIC_POLL_INPUT);
+    bPolled = m_poller->Poll(m_readyJoysticks);
+  }
+
+  m_eventBuffer.clear();
+  m_eventTimes.clear();
+  m_eventStreams.clear();
+
+  m_emitJoysticks.clear();
 
+  bool bStateChanged = false;
+
+  // Publish the state of each joystick with input to the arena
   for (JoystickVector::iterator it = m_joysticks.begin(); it != m_joysticks.end(); ++it)
-    (*it)->GetEvents(events);
+  {
+    // Don't scan joysticks whose fds have no input to read. Their published
+    // state is unchanged, but held axes are still reported.
+    if (bPolled && m_polledJoysticks.find(it->get()) != m_polledJoysticks.end() &&
+        !std::binary_search(m_readyJoysticks.begin(), m_readyJoysticks.end(), it->get()))
+    {
+      if ((*it)->HasStateSlot())
+        m_emitJoysticks.push_back(it->get());
+      continue;
+    }
+
+    const uint64_t stateSequence = (*it)->StateSequence();
+
+    if ((*it)->ScanState())
+      m_emitJoysticks.push_back(it->get());
+
+    if ((*it)->StateSequence() != stateSequence)
+      bStateChanged = true;
+  }
+
+  // Find the changes of all joysticks in one pass
+  {
+    CMetricTimer timer(METRIC_DIFF_STATES);
+    m_stateArena.Diff();
+  }
+
+  for (CJoystick* joystick : m_emitJoysticks)
+  {
+    const size_t begin = m_eventBuffer.size();
+
+    joystick->GetEvents(m_eventBuffer, m_eventTimes);
+
+    if (m_eventBuffer.size() > begin)
+    {
+      EventStream stream = { m_eventTimes[begin], begin, m_eventBuffer.size(), static_cast<unsigned int>(m_eventStreams.size()) };
+      m_eventStreams.push_back(stream);
+    }
+  }
+
+  m_stateArena.Commit();
+
+  MergeEventStreams(events);
+
+  if (bStateChanged)
+    m_stateSequence++;
 
   return true;
 }
 
+bool CJoystickManager::GetJoystickState(unsigned int index, uint64_t& sequence, void* buffer, size_t& size) const
+{
+  CProfiledLockObject lock(m_joystickMutex);
+
+  for (const JoystickPtr& joystick : m_joysticks)
+  {
+    if (joystick->Index() != index)
+      continue;
+
+    if (joystick->StateSequence() == sequence)
+    {
+      size = 0;
+      return true;
+    }
+
+    const size_t recordSize = joystick->StateRecordSize();
+    if (buffer == NULL || size < recordSize)
+    {
+      size = recordSize;
+      return false;
+    }
+
+    joystick->CopyState(static_cast<uint8_t*>(buffer));
+
+    sequence = joystick->StateSequence();
+    size = recordSize;
+    return true;
+  }
+
+  return false;
+}
+
+bool CJoystickManager::GetJoystickStates(uint64_t& sequence, void* buffer, size_t& size) const
+{
+  CProfiledLockObject lock(m_joystickMutex);
+
+  if (m_stateSequence == sequence)
+  {
+    size = 0;
+    return true;
+  }
+
+  size_t totalSize = 0;
+  for (const JoystickPtr& joystick : m_joysticks)
+    totalSize += joystick->StateRecordSize();
+
+  if ((buffer == NULL && totalSize > 0) || size < totalSize)
+  {
+    size = totalSize;
+    return false;
+  }
+
+  uint8_t* record = static_cast<uint8_t*>(buffer);
+  for (const JoystickPtr& joystick : m_joysticks)
+  {
+    joystick->CopyState(record);
+    record += joystick->StateRecordSize();
+  }
+
+  sequence = m_stateSequence;
+  size = totalSize;
+  return true;
+}
+
+bool CJoystickManager::GetInputHistoryState(unsigned int index, int64_t timeNs,
+                                            std::vector<JOYSTICK_STATE_BUTTON>& buttons,
+                                            std::vector<JOYSTICK_STATE_HAT>& hats,
+                                            std::vector<JOYSTICK_STATE_AXIS>& axes) const
+{
+  // The history is written by GetEvents(), which holds the same lock. The
+  // snapshot is copied because it's only valid until the next write.
+  CProfiledLockObject lock(m_joystickMutex);
+
+  for (const JoystickPtr& joystick : m_joysticks)
+  {
+    if (joystick->Index() != index)
+      continue;
+
+    const CInputHistorySnapshot snapshot = joystick->InputHistory().GetState(timeNs);
+    if (!snapshot.IsValid())
+      return false;
+
+    buttons.resize(joystick->ButtonCount());
+    for (unsigned int i = 0; i < buttons.size(); i++)
+      buttons[i] = snapshot.Button(i);
+
+    hats.resize(joystick->HatCount());
+    for (unsigned int i = 0; i < hats.size(); i++)
+      hats[i] = snapshot.Hat(i);
+
+    axes.resize(joystick->AxisCount());
+    for (unsigned int i = 0; i < axes.size(); i++)
+      axes[i] = snapshot.Axis(i);
+
+    return true;
+  }
+
+  return false;
+}
+
+bool CJoystickManager::GetInputHistoryChanges(unsigned int index, int64_t fromNs, int64_t toNs,
+                                              std::vector<ADDON::PeripheralEvent>& events,
+                                              std::vector<int64_t>& eventTimesNs) const
+{
+  // The history is written by GetEvents(), which holds the same lock
+  CProfiledLockObject lock(m_joystickMutex);
+
+  for (const JoystickPtr& joystick : m_joysticks)
+  {
+    if (joystick->Index() == index)
+      return joystick->InputHistory().GetChanges(fromNs, toNs, index, events, eventTimesNs);
+  }
+
+  return false;
+}
+
+bool CJoystickManager::IsLaterStream(const EventStream& lhs, const EventStream& rhs)
+{
+  if (lhs.timeNs != rhs.timeNs)
+    return lhs.timeNs > rhs.timeNs;
+  return lhs.streamIndex > rhs.streamIndex;
+}
+
+void CJoystickManager::MergeEventStreams(std::vector<ADDON::PeripheralEvent>& events)
+{
+  events.reserve(events.size() + m_eventBuffer.size());
+
+  // A single stream is already in order
+  if (m_eventStreams.size() <= 1)
+  {
+    events.insert(events.end(), m_eventBuffer.begin(), m_eventBuffer.end());
+    return;
+  }
+
+  // K-way merge, popping the earliest event of the joysticks that have events
+  std::make_heap(m_eventStreams.begin(), m_eventStreams.end(), IsLaterStream);
+
+  while (!m_eventStreams.empty())
+  {
+    std::pop_heap(m_eventStreams.begin(), m_eventStreams.end(), IsLaterStream);
+
+    EventStream& stream = m_eventStreams.back();
+    events.push_back(m_eventBuffer[stream.next]);
+
+    if (++stream.next < stream.end)
+    {
+      stream.timeNs = m_eventTimes[stream.next];
+      std::push_heap(m_eventStreams.begin(), m_eventStreams.end(), IsLaterStream);
+    }
+    else
+    {
+      m_eventStreams.pop_back();
+    }
+  }
+}
+
 bool CJoystickManager::SendEvent(const ADDON::PeripheralEvent& event)
 {
   bool bHandled = false;
 
-  CLockObject lock(m_joystickMutex);
+  CProfiledLockObject lock(m_joystickMutex);
 
   for (const JoystickPtr& joystick : m_joysticks)
   {
@@ -269,12 +591,78 @@ bool CJoystickManager::SendEvent(const ADDON::PeripheralEvent& event)
 
 void CJoystickManager::ProcessEvents()
 {
-  CLockObject lock(m_joystickMutex);
+  CProfiledLockObject lock(m_joystickMutex);
 
   for (const JoystickPtr& joystick : m_joysticks)
     joystick->ProcessEvents();
 }
 
+void CJoystickManager::SetIgnoredPrimitives(const ADDON::Joystick& joystickInfo, const PrimitiveVector& primitives)
+{
+  for (const JoystickPtr& joystick : GetJoysticks(joystickInfo))
+    joystick->SetIgnoredPrimitives(primitives);
+}
+
+void CJoystickManager::SetAxisCalibration(const ADDON::Joystick& joystickInfo, unsigned int axisIndex, unsigned int fuzz, unsigned int flat)
+{
+  for (const JoystickPtr& joystick : GetJoysticks(joystickInfo))
+    joystick->SetAxisCalibration(axisIndex, fuzz, flat);
+}
+
+void CJoystickManager::SetExclusiveGrab(bool bExclusive)
+{
+  CProfiledLockObject lock(m_joystickMutex);
+
+  if (bExclusive == m_bExclusiveGrab)
+    return;
+
+  m_bExclusiveGrab = bExclusive;
+
+  for (const JoystickPtr& joystick : m_joysticks)
+    joystick->SetExclusiveGrab(bExclusive || m_exclusiveJoysticks.find(joystick.get()) != m_exclusiveJoysticks.end());
+}
+
+void CJoystickManager::SetExclusiveGrab(const ADDON::Joystick& joystickInfo, bool bExclusive)
+{
+  CProfiledLockObject lock(m_joystickMutex);
+
+  for (const JoystickPtr& joystick : GetJoysticks(joystickInfo))
+  {
+    if (bExclusive)
+      m_exclusiveJoysticks.insert(joystick.get());
+    else
+      m_exclusiveJoysticks.erase(joystick.get());
+
+    joystick->SetExclusiveGrab(m_bExclusiveGrab || bExclusive);
+  }
+}
+
+bool CJoystickManager::DumpInputTraces(const std::string& directory)
+{
+  bool bSuccess = true;
+
+  // Traces are written by GetEvents(), which holds the same lock
+  CProfiledLockObject lock(m_joystickMutex);
+
+  for (const JoystickPtr& joystick : m_joysticks)
+  {
+    std::ostringstream path;
+    path << directory << "/" << INPUT_TRACE_FILE_PREFIX << joystick->Index() << INPUT_TRACE_FILE_EXTENSION;
+
+    if (joystick->DumpInputTrace(path.str()))
+    {
+      isyslog("Wrote input trace for \"%s\" to %s", joystick->Name().c_str(), path.str().c_str());
+    }
+    else
+    {
+      esyslog("Failed to write input trace for \"%s\" to %s", joystick->Name().c_str(), path.str().c_str());
+      bSuccess = false;
+    }
+  }
+
+  return bSuccess;
+}
+
 void CJoystickManager::TriggerScan(void)
 {
   if (m_scanner)
@@ -285,7 +673,7 @@ const ButtonMap& CJoystickManager::GetButtonMap(const std::string& provider)
 {
   static ButtonMap empty;
 
-  CLockObject lock(m_interfacesMutex);
+  CProfiledLockObject lock(m_interfacesMutex);
 
   // Scan for joysticks (this can take a while, don't block)
   for (std::vector<IJoystickInterface*>::iterator itInterface = m_interfaces.begin(); itInterface != m_interfaces.end(); ++itInterface)
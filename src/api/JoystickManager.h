@@ -19,16 +19,21 @@
  */
 #pragma once
 
+#include "JoystickStateArena.h"
 #include "JoystickTypes.h"
 #include "buttonmapper/ButtonMapTypes.h"
+#include "metrics/LockProfiler.h"
 
 #include "kodi_peripheral_utils.hpp"
 #include "p8-platform/threads/mutex.h"
 
+#include <set>
+#include <stdint.h>
 #include <vector>
 
 namespace JOYSTICK
 {
+  class IInputPoller;
   class IJoystickInterface;
 
   class IScannerCallback
@@ -58,6 +63,17 @@ namespace JOYSTICK
      */
     bool Initialize(IScannerCallback* scanner);
 
+    /*!
+     * \brief Initialize the joystick manager with the given interfaces
+     *        instead of the platform's
+     *
+     * Used by the tests and benchmarks to scan synthetic joysticks.
+     *
+     * \param scanner The callback used to trigger a scan
+     * \param interfaces The interfaces, owned by the manager after the call
+     */
+    bool Initialize(IScannerCallback* scanner, const std::vector<IJoystickInterface*>& interfaces);
+
     /*!
      * \brief Deinitialize the joystick manager
      */
@@ -78,9 +94,76 @@ namespace JOYSTICK
 
     /*!
     * \brief Get all events that have occurred since the last call to GetEvents()
+    *
+    * Events from all joysticks are returned in the order they occurred.
     */
     bool GetEvents(std::vector<ADDON::PeripheralEvent>& events);
 
+    /*!
+     * \brief Copy the current state of a joystick into a flat buffer
+     *
+     * The state is written as a JoystickStateRecord.
+     *
+     * \param index The joystick's peripheral index
+     * \param sequence The sequence number of the caller's copy of the state.
+     *        Set to the copied state's sequence number.
+     * \param buffer The buffer, aligned to 8 bytes
+     * \param size The buffer's size in bytes. Set to the bytes copied, or 0 if
+     *        the caller's state is current, or to the bytes needed if the
+     *        buffer is too small.
+     *
+     * \return false if the joystick doesn't exist or the buffer is too small
+     */
+    bool GetJoystickState(unsigned int index, uint64_t& sequence, void* buffer, size_t& size) const;
+
+    /*!
+     * \brief Copy the current state of all joysticks into a flat buffer
+     *
+     * The states are written as consecutive JoystickStateRecords.
+     *
+     * \param sequence The sequence number of the caller's copy of the states.
+     *        Set to the copied states' sequence number, which changes when any
+     *        joystick's state changes or a joystick is added or removed.
+     * \param buffer The buffer, aligned to 8 bytes
+     * \param size The buffer's size in bytes. Set to the bytes copied, or 0 if
+     *        the caller's states are current, or to the bytes needed if the
+     *        buffer is too small.
+     *
+     * \return false if the buffer is too small
+     */
+    bool GetJoystickStates(uint64_t& sequence, void* buffer, size_t& size) const;
+
+    /*!
+     * \brief Get the state a joystick was in at a time, from its input history
+     *
+     * \param index The joystick's peripheral index
+     * \param timeNs The time, in nanoseconds of the monotonic clock
+     * \param buttons, hats, axes (out) The state, with axes quantized to 16 bits
+     *
+     * \return false if the joystick doesn't exist or keeps no history, or the
+     *         time is older than its history
+     */
+    bool GetInputHistoryState(unsigned int index, int64_t timeNs,
+                              std::vector<JOYSTICK_STATE_BUTTON>& buttons,
+                              std::vector<JOYSTICK_STATE_HAT>& hats,
+                              std::vector<JOYSTICK_STATE_AXIS>& axes) const;
+
+    /*!
+     * \brief Get the changes in a joystick's state after fromNs, up to and
+     *        including toNs, from its input history
+     *
+     * \param index The joystick's peripheral index
+     * \param events (out) The changes as driver events, appended in time order
+     * \param eventTimesNs (out) The time of each event
+     *
+     * \return false if the joystick doesn't exist or keeps no history, or
+     *         fromNs is older than its history, in which case the changes
+     *         start at the oldest snapshot
+     */
+    bool GetInputHistoryChanges(unsigned int index, int64_t fromNs, int64_t toNs,
+                                std::vector<ADDON::PeripheralEvent>& events,
+                                std::vector<int64_t>& eventTimesNs) const;
+
     /*!
      * \brief Send an event to a joystick
      *
@@ -95,6 +178,47 @@ namespace JOYSTICK
      */
     void ProcessEvents();
 
+    /*!
+     * \brief Pass the ignored driver primitives to all matching joysticks
+     *
+     * \param joystickInfo The joystick properties used to match joysticks
+     * \param primitives The driver primitives being ignored
+     */
+    void SetIgnoredPrimitives(const ADDON::Joystick& joystickInfo, const PrimitiveVector& primitives);
+
+    /*!
+     * \brief Pass a stored axis calibration to all matching joysticks
+     *
+     * \param joystickInfo The joystick properties used to match joysticks
+     * \param axisIndex The index of the axis
+     * \param fuzz The noise filter, in driver units
+     * \param flat The dead zone, in driver units
+     */
+    void SetAxisCalibration(const ADDON::Joystick& joystickInfo, unsigned int axisIndex, unsigned int fuzz, unsigned int flat);
+
+    /*!
+     * \brief Grab or release all joysticks, and set whether new joysticks are
+     *        grabbed when they're opened
+     *
+     * Joysticks configured for exclusive grab stay grabbed.
+     */
+    void SetExclusiveGrab(bool bExclusive);
+
+    /*!
+     * \brief Set whether a device's configuration grabs it, even if the
+     *        setting is off
+     *
+     * \param joystickInfo The joystick properties used to match joysticks
+     */
+    void SetExclusiveGrab(const ADDON::Joystick& joystickInfo, bool bExclusive);
+
+    /*!
+     * \brief Write the input trace of each joystick to the given directory
+     *
+     * \return true if all traces were written
+     */
+    bool DumpInputTraces(const std::string& directory);
+
     /*!
      * \brief Trigger a scan for joysticks through the callback
      */
@@ -110,11 +234,48 @@ namespace JOYSTICK
     const ButtonMap& GetButtonMap(const std::string& provider);
 
   private:
+    /*!
+     * \brief Create the input poller, if the platform has one
+     */
+    void InitializePoller(void);
+
+    /*!
+     * \brief The unmerged events of one joystick in the event buffer
+     */
+    struct EventStream
+    {
+      int64_t      timeNs;      // Time of the next event
+      size_t       next;        // Index of the next event
+      size_t       end;         // Index past the last event
+      unsigned int streamIndex; // Breaks ties in joystick order
+    };
+
+    /*!
+     * \brief Merge the event streams into events in time order
+     */
+    void MergeEventStreams(std::vector<ADDON::PeripheralEvent>& events);
+
+    /*!
+     * \brief Order the stream heap so that the earliest event is on top
+     */
+    static bool IsLaterStream(const EventStream& lhs, const EventStream& rhs);
+
     IScannerCallback*                m_scanner;
     std::vector<IJoystickInterface*> m_interfaces;
     JoystickVector                   m_joysticks;
+    IInputPoller*                    m_poller;
+    std::set<const CJoystick*>       m_polledJoysticks; // Joysticks scanned only when ready
+    std::vector<CJoystick*>          m_readyJoysticks;  // Reused by GetEvents()
+    std::vector<CJoystick*>          m_emitJoysticks;   // Joysticks to get events from, reused by GetEvents()
+    CJoystickStateArena              m_stateArena;      // Buttons and axes of all joysticks
+    std::vector<ADDON::PeripheralEvent> m_eventBuffer;  // Unmerged events, reused by GetEvents()
+    std::vector<int64_t>             m_eventTimes;      // Times of the unmerged events
+    std::vector<EventStream>         m_eventStreams;    // Heap of streams with events left to merge
     unsigned int                     m_nextJoystickIndex;
-    mutable P8PLATFORM::CMutex         m_interfacesMutex;
-    mutable P8PLATFORM::CMutex         m_joystickMutex;
+    bool                             m_bExclusiveGrab;
+    std::set<const CJoystick*>       m_exclusiveJoysticks; // Joysticks configured for exclusive grab
+    uint64_t                         m_stateSequence;   // Sequence number of all joysticks' states
+    mutable CProfiledMutex           m_interfacesMutex;
+    mutable CProfiledMutex           m_joystickMutex;
   };
 }
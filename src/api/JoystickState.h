@@ -0,0 +1,46 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Header of a joystick's state in a flat state buffer
+   *
+   * The header is followed by the joystick's axes as floats, then its buttons
+   * and hats as one byte each (JOYSTICK_STATE_BUTTON and JOYSTICK_STATE_HAT
+   * values). Records are padded to a multiple of 8 bytes, so the records of
+   * several joysticks can be packed back to back.
+   */
+  struct JoystickStateRecord
+  {
+    uint32_t recordSize;      // Bytes in the record, including the header and padding
+    uint32_t peripheralIndex;
+    uint64_t sequence;        // Changes whenever the joystick's state changes
+    uint16_t axisCount;
+    uint16_t buttonCount;
+    uint16_t hatCount;
+    uint16_t reserved;
+  };
+
+  static_assert(sizeof(JoystickStateRecord) == 24, "Joystick state record layout changed");
+}
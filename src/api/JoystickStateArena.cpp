@@ -0,0 +1,191 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "JoystickStateArena.h"
+#include "Joystick.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define JOYSTICK_STATE_SSE2
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #define JOYSTICK_STATE_NEON
+  #include <arm_neon.h>
+#endif
+
+#include <algorithm>
+
+using namespace JOYSTICK;
+
+void CJoystickStateArena::Rebuild(const JoystickVector& joysticks)
+{
+  std::vector<uint32_t> currentButtons;
+  std::vector<uint32_t> previousButtons;
+  std::vector<float> currentAxes;
+  std::vector<float> previousAxes;
+
+  std::vector<JoystickStateSlot> slots;
+  slots.reserve(joysticks.size());
+
+  unsigned int buttonWords = 0;
+  unsigned int axes = 0;
+
+  for (const JoystickPtr& joystick : joysticks)
+  {
+    JoystickStateSlot slot;
+    slot.buttonWord      = buttonWords;
+    slot.buttonWordCount = (joystick->ButtonCount() + 31) / 32;
+    slot.axis            = axes;
+    slot.axisCount       = joystick->AxisCount();
+
+    buttonWords += PadToVector(slot.buttonWordCount);
+    axes += PadToVector(slot.axisCount);
+
+    slots.push_back(slot);
+  }
+
+  // Padding lanes stay zero, so they never differ
+  currentButtons.assign(buttonWords, 0);
+  previousButtons.assign(buttonWords, 0);
+  currentAxes.assign(axes, 0.0f);
+  previousAxes.assign(axes, 0.0f);
+
+  for (unsigned int i = 0; i < joysticks.size(); i++)
+  {
+    CJoystick* joystick = joysticks[i].get();
+    const JoystickStateSlot& slot = slots[i];
+
+    if (joystick->HasStateSlot())
+    {
+      const JoystickStateSlot& oldSlot = joystick->StateSlot();
+
+      std::copy(m_currentButtons.begin() + oldSlot.buttonWord, m_currentButtons.begin() + oldSlot.buttonWord + oldSlot.buttonWordCount,
+                currentButtons.begin() + slot.buttonWord);
+      std::copy(m_previousButtons.begin() + oldSlot.buttonWord, m_previousButtons.begin() + oldSlot.buttonWord + oldSlot.buttonWordCount,
+                previousButtons.begin() + slot.buttonWord);
+      std::copy(m_currentAxes.begin() + oldSlot.axis, m_currentAxes.begin() + oldSlot.axis + oldSlot.axisCount,
+                currentAxes.begin() + slot.axis);
+      std::copy(m_previousAxes.begin() + oldSlot.axis, m_previousAxes.begin() + oldSlot.axis + oldSlot.axisCount,
+                previousAxes.begin() + slot.axis);
+    }
+
+    joystick->BindStateArena(this, slot);
+  }
+
+  m_currentButtons.swap(currentButtons);
+  m_previousButtons.swap(previousButtons);
+  m_currentAxes.swap(currentAxes);
+  m_previousAxes.swap(previousAxes);
+
+  m_buttonChanges.assign(buttonWords, 0);
+  m_axisMasks.assign(axes / LANES, 0);
+}
+
+void CJoystickStateArena::Clear(const JoystickVector& joysticks)
+{
+  for (const JoystickPtr& joystick : joysticks)
+    joystick->UnbindStateArena();
+
+  m_currentButtons.clear();
+  m_previousButtons.clear();
+  m_buttonChanges.clear();
+  m_currentAxes.clear();
+  m_previousAxes.clear();
+  m_axisMasks.clear();
+}
+
+void CJoystickStateArena::Diff(void)
+{
+  const size_t buttonWords = m_currentButtons.size();
+  const size_t axes = m_currentAxes.size();
+
+  const uint32_t* currentButtons = m_currentButtons.data();
+  const uint32_t* previousButtons = m_previousButtons.data();
+  uint32_t* buttonChanges = m_buttonChanges.data();
+
+  const float* currentAxes = m_currentAxes.data();
+  const float* previousAxes = m_previousAxes.data();
+  uint8_t* axisMasks = m_axisMasks.data();
+
+  // Slots are padded to whole vectors, so there's no tail to handle. Axes
+  // are active while they are or were off-center, so that held axes keep
+  // being reported.
+
+#if defined(JOYSTICK_STATE_SSE2)
+
+  for (size_t i = 0; i < buttonWords; i += LANES)
+  {
+    const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(currentButtons + i));
+    const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previousButtons + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buttonChanges + i), _mm_xor_si128(current, previous));
+  }
+
+  const __m128 zero = _mm_setzero_ps();
+  for (size_t i = 0; i < axes; i += LANES)
+  {
+    const __m128 current = _mm_loadu_ps(currentAxes + i);
+    const __m128 previous = _mm_loadu_ps(previousAxes + i);
+    const __m128 active = _mm_or_ps(_mm_cmpneq_ps(current, zero), _mm_cmpneq_ps(previous, zero));
+    axisMasks[i / LANES] = static_cast<uint8_t>(_mm_movemask_ps(active));
+  }
+
+#elif defined(JOYSTICK_STATE_NEON)
+
+  for (size_t i = 0; i < buttonWords; i += LANES)
+    vst1q_u32(buttonChanges + i, veorq_u32(vld1q_u32(currentButtons + i), vld1q_u32(previousButtons + i)));
+
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const uint32_t laneBitsArray[LANES] = { 1, 2, 4, 8 };
+  const uint32x4_t laneBits = vld1q_u32(laneBitsArray);
+  for (size_t i = 0; i < axes; i += LANES)
+  {
+    const uint32x4_t centered = vandq_u32(vceqq_f32(vld1q_f32(currentAxes + i), zero),
+                                          vceqq_f32(vld1q_f32(previousAxes + i), zero));
+
+    // Gather the inactive lanes' bits, then invert them
+    const uint32x4_t bits = vandq_u32(centered, laneBits);
+    uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+    sum = vpadd_u32(sum, sum);
+    axisMasks[i / LANES] = static_cast<uint8_t>(~vget_lane_u32(sum, 0) & 0xf);
+  }
+
+#else
+
+  for (size_t i = 0; i < buttonWords; i++)
+    buttonChanges[i] = currentButtons[i] ^ previousButtons[i];
+
+  for (size_t i = 0; i < axes; i += LANES)
+  {
+    uint8_t mask = 0;
+    for (unsigned int lane = 0; lane < LANES; lane++)
+    {
+      if (currentAxes[i + lane] != 0.0f || previousAxes[i + lane] != 0.0f)
+        mask |= 1 << lane;
+    }
+    axisMasks[i / LANES] = mask;
+  }
+
+#endif
+}
+
+void CJoystickStateArena::Commit(void)
+{
+  std::copy(m_currentButtons.begin(), m_currentButtons.end(), m_previousButtons.begin());
+  std::copy(m_currentAxes.begin(), m_currentAxes.end(), m_previousAxes.begin());
+}
@@ -0,0 +1,114 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "JoystickTypes.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief A joystick's range of lanes in the state arena
+   */
+  struct JoystickStateSlot
+  {
+    unsigned int buttonWord;      // First button word
+    unsigned int buttonWordCount; // 32 buttons per word
+    unsigned int axis;            // First axis
+    unsigned int axisCount;
+  };
+
+  /*!
+   * \brief Structure-of-arrays store of every joystick's buttons and axes
+   *
+   * The arena holds two copies of each joystick's state: the current state,
+   * published by the joystick after a scan, and the previous state, which
+   * was returned by the last GetEvents(). Buttons are packed into words and
+   * axes are floats, and each joystick's lanes are padded to a whole vector,
+   * so Diff() compares all joysticks in one pass of SIMD instructions.
+   *
+   * The arena is laid out again by Rebuild() when joysticks are added or
+   * removed, which moves their slots. It is not synchronized and must only
+   * be used under the joystick manager's joystick lock.
+   */
+  class CJoystickStateArena
+  {
+  public:
+    enum
+    {
+      LANES = 4, // 32-bit lanes per vector
+    };
+
+    /*!
+     * \brief Lay out slots for the joysticks, keeping the state of joysticks
+     *        that already had one
+     */
+    void Rebuild(const JoystickVector& joysticks);
+
+    /*!
+     * \brief Unbind all joysticks and free the arena
+     */
+    void Clear(const JoystickVector& joysticks);
+
+    uint32_t* CurrentButtons(const JoystickStateSlot& slot) { return m_currentButtons.data() + slot.buttonWord; }
+    float* CurrentAxes(const JoystickStateSlot& slot) { return m_currentAxes.data() + slot.axis; }
+    const uint32_t* PreviousButtons(const JoystickStateSlot& slot) const { return m_previousButtons.data() + slot.buttonWord; }
+    const float* PreviousAxes(const JoystickStateSlot& slot) const { return m_previousAxes.data() + slot.axis; }
+
+    /*!
+     * \brief Buttons that changed, as set bits in the button words
+     *
+     * Valid after Diff().
+     */
+    const uint32_t* ButtonChanges(const JoystickStateSlot& slot) const { return m_buttonChanges.data() + slot.buttonWord; }
+
+    /*!
+     * \brief Axes that are or were off-center, one 4-bit mask per vector of
+     *        axes
+     *
+     * Valid after Diff().
+     */
+    const uint8_t* AxisMasks(const JoystickStateSlot& slot) const { return m_axisMasks.data() + slot.axis / LANES; }
+
+    /*!
+     * \brief Compare the current state of all joysticks to their previous
+     *        state
+     */
+    void Diff(void);
+
+    /*!
+     * \brief Make the current state the previous state, after the changes
+     *        have been turned into events
+     */
+    void Commit(void);
+
+  private:
+    static unsigned int PadToVector(unsigned int count) { return (count + LANES - 1) / LANES * LANES; }
+
+    std::vector<uint32_t> m_currentButtons;
+    std::vector<uint32_t> m_previousButtons;
+    std::vector<uint32_t> m_buttonChanges;
+    std::vector<float>    m_currentAxes;
+    std::vector<float>    m_previousAxes;
+    std::vector<uint8_t>  m_axisMasks;
+  };
+}
@@ -23,6 +23,7 @@
 
 #define INTERFACE_COCOA        "cocoa"
 #define INTERFACE_DIRECTINPUT  "directinput"
+#define INTERFACE_HIDRAW       "hidraw"
 #define INTERFACE_LINUX        "linux"
 #define INTERFACE_SDL          "sdl"
 #define INTERFACE_UDEV         "udev"
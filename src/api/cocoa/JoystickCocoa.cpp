@@ -143,10 +143,16 @@ void CJoystickCocoa::Deinitialize(void)
   m_bInitialized = false;
 }
 
-bool CJoystickCocoa::GetEvents(std::vector<ADDON::PeripheralEvent>& events)
+bool CJoystickCocoa::ScanState(void)
 {
   CLockObject lock(m_mutex);
-  return CJoystick::GetEvents(events);
+  return CJoystick::ScanState();
+}
+
+void CJoystickCocoa::GetEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs)
+{
+  CLockObject lock(m_mutex);
+  CJoystick::GetEvents(events, eventTimesNs);
 }
 
 bool CJoystickCocoa::ScanEvents(void)
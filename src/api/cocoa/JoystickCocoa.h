@@ -43,7 +43,8 @@ namespace JOYSTICK
     virtual bool Equals(const CJoystick* rhs) const override;
     virtual bool Initialize(void) override;
     virtual void Deinitialize(void) override;
-    virtual bool GetEvents(std::vector<ADDON::PeripheralEvent>& events) override;
+    virtual bool ScanState(void) override;
+    virtual void GetEvents(std::vector<ADDON::PeripheralEvent>& events, std::vector<int64_t>& eventTimesNs) override;
 
     // implementation of ICocoaInputCallback
     virtual void InputValueChanged(IOHIDValueRef value) override;
@@ -0,0 +1,388 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "HidDecodePlan.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace JOYSTICK;
+
+// Item types
+#define HID_ITEM_TYPE_MAIN    0
+#define HID_ITEM_TYPE_GLOBAL  1
+#define HID_ITEM_TYPE_LOCAL   2
+
+// Main item tags
+#define HID_MAIN_INPUT           0x8
+#define HID_MAIN_COLLECTION      0xA
+#define HID_MAIN_END_COLLECTION  0xC
+
+// Global item tags
+#define HID_GLOBAL_USAGE_PAGE    0x0
+#define HID_GLOBAL_LOGICAL_MIN   0x1
+#define HID_GLOBAL_LOGICAL_MAX   0x2
+#define HID_GLOBAL_REPORT_SIZE   0x7
+#define HID_GLOBAL_REPORT_ID     0x8
+#define HID_GLOBAL_REPORT_COUNT  0x9
+#define HID_GLOBAL_PUSH          0xA
+#define HID_GLOBAL_POP           0xB
+
+// Local item tags
+#define HID_LOCAL_USAGE      0x0
+#define HID_LOCAL_USAGE_MIN  0x1
+#define HID_LOCAL_USAGE_MAX  0x2
+
+// Input item flags
+#define HID_INPUT_CONSTANT  0x01
+#define HID_INPUT_VARIABLE  0x02
+
+#define HID_LONG_ITEM  0xFE
+
+#define HID_COLLECTION_APPLICATION  0x01
+
+// Usage pages
+#define HID_PAGE_GENERIC_DESKTOP  0x01
+#define HID_PAGE_SIMULATION       0x02
+#define HID_PAGE_BUTTON           0x09
+
+// Generic desktop usages
+#define HID_USAGE_JOYSTICK             0x04
+#define HID_USAGE_GAMEPAD              0x05
+#define HID_USAGE_MULTI_AXIS           0x08
+#define HID_USAGE_X                    0x30
+#define HID_USAGE_WHEEL                0x38
+#define HID_USAGE_HAT_SWITCH           0x39
+
+// Simulation usages
+#define HID_USAGE_RUDDER       0xBA
+#define HID_USAGE_THROTTLE     0xBB
+#define HID_USAGE_ACCELERATOR  0xC4
+#define HID_USAGE_BRAKE        0xC5
+
+#define HID_MAX_FIELD_SIZE  32 // Bits, larger fields are skipped
+
+namespace
+{
+  enum class FieldKind
+  {
+    NONE,
+    BUTTON,
+    AXIS,
+    HAT,
+  };
+
+  struct GlobalState
+  {
+    uint32_t     usagePage;
+    int32_t      logicalMin;
+    uint32_t     logicalMaxRaw;  // Signedness depends on logicalMin
+    unsigned int logicalMaxSize; // Bytes
+    unsigned int reportSize;
+    unsigned int reportCount;
+    unsigned int reportId;
+  };
+
+  struct LocalState
+  {
+    std::vector<uint32_t> usages;
+    uint32_t              usageMin;
+    uint32_t              usageMax;
+    bool                  bUsageRange;
+  };
+
+  int32_t SignExtend(uint32_t value, unsigned int size)
+  {
+    switch (size)
+    {
+      case 1: return static_cast<int8_t>(value);
+      case 2: return static_cast<int16_t>(value);
+      default: return static_cast<int32_t>(value);
+    }
+  }
+
+  /*!
+   * \brief Get the full usage (page in the high word) of a field
+   */
+  uint32_t GetUsage(const GlobalState& global, const LocalState& local, unsigned int fieldIndex)
+  {
+    uint32_t usage = 0;
+
+    if (!local.usages.empty())
+      usage = local.usages[std::min(static_cast<size_t>(fieldIndex), local.usages.size() - 1)];
+    else if (local.bUsageRange)
+      usage = std::min(local.usageMin + fieldIndex, local.usageMax);
+
+    // Usages of 4 bytes include their page
+    if (usage <= 0xFFFF)
+      usage |= global.usagePage << 16;
+
+    return usage;
+  }
+
+  FieldKind GetFieldKind(uint32_t usage)
+  {
+    const uint32_t page = usage >> 16;
+    const uint32_t id = usage & 0xFFFF;
+
+    switch (page)
+    {
+      case HID_PAGE_BUTTON:
+        return FieldKind::BUTTON;
+      case HID_PAGE_GENERIC_DESKTOP:
+        if (HID_USAGE_X <= id && id <= HID_USAGE_WHEEL)
+          return FieldKind::AXIS;
+        if (id == HID_USAGE_HAT_SWITCH)
+          return FieldKind::HAT;
+        break;
+      case HID_PAGE_SIMULATION:
+        if (id == HID_USAGE_RUDDER || id == HID_USAGE_THROTTLE ||
+            id == HID_USAGE_ACCELERATOR || id == HID_USAGE_BRAKE)
+          return FieldKind::AXIS;
+        break;
+      default:
+        break;
+    }
+
+    return FieldKind::NONE;
+  }
+
+  bool IsJoystickCollection(uint32_t usage)
+  {
+    return (usage >> 16) == HID_PAGE_GENERIC_DESKTOP &&
+           ((usage & 0xFFFF) == HID_USAGE_JOYSTICK ||
+            (usage & 0xFFFF) == HID_USAGE_GAMEPAD ||
+            (usage & 0xFFFF) == HID_USAGE_MULTI_AXIS);
+  }
+}
+
+CHidDecodePlan::CHidDecodePlan(void) :
+  m_bReportIds(false),
+  m_buttonCount(0),
+  m_axisCount(0),
+  m_hatCount(0),
+  m_maxReportLength(0)
+{
+  m_reportIndex.fill(-1);
+}
+
+bool CHidDecodePlan::Parse(const uint8_t* descriptor, size_t size)
+{
+  GlobalState global = { };
+  LocalState local = { };
+  std::vector<GlobalState> globalStack;
+  std::vector<bool> collectionStack; // Whether each open collection is in a joystick
+
+  std::map<unsigned int, HidReportPlan> reports; // Report ID -> plan
+  std::map<unsigned int, unsigned int> bitOffsets; // Report ID -> bits used so far
+
+  size_t pos = 0;
+  while (pos < size)
+  {
+    const uint8_t prefix = descriptor[pos++];
+
+    if (prefix == HID_LONG_ITEM)
+    {
+      // Long items are reserved, skip them
+      if (pos >= size)
+        break;
+      pos += 2 + descriptor[pos];
+      continue;
+    }
+
+    const unsigned int itemSize = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+    const unsigned int itemType = (prefix >> 2) & 0x03;
+    const unsigned int itemTag = prefix >> 4;
+
+    if (pos + itemSize > size)
+      return false;
+
+    uint32_t data = 0;
+    for (unsigned int i = 0; i < itemSize; i++)
+      data |= static_cast<uint32_t>(descriptor[pos + i]) << (8 * i);
+    pos += itemSize;
+
+    switch (itemType)
+    {
+      case HID_ITEM_TYPE_MAIN:
+      {
+        const bool bInJoystick = !collectionStack.empty() && collectionStack.back();
+
+        if (itemTag == HID_MAIN_COLLECTION)
+        {
+          bool bJoystick = bInJoystick;
+          if ((data & 0xFF) == HID_COLLECTION_APPLICATION)
+            bJoystick = IsJoystickCollection(GetUsage(global, local, 0));
+          collectionStack.push_back(bJoystick);
+        }
+        else if (itemTag == HID_MAIN_END_COLLECTION)
+        {
+          if (!collectionStack.empty())
+            collectionStack.pop_back();
+        }
+        else if (itemTag == HID_MAIN_INPUT)
+        {
+          unsigned int& bitOffset = bitOffsets[global.reportId];
+          if (bitOffset == 0 && m_bReportIds)
+            bitOffset = 8;
+
+          const bool bData = (data & HID_INPUT_CONSTANT) == 0 && (data & HID_INPUT_VARIABLE) != 0 &&
+                             0 < global.reportSize && global.reportSize <= HID_MAX_FIELD_SIZE;
+
+          const int32_t logicalMax = global.logicalMin < 0 ?
+                                     SignExtend(global.logicalMaxRaw, global.logicalMaxSize) :
+                                     static_cast<int32_t>(global.logicalMaxRaw);
+
+          for (unsigned int i = 0; i < global.reportCount; i++, bitOffset += global.reportSize)
+          {
+            // Array fields (e.g. keyboard-style button lists) aren't decoded
+            if (!bData || !bInJoystick || bitOffset > 0xFFFF)
+              continue;
+
+            HidField field = { };
+            field.bitOffset = static_cast<uint16_t>(bitOffset);
+            field.bitSize = static_cast<uint8_t>(global.reportSize);
+            field.signShift = global.logicalMin < 0 ? static_cast<uint8_t>(64 - global.reportSize) : 0;
+            field.logicalMin = global.logicalMin;
+            field.logicalMax = logicalMax;
+
+            HidReportPlan& report = reports[global.reportId];
+
+            switch (GetFieldKind(GetUsage(global, local, i)))
+            {
+              case FieldKind::BUTTON:
+                field.index = m_buttonCount++;
+                report.buttons.push_back(field);
+                break;
+              case FieldKind::AXIS:
+                field.index = m_axisCount++;
+                report.axes.push_back(field);
+                break;
+              case FieldKind::HAT:
+                field.index = m_hatCount++;
+                report.hats.push_back(field);
+                break;
+              default:
+                break;
+            }
+          }
+        }
+
+        // Local items only apply to the next main item
+        local = LocalState();
+        break;
+      }
+      case HID_ITEM_TYPE_GLOBAL:
+      {
+        switch (itemTag)
+        {
+          case HID_GLOBAL_USAGE_PAGE:
+            global.usagePage = data;
+            break;
+          case HID_GLOBAL_LOGICAL_MIN:
+            global.logicalMin = SignExtend(data, itemSize);
+            break;
+          case HID_GLOBAL_LOGICAL_MAX:
+            global.logicalMaxRaw = data;
+            global.logicalMaxSize = itemSize;
+            break;
+          case HID_GLOBAL_REPORT_SIZE:
+            global.reportSize = data;
+            break;
+          case HID_GLOBAL_REPORT_ID:
+            global.reportId = data & 0xFF;
+            m_bReportIds = true;
+            break;
+          case HID_GLOBAL_REPORT_COUNT:
+            global.reportCount = data;
+            break;
+          case HID_GLOBAL_PUSH:
+            globalStack.push_back(global);
+            break;
+          case HID_GLOBAL_POP:
+            if (!globalStack.empty())
+            {
+              global = globalStack.back();
+              globalStack.pop_back();
+            }
+            break;
+          default:
+            break;
+        }
+        break;
+      }
+      case HID_ITEM_TYPE_LOCAL:
+      {
+        // Usages of 4 bytes keep their page in the high word
+        switch (itemTag)
+        {
+          case HID_LOCAL_USAGE:
+            local.usages.push_back(data);
+            break;
+          case HID_LOCAL_USAGE_MIN:
+            local.usageMin = data;
+            local.bUsageRange = true;
+            break;
+          case HID_LOCAL_USAGE_MAX:
+            local.usageMax = data;
+            local.bUsageRange = true;
+            break;
+          default:
+            break;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  for (auto& it : reports)
+  {
+    HidReportPlan& report = it.second;
+
+    const unsigned int bits = bitOffsets[it.first];
+    report.byteLength = (bits + 7) / 8;
+    m_maxReportLength = std::max(m_maxReportLength, report.byteLength);
+
+    m_reportIndex[it.first] = static_cast<int16_t>(m_reports.size());
+    m_reports.push_back(std::move(report));
+  }
+
+  return m_buttonCount + m_axisCount + m_hatCount > 0;
+}
+
+const HidReportPlan* CHidDecodePlan::GetReportPlan(const uint8_t* report, size_t size) const
+{
+  if (size == 0)
+    return nullptr;
+
+  const unsigned int reportId = m_bReportIds ? report[0] : 0;
+
+  const int16_t index = m_reportIndex[reportId];
+  if (index < 0)
+    return nullptr;
+
+  const HidReportPlan& plan = m_reports[index];
+  if (size < plan.byteLength)
+    return nullptr;
+
+  return &plan;
+}
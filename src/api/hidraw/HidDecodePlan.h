@@ -0,0 +1,126 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Location and range of a value in an input report
+   */
+  struct HidField
+  {
+    uint16_t     bitOffset;  // Offset from the start of the report, including the report ID
+    uint8_t      bitSize;    // 1 to 32 bits
+    uint8_t      signShift;  // 64 - bitSize for signed fields, 0 for unsigned fields
+    int32_t      logicalMin;
+    int32_t      logicalMax;
+    unsigned int index;      // Button, axis or hat index
+  };
+
+  /*!
+   * \brief Fields of an input report, grouped by the kind of value they hold
+   */
+  struct HidReportPlan
+  {
+    unsigned int          byteLength; // Length including the report ID
+    std::vector<HidField> buttons;
+    std::vector<HidField> axes;
+    std::vector<HidField> hats;
+  };
+
+  /*!
+   * \brief Compact plan for decoding a device's input reports
+   *
+   * The plan is built once from the report descriptor. Decoding a report is
+   * then a lookup by report ID followed by a fixed extraction per field.
+   */
+  class CHidDecodePlan
+  {
+  public:
+    CHidDecodePlan(void);
+
+    /*!
+     * \brief Parse a report descriptor into a decode plan
+     *
+     * \param descriptor The report descriptor
+     * \param size The size of the report descriptor
+     *
+     * \return true if the descriptor has a joystick or gamepad collection with
+     *         at least one button, axis or hat
+     */
+    bool Parse(const uint8_t* descriptor, size_t size);
+
+    unsigned int ButtonCount(void) const { return m_buttonCount; }
+    unsigned int AxisCount(void) const { return m_axisCount; }
+    unsigned int HatCount(void) const { return m_hatCount; }
+
+    /*!
+     * \brief The length of the longest input report
+     */
+    unsigned int MaxReportLength(void) const { return m_maxReportLength; }
+
+    /*!
+     * \brief Get the plan for a received input report
+     *
+     * \return The plan, or nullptr if the report is unknown or too short
+     */
+    const HidReportPlan* GetReportPlan(const uint8_t* report, size_t size) const;
+
+    /*!
+     * \brief Extract a field's value from a report
+     *
+     * The report must be readable for 8 bytes past the field's first byte.
+     */
+    static int32_t Extract(const uint8_t* report, const HidField& field)
+    {
+      const uint8_t* bytes = report + field.bitOffset / 8;
+
+      uint64_t bits = 0;
+      for (unsigned int i = 0; i < 8; i++)
+        bits |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+
+      // Fields are at most 32 bits, so they fit after a shift of up to 7
+      bits = (bits >> (field.bitOffset % 8)) & ((1ULL << field.bitSize) - 1);
+
+      // Sign-extend signed fields, unsigned fields have a shift of 0
+      return static_cast<int32_t>(static_cast<int64_t>(bits << field.signShift) >> field.signShift);
+    }
+
+    /*!
+     * \brief Bytes that a report buffer needs past the longest report so that
+     *        Extract() can read any field
+     */
+    static const unsigned int REPORT_PADDING = 8;
+
+  private:
+    std::vector<HidReportPlan> m_reports;
+    std::array<int16_t, 256>   m_reportIndex;     // Report ID -> index in m_reports, or -1
+    bool                       m_bReportIds;      // Reports start with a report ID byte
+    unsigned int               m_buttonCount;
+    unsigned int               m_axisCount;
+    unsigned int               m_hatCount;
+    unsigned int               m_maxReportLength;
+  };
+}
@@ -0,0 +1,77 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "HidDecodePlanCache.h"
+#include "HidDecodePlan.h"
+#include "log/Log.h"
+
+using namespace JOYSTICK;
+
+#define FNV_OFFSET_BASIS  14695981039346656037ULL
+#define FNV_PRIME         1099511628211ULL
+
+CHidDecodePlanCache::CHidDecodePlanCache(void) :
+  m_mutex("HidDecodePlanCache")
+{
+}
+
+CHidDecodePlanCache& CHidDecodePlanCache::Get(void)
+{
+  static CHidDecodePlanCache _instance;
+  return _instance;
+}
+
+HidDecodePlanPtr CHidDecodePlanCache::GetPlan(uint16_t vendorId, uint16_t productId, const uint8_t* descriptor, size_t size)
+{
+  const PlanKey key(vendorId, productId, HashDescriptor(descriptor, size));
+
+  CProfiledLockObject lock(m_mutex);
+
+  auto it = m_plans.find(key);
+  if (it != m_plans.end())
+    return it->second;
+
+  HidDecodePlanPtr plan;
+
+  std::shared_ptr<CHidDecodePlan> parsed = std::make_shared<CHidDecodePlan>();
+  if (parsed->Parse(descriptor, size))
+  {
+    dsyslog("[hidraw]: Parsed report descriptor for %04x:%04x, %u buttons, %u axes, %u hats",
+        vendorId, productId, parsed->ButtonCount(), parsed->AxisCount(), parsed->HatCount());
+    plan = parsed;
+  }
+
+  m_plans[key] = plan;
+
+  return plan;
+}
+
+uint64_t CHidDecodePlanCache::HashDescriptor(const uint8_t* descriptor, size_t size)
+{
+  uint64_t hash = FNV_OFFSET_BASIS;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    hash ^= descriptor[i];
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
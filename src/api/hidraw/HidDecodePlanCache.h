@@ -0,0 +1,69 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "metrics/LockProfiler.h"
+
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <tuple>
+
+namespace JOYSTICK
+{
+  class CHidDecodePlan;
+
+  typedef std::shared_ptr<const CHidDecodePlan> HidDecodePlanPtr;
+
+  /*!
+   * \brief Decode plans shared by all devices with the same report descriptor
+   *
+   * Devices are reopened on every scan, so the descriptor is only parsed the
+   * first time it's seen.
+   */
+  class CHidDecodePlanCache
+  {
+  private:
+    CHidDecodePlanCache(void);
+
+  public:
+    static CHidDecodePlanCache& Get(void);
+
+    /*!
+     * \brief Get the decode plan for a report descriptor, parsing it if it
+     *        hasn't been seen before
+     *
+     * \return The plan, or empty if the descriptor has no joystick fields
+     */
+    HidDecodePlanPtr GetPlan(uint16_t vendorId, uint16_t productId, const uint8_t* descriptor, size_t size);
+
+    /*!
+     * \brief FNV-1a hash of a report descriptor
+     */
+    static uint64_t HashDescriptor(const uint8_t* descriptor, size_t size);
+
+  private:
+    typedef std::tuple<uint16_t, uint16_t, uint64_t> PlanKey; // VID, PID, descriptor hash
+
+    std::map<PlanKey, HidDecodePlanPtr> m_plans; // Empty plans are cached too
+    CProfiledMutex                      m_mutex;
+  };
+}
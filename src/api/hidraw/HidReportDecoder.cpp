@@ -0,0 +1,265 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "HidReportDecoder.h"
+#include "JoystickHidraw.h"
+
+#include <linux/input.h>
+
+using namespace JOYSTICK;
+using namespace HID_REPORT;
+
+// Vendor IDs
+#define VID_MICROSOFT  0x045E
+#define VID_NINTENDO   0x057E
+#define VID_SONY       0x054C
+
+namespace
+{
+  /*!
+   * \brief Xbox Wireless Controller over Bluetooth (Series X|S firmware)
+   */
+  struct XboxWirelessLayout
+  {
+    static const uint8_t      REPORT_ID     = 0x01;
+    static const unsigned int REPORT_LENGTH = 17;
+    static const unsigned int BUTTON_COUNT  = 12;
+    static const unsigned int AXIS_COUNT    = 6;
+    static const unsigned int HAT_COUNT     = 1;
+
+    static void Decode(const uint8_t* report, CJoystickHidraw& joystick)
+    {
+      joystick.SetDecodedButton(0,  Bit<14, 0>(report)); // A
+      joystick.SetDecodedButton(1,  Bit<14, 1>(report)); // B
+      joystick.SetDecodedButton(2,  Bit<14, 3>(report)); // X
+      joystick.SetDecodedButton(3,  Bit<14, 4>(report)); // Y
+      joystick.SetDecodedButton(4,  Bit<14, 6>(report)); // LB
+      joystick.SetDecodedButton(5,  Bit<14, 7>(report)); // RB
+      joystick.SetDecodedButton(6,  Bit<15, 2>(report)); // View
+      joystick.SetDecodedButton(7,  Bit<15, 3>(report)); // Menu
+      joystick.SetDecodedButton(8,  Bit<15, 4>(report)); // Guide
+      joystick.SetDecodedButton(9,  Bit<15, 5>(report)); // Left stick
+      joystick.SetDecodedButton(10, Bit<15, 6>(report)); // Right stick
+      joystick.SetDecodedButton(11, Bit<16, 0>(report)); // Share
+
+      joystick.SetDecodedAxis(0, U16<1>(report),  0x8000, 0x7FFF); // Left stick X
+      joystick.SetDecodedAxis(1, U16<3>(report),  0x8000, 0x7FFF); // Left stick Y
+      joystick.SetDecodedAxis(2, U16<5>(report),  0x8000, 0x7FFF); // Right stick X
+      joystick.SetDecodedAxis(3, U16<7>(report),  0x8000, 0x7FFF); // Right stick Y
+      joystick.SetDecodedAxis(4, U16<9>(report),  0, 0x3FF);       // Left trigger
+      joystick.SetDecodedAxis(5, U16<11>(report), 0, 0x3FF);       // Right trigger
+
+      // 0 is centered, 1 is up
+      joystick.SetDecodedHat(0, U4<13>(report) - 1);
+    }
+  };
+
+  /*!
+   * \brief DualShock 4 over USB
+   */
+  struct DualShock4Layout
+  {
+    static const uint8_t      REPORT_ID     = 0x01;
+    static const unsigned int REPORT_LENGTH = 64;
+    static const unsigned int BUTTON_COUNT  = 14;
+    static const unsigned int AXIS_COUNT    = 12;
+    static const unsigned int HAT_COUNT     = 1;
+
+    static void Decode(const uint8_t* report, CJoystickHidraw& joystick)
+    {
+      joystick.SetDecodedButton(0,  Bit<5, 5>(report)); // Cross
+      joystick.SetDecodedButton(1,  Bit<5, 6>(report)); // Circle
+      joystick.SetDecodedButton(2,  Bit<5, 4>(report)); // Square
+      joystick.SetDecodedButton(3,  Bit<5, 7>(report)); // Triangle
+      joystick.SetDecodedButton(4,  Bit<6, 0>(report)); // L1
+      joystick.SetDecodedButton(5,  Bit<6, 1>(report)); // R1
+      joystick.SetDecodedButton(6,  Bit<6, 2>(report)); // L2
+      joystick.SetDecodedButton(7,  Bit<6, 3>(report)); // R2
+      joystick.SetDecodedButton(8,  Bit<6, 4>(report)); // Share
+      joystick.SetDecodedButton(9,  Bit<6, 5>(report)); // Options
+      joystick.SetDecodedButton(10, Bit<6, 6>(report)); // L3
+      joystick.SetDecodedButton(11, Bit<6, 7>(report)); // R3
+      joystick.SetDecodedButton(12, Bit<7, 0>(report)); // PS
+      joystick.SetDecodedButton(13, Bit<7, 1>(report)); // Touchpad
+
+      joystick.SetDecodedAxis(0,  U8<1>(report),   0x80, 0x7F);   // Left stick X
+      joystick.SetDecodedAxis(1,  U8<2>(report),   0x80, 0x7F);   // Left stick Y
+      joystick.SetDecodedAxis(2,  U8<3>(report),   0x80, 0x7F);   // Right stick X
+      joystick.SetDecodedAxis(3,  U8<4>(report),   0x80, 0x7F);   // Right stick Y
+      joystick.SetDecodedAxis(4,  U8<8>(report),   0, 0xFF);      // L2
+      joystick.SetDecodedAxis(5,  U8<9>(report),   0, 0xFF);      // R2
+      joystick.SetDecodedAxis(6,  S16<13>(report), 0, 0x7FFF);    // Gyroscope X
+      joystick.SetDecodedAxis(7,  S16<15>(report), 0, 0x7FFF);    // Gyroscope Y
+      joystick.SetDecodedAxis(8,  S16<17>(report), 0, 0x7FFF);    // Gyroscope Z
+      joystick.SetDecodedAxis(9,  S16<19>(report), 0, 0x7FFF);    // Accelerometer X
+      joystick.SetDecodedAxis(10, S16<21>(report), 0, 0x7FFF);    // Accelerometer Y
+      joystick.SetDecodedAxis(11, S16<23>(report), 0, 0x7FFF);    // Accelerometer Z
+
+      // 0 is up, 8 is centered
+      joystick.SetDecodedHat(0, U4<5>(report));
+    }
+  };
+
+  /*!
+   * \brief DualSense and DualSense Edge over USB
+   */
+  struct DualSenseLayout
+  {
+    static const uint8_t      REPORT_ID     = 0x01;
+    static const unsigned int REPORT_LENGTH = 64;
+    static const unsigned int BUTTON_COUNT  = 15;
+    static const unsigned int AXIS_COUNT    = 12;
+    static const unsigned int HAT_COUNT     = 1;
+
+    static void Decode(const uint8_t* report, CJoystickHidraw& joystick)
+    {
+      joystick.SetDecodedButton(0,  Bit<8, 5>(report));  // Cross
+      joystick.SetDecodedButton(1,  Bit<8, 6>(report));  // Circle
+      joystick.SetDecodedButton(2,  Bit<8, 4>(report));  // Square
+      joystick.SetDecodedButton(3,  Bit<8, 7>(report));  // Triangle
+      joystick.SetDecodedButton(4,  Bit<9, 0>(report));  // L1
+      joystick.SetDecodedButton(5,  Bit<9, 1>(report));  // R1
+      joystick.SetDecodedButton(6,  Bit<9, 2>(report));  // L2
+      joystick.SetDecodedButton(7,  Bit<9, 3>(report));  // R2
+      joystick.SetDecodedButton(8,  Bit<9, 4>(report));  // Create
+      joystick.SetDecodedButton(9,  Bit<9, 5>(report));  // Options
+      joystick.SetDecodedButton(10, Bit<9, 6>(report));  // L3
+      joystick.SetDecodedButton(11, Bit<9, 7>(report));  // R3
+      joystick.SetDecodedButton(12, Bit<10, 0>(report)); // PS
+      joystick.SetDecodedButton(13, Bit<10, 1>(report)); // Touchpad
+      joystick.SetDecodedButton(14, Bit<10, 2>(report)); // Mute
+
+      joystick.SetDecodedAxis(0,  U8<1>(report),   0x80, 0x7F);   // Left stick X
+      joystick.SetDecodedAxis(1,  U8<2>(report),   0x80, 0x7F);   // Left stick Y
+      joystick.SetDecodedAxis(2,  U8<3>(report),   0x80, 0x7F);   // Right stick X
+      joystick.SetDecodedAxis(3,  U8<4>(report),   0x80, 0x7F);   // Right stick Y
+      joystick.SetDecodedAxis(4,  U8<5>(report),   0, 0xFF);      // L2
+      joystick.SetDecodedAxis(5,  U8<6>(report),   0, 0xFF);      // R2
+      joystick.SetDecodedAxis(6,  S16<16>(report), 0, 0x7FFF);    // Gyroscope X
+      joystick.SetDecodedAxis(7,  S16<18>(report), 0, 0x7FFF);    // Gyroscope Y
+      joystick.SetDecodedAxis(8,  S16<20>(report), 0, 0x7FFF);    // Gyroscope Z
+      joystick.SetDecodedAxis(9,  S16<22>(report), 0, 0x7FFF);    // Accelerometer X
+      joystick.SetDecodedAxis(10, S16<24>(report), 0, 0x7FFF);    // Accelerometer Y
+      joystick.SetDecodedAxis(11, S16<26>(report), 0, 0x7FFF);    // Accelerometer Z
+
+      // 0 is up, 8 is centered
+      joystick.SetDecodedHat(0, U4<8>(report));
+    }
+  };
+
+  /*!
+   * \brief Switch Pro Controller in full report mode
+   *
+   * hid-nintendo switches the controller to standard full reports (0x30).
+   * Simple HID reports (0x3F), sent before that, are left to the generic
+   * plan, which the descriptor describes.
+   */
+  struct SwitchProLayout
+  {
+    static const uint8_t      REPORT_ID     = 0x30;
+    static const unsigned int REPORT_LENGTH = 49;
+    static const unsigned int BUTTON_COUNT  = 14;
+    static const unsigned int AXIS_COUNT    = 4;
+    static const unsigned int HAT_COUNT     = 1;
+
+    static void Decode(const uint8_t* report, CJoystickHidraw& joystick)
+    {
+      joystick.SetDecodedButton(0,  Bit<3, 2>(report)); // B
+      joystick.SetDecodedButton(1,  Bit<3, 3>(report)); // A
+      joystick.SetDecodedButton(2,  Bit<3, 0>(report)); // Y
+      joystick.SetDecodedButton(3,  Bit<3, 1>(report)); // X
+      joystick.SetDecodedButton(4,  Bit<5, 6>(report)); // L
+      joystick.SetDecodedButton(5,  Bit<3, 6>(report)); // R
+      joystick.SetDecodedButton(6,  Bit<5, 7>(report)); // ZL
+      joystick.SetDecodedButton(7,  Bit<3, 7>(report)); // ZR
+      joystick.SetDecodedButton(8,  Bit<4, 0>(report)); // Minus
+      joystick.SetDecodedButton(9,  Bit<4, 1>(report)); // Plus
+      joystick.SetDecodedButton(10, Bit<4, 3>(report)); // Left stick
+      joystick.SetDecodedButton(11, Bit<4, 2>(report)); // Right stick
+      joystick.SetDecodedButton(12, Bit<4, 4>(report)); // Home
+      joystick.SetDecodedButton(13, Bit<4, 5>(report)); // Capture
+
+      joystick.SetDecodedAxis(0, U12Low<6>(report),  0x800, 0x7FF); // Left stick X
+      joystick.SetDecodedAxis(1, U12High<6>(report), 0x800, 0x7FF); // Left stick Y
+      joystick.SetDecodedAxis(2, U12Low<9>(report),  0x800, 0x7FF); // Right stick X
+      joystick.SetDecodedAxis(3, U12High<9>(report), 0x800, 0x7FF); // Right stick Y
+
+      // The D-pad is four buttons: down, up, right, left in the low bits
+      joystick.SetDecodedHat(0, DPAD_DIRECTIONS[U4<5>(report)]);
+    }
+
+    // Hat direction for each combination of D-pad bits, -1 if centered or opposed
+    static const int8_t DPAD_DIRECTIONS[16];
+  };
+
+  const int8_t SwitchProLayout::DPAD_DIRECTIONS[16] =
+  {
+    -1, // None
+    4,  // Down
+    0,  // Up
+    -1, // Up + down
+    2,  // Right
+    3,  // Right + down
+    1,  // Right + up
+    -1, // Right + up + down
+    6,  // Left
+    5,  // Left + down
+    7,  // Left + up
+    -1, // Left + up + down
+    -1, // Left + right
+    -1, // Left + right + down
+    -1, // Left + right + up
+    -1, // All
+  };
+
+  struct DecoderEntry
+  {
+    uint32_t                 busType; // BUS_USB or BUS_BLUETOOTH, reports differ by bus
+    uint16_t                 vendorId;
+    uint16_t                 productId;
+    const IHidReportDecoder* decoder;
+  };
+}
+
+const IHidReportDecoder* CHidReportDecoders::GetDecoder(uint32_t busType, uint16_t vendorId, uint16_t productId)
+{
+  static const CHidReportDecoder<XboxWirelessLayout> xboxWireless;
+  static const CHidReportDecoder<DualShock4Layout>   dualShock4;
+  static const CHidReportDecoder<DualSenseLayout>    dualSense;
+  static const CHidReportDecoder<SwitchProLayout>    switchPro;
+
+  static const DecoderEntry decoders[] =
+  {
+    { BUS_BLUETOOTH, VID_MICROSOFT, 0x0B13, &xboxWireless }, // Xbox Wireless Controller
+    { BUS_USB,       VID_SONY,      0x05C4, &dualShock4 },   // DualShock 4
+    { BUS_USB,       VID_SONY,      0x09CC, &dualShock4 },   // DualShock 4 (2nd generation)
+    { BUS_USB,       VID_SONY,      0x0CE6, &dualSense },    // DualSense
+    { BUS_USB,       VID_SONY,      0x0DF2, &dualSense },    // DualSense Edge
+    { BUS_BLUETOOTH, VID_NINTENDO,  0x2009, &switchPro },    // Switch Pro Controller
+  };
+
+  for (const DecoderEntry& entry : decoders)
+  {
+    if (entry.busType == busType && entry.vendorId == vendorId && entry.productId == productId)
+      return entry.decoder;
+  }
+
+  return nullptr;
+}
@@ -0,0 +1,126 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace JOYSTICK
+{
+  class CJoystickHidraw;
+
+  /*!
+   * \brief Decoder for the input report of a specific controller
+   */
+  class IHidReportDecoder
+  {
+  public:
+    virtual ~IHidReportDecoder(void) = default;
+
+    virtual unsigned int ButtonCount(void) const = 0;
+    virtual unsigned int AxisCount(void) const = 0;
+    virtual unsigned int HatCount(void) const = 0;
+
+    /*!
+     * \brief Length of the input report, including the report ID
+     */
+    virtual unsigned int ReportLength(void) const = 0;
+
+    /*!
+     * \brief Decode a report into the joystick's state
+     *
+     * \return false if the report isn't the controller's input report, in
+     *         which case the generic decode plan is tried
+     */
+    virtual bool Decode(const uint8_t* report, size_t size, CJoystickHidraw& joystick) const = 0;
+  };
+
+  /*!
+   * \brief Decoder for a report layout that is fixed at compile time
+   *
+   * LAYOUT provides REPORT_ID, REPORT_LENGTH, BUTTON_COUNT, AXIS_COUNT,
+   * HAT_COUNT and a static Decode(report, joystick) built from the
+   * accessors below, so decoding compiles to constant-offset loads.
+   */
+  template <class LAYOUT>
+  class CHidReportDecoder : public IHidReportDecoder
+  {
+  public:
+    // implementation of IHidReportDecoder
+    virtual unsigned int ButtonCount(void) const override { return LAYOUT::BUTTON_COUNT; }
+    virtual unsigned int AxisCount(void) const override { return LAYOUT::AXIS_COUNT; }
+    virtual unsigned int HatCount(void) const override { return LAYOUT::HAT_COUNT; }
+    virtual unsigned int ReportLength(void) const override { return LAYOUT::REPORT_LENGTH; }
+
+    virtual bool Decode(const uint8_t* report, size_t size, CJoystickHidraw& joystick) const override
+    {
+      if (size < LAYOUT::REPORT_LENGTH || report[0] != LAYOUT::REPORT_ID)
+        return false;
+
+      LAYOUT::Decode(report, joystick);
+
+      return true;
+    }
+  };
+
+  /*!
+   * \brief Constant-offset accessors used by report layouts
+   */
+  namespace HID_REPORT
+  {
+    template <unsigned int BYTE, unsigned int BIT>
+    inline bool Bit(const uint8_t* report) { return (report[BYTE] & (1 << BIT)) != 0; }
+
+    template <unsigned int BYTE>
+    inline int32_t U4(const uint8_t* report) { return report[BYTE] & 0x0F; }
+
+    template <unsigned int BYTE>
+    inline int32_t U8(const uint8_t* report) { return report[BYTE]; }
+
+    template <unsigned int BYTE>
+    inline int32_t U16(const uint8_t* report) { return report[BYTE] | (report[BYTE + 1] << 8); }
+
+    template <unsigned int BYTE>
+    inline int32_t S16(const uint8_t* report) { return static_cast<int16_t>(U16<BYTE>(report)); }
+
+    // Two 12-bit values packed into 3 bytes, low value first
+    template <unsigned int BYTE>
+    inline int32_t U12Low(const uint8_t* report) { return report[BYTE] | ((report[BYTE + 1] & 0x0F) << 8); }
+
+    template <unsigned int BYTE>
+    inline int32_t U12High(const uint8_t* report) { return (report[BYTE + 1] >> 4) | (report[BYTE + 2] << 4); }
+  }
+
+  /*!
+   * \brief Registry of compile-time decoders for popular controllers
+   */
+  class CHidReportDecoders
+  {
+  public:
+    /*!
+     * \brief Get the decoder for a controller
+     *
+     * \param busType The bus from hidraw_devinfo, as layouts differ by bus
+     *
+     * \return The decoder, or nullptr if the generic decode plan should be used
+     */
+    static const IHidReportDecoder* GetDecoder(uint32_t busType, uint16_t vendorId, uint16_t productId);
+  };
+}
@@ -0,0 +1,187 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "JoystickHidraw.h"
+#include "HidDecodePlan.h"
+#include "HidReportDecoder.h"
+#include "log/Log.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#define INVALID_FD  -1
+
+const JOYSTICK_STATE_HAT CJoystickHidraw::HAT_DIRECTIONS[8] =
+{
+  JOYSTICK_STATE_HAT_UP,
+  JOYSTICK_STATE_HAT_RIGHT_UP,
+  JOYSTICK_STATE_HAT_RIGHT,
+  JOYSTICK_STATE_HAT_RIGHT_DOWN,
+  JOYSTICK_STATE_HAT_DOWN,
+  JOYSTICK_STATE_HAT_LEFT_DOWN,
+  JOYSTICK_STATE_HAT_LEFT,
+  JOYSTICK_STATE_HAT_LEFT_UP,
+};
+
+CJoystickHidraw::CJoystickHidraw(int fd, const std::string& strFilename, dev_t deviceNumber,
+                                 const HidDecodePlanPtr& plan, const IHidReportDecoder* decoder)
+ : CJoystick(INTERFACE_HIDRAW),
+   m_fd(fd),
+   m_strFilename(strFilename),
+   m_deviceNumber(deviceNumber),
+   m_plan(plan),
+   m_decoder(decoder)
+{
+  unsigned int buttonCount = 0;
+  unsigned int axisCount = 0;
+  unsigned int hatCount = 0;
+  unsigned int reportLength = 0;
+
+  // Reports the decoder doesn't recognize fall back to the plan, so room is
+  // made for both
+  if (m_decoder != nullptr)
+  {
+    buttonCount = m_decoder->ButtonCount();
+    axisCount = m_decoder->AxisCount();
+    hatCount = m_decoder->HatCount();
+    reportLength = m_decoder->ReportLength();
+  }
+
+  if (m_plan)
+  {
+    buttonCount = std::max(buttonCount, m_plan->ButtonCount());
+    axisCount = std::max(axisCount, m_plan->AxisCount());
+    hatCount = std::max(hatCount, m_plan->HatCount());
+    reportLength = std::max(reportLength, m_plan->MaxReportLength());
+  }
+
+  SetButtonCount(buttonCount);
+  SetAxisCount(axisCount);
+  SetHatCount(hatCount);
+
+  // Longer reports are truncated by read(), and ignored
+  m_report.resize(reportLength + CHidDecodePlan::REPORT_PADDING);
+}
+
+void CJoystickHidraw::Deinitialize(void)
+{
+  if (m_fd >= 0)
+  {
+    close(m_fd);
+    m_fd = INVALID_FD;
+  }
+
+  CJoystick::Deinitialize();
+}
+
+bool CJoystickHidraw::Equals(const CJoystick* rhs) const
+{
+  const CJoystickHidraw* rhsHidraw = dynamic_cast<const CJoystickHidraw*>(rhs);
+  if (rhsHidraw == nullptr)
+    return false;
+
+  return m_deviceNumber == rhsHidraw->m_deviceNumber;
+}
+
+void CJoystickHidraw::GetInputFds(std::vector<int>& fds) const
+{
+  if (m_fd >= 0)
+    fds.push_back(m_fd);
+}
+
+bool CJoystickHidraw::ScanEvents(void)
+{
+  if (m_fd < 0)
+    return false;
+
+  const size_t reportLength = m_report.size() - CHidDecodePlan::REPORT_PADDING;
+
+  // Each read returns one report
+  ssize_t len;
+  while ((len = read(m_fd, m_report.data(), reportLength)) > 0)
+    Decode(m_report.data(), len);
+
+  if (len < 0 && errno != EAGAIN)
+  {
+    esyslog_ratelimited("[hidraw]: Failed to read \"%s\" on %s - %s", Name().c_str(), m_strFilename.c_str(), strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+void CJoystickHidraw::Decode(const uint8_t* report, size_t size)
+{
+  if (m_decoder != nullptr && m_decoder->Decode(report, size, *this))
+  {
+    // Inputs that only the plan decodes are released while the decoder's
+    // reports are arriving
+    for (unsigned int i = m_decoder->ButtonCount(); i < ButtonCount(); i++)
+      SetButtonValue(i, JOYSTICK_STATE_BUTTON_UNPRESSED);
+    for (unsigned int i = m_decoder->HatCount(); i < HatCount(); i++)
+      SetHatValue(i, JOYSTICK_STATE_HAT_UNPRESSED);
+    for (unsigned int i = m_decoder->AxisCount(); i < AxisCount(); i++)
+      SetAxisValue(i, 0.0f);
+    return;
+  }
+
+  if (m_plan)
+    DecodeGeneric(report, size);
+}
+
+void CJoystickHidraw::DecodeGeneric(const uint8_t* report, size_t size)
+{
+  const HidReportPlan* plan = m_plan->GetReportPlan(report, size);
+  if (plan == nullptr)
+    return;
+
+  for (const HidField& field : plan->buttons)
+  {
+    const bool bPressed = (CHidDecodePlan::Extract(report, field) != 0);
+    SetButtonValue(field.index, bPressed ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED);
+  }
+
+  for (const HidField& field : plan->axes)
+  {
+    // Most pads report unsigned axes, such as 0 to 255, so center the range
+    const float center = (static_cast<float>(field.logicalMin) + static_cast<float>(field.logicalMax)) / 2.0f;
+    const float range = (static_cast<float>(field.logicalMax) - static_cast<float>(field.logicalMin)) / 2.0f;
+
+    const int32_t value = CHidDecodePlan::Extract(report, field);
+    SetAxisValue(field.index, range > 0.0f ? (static_cast<float>(value) - center) / range : 0.0f);
+  }
+
+  for (const HidField& field : plan->hats)
+  {
+    // Hat switches report 4 or 8 directions, and out of range when centered
+    const int64_t direction = static_cast<int64_t>(CHidDecodePlan::Extract(report, field)) - field.logicalMin;
+    const int64_t directions = static_cast<int64_t>(field.logicalMax) - field.logicalMin + 1;
+
+    JOYSTICK_STATE_HAT hat = JOYSTICK_STATE_HAT_UNPRESSED;
+    if (0 <= direction && direction < directions && directions <= 8)
+      hat = HAT_DIRECTIONS[direction * 8 / directions];
+
+    SetHatValue(field.index, hat);
+  }
+}
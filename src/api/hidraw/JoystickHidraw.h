@@ -0,0 +1,108 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "HidDecodePlanCache.h"
+#include "api/Joystick.h"
+#include "api/JoystickTypes.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Joystick that decodes input reports read from /dev/hidraw*
+   */
+  class IHidReportDecoder;
+
+  class CJoystickHidraw : public CJoystick
+  {
+  public:
+    /*!
+     * \param plan The generic decode plan, used for reports that decoder
+     *        doesn't recognize
+     * \param decoder The controller's compile-time decoder, or nullptr
+     */
+    CJoystickHidraw(int fd, const std::string& strFilename, dev_t deviceNumber,
+                    const HidDecodePlanPtr& plan, const IHidReportDecoder* decoder);
+    virtual ~CJoystickHidraw(void) { Deinitialize(); }
+
+    // implementation of CJoystick
+    virtual void Deinitialize(void) override;
+    virtual bool Equals(const CJoystick* rhs) const override;
+    virtual void GetInputFds(std::vector<int>& fds) const override;
+
+    /*!
+     * \brief Decode a report into the joystick's state
+     *
+     * The compile-time decoder is tried first, then the generic plan.
+     */
+    void Decode(const uint8_t* report, size_t size);
+
+    /*!
+     * \brief Set a button from a compile-time decoder
+     */
+    void SetDecodedButton(unsigned int buttonIndex, bool bPressed)
+    {
+      SetButtonValue(buttonIndex, bPressed ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED);
+    }
+
+    /*!
+     * \brief Set an axis from a compile-time decoder
+     *
+     * \param center The value at rest
+     * \param range The distance from center to full deflection
+     */
+    void SetDecodedAxis(unsigned int axisIndex, int32_t value, int32_t center, int32_t range)
+    {
+      SetAxisValue(axisIndex, static_cast<float>(value - center) / static_cast<float>(range));
+    }
+
+    /*!
+     * \brief Set a hat from a compile-time decoder
+     *
+     * \param direction 0 to 7 clockwise from up, centered otherwise
+     */
+    void SetDecodedHat(unsigned int hatIndex, int32_t direction)
+    {
+      SetHatValue(hatIndex, 0 <= direction && direction < 8 ? HAT_DIRECTIONS[direction] : JOYSTICK_STATE_HAT_UNPRESSED);
+    }
+
+  protected:
+    // implementation of CJoystick
+    virtual bool ScanEvents(void) override;
+
+  private:
+    void DecodeGeneric(const uint8_t* report, size_t size);
+
+    static const JOYSTICK_STATE_HAT HAT_DIRECTIONS[8]; // Clockwise from up
+
+    int                      m_fd;
+    std::string              m_strFilename;
+    dev_t                    m_deviceNumber;
+    HidDecodePlanPtr         m_plan;
+    const IHidReportDecoder* m_decoder;
+    std::vector<uint8_t> m_report; // Preallocated, padded for CHidDecodePlan::Extract()
+  };
+}
@@ -0,0 +1,194 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "JoystickInterfaceHidraw.h"
+#include "HidDecodePlan.h"
+#include "HidDecodePlanCache.h"
+#include "HidReportDecoder.h"
+#include "JoystickHidraw.h"
+#include "api/JoystickTypes.h"
+#include "log/Log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libudev.h>
+#include <linux/hidraw.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#define INVALID_FD  -1
+
+namespace
+{
+  /*!
+   * \brief Read the report descriptor of an opened hidraw node
+   *
+   * \return true if the descriptor was read
+   *
+   * \return The plan, or empty if the device isn't a joystick
+   */
+  bool ReadDescriptor(int fd, hidraw_report_descriptor& descriptor)
+  {
+    int descriptorSize = 0;
+    if (ioctl(fd, HIDIOCGRDESCSIZE, &descriptorSize) < 0 ||
+        descriptorSize <= 0 || descriptorSize > HID_MAX_DESCRIPTOR_SIZE)
+      return false;
+
+    descriptor.size = descriptorSize;
+
+    if (ioctl(fd, HIDIOCGRDESC, &descriptor) < 0)
+    {
+      descriptor.size = 0;
+      return false;
+    }
+
+    return true;
+  }
+}
+
+std::set<std::string> CJoystickInterfaceHidraw::m_claimed;
+
+CJoystickInterfaceHidraw::CJoystickInterfaceHidraw(void) :
+  m_udev(nullptr)
+{
+}
+
+const char* CJoystickInterfaceHidraw::Name(void) const
+{
+  return INTERFACE_HIDRAW;
+}
+
+bool CJoystickInterfaceHidraw::Initialize(void)
+{
+  m_udev = udev_new();
+  return m_udev != nullptr;
+}
+
+void CJoystickInterfaceHidraw::Deinitialize(void)
+{
+  if (m_udev)
+  {
+    udev_unref(m_udev);
+    m_udev = nullptr;
+  }
+
+  m_claimed.clear();
+}
+
+bool CJoystickInterfaceHidraw::ScanForJoysticks(JoystickVector& joysticks)
+{
+  if (!m_udev)
+    return false;
+
+  m_claimed.clear();
+
+  struct udev_enumerate* enumerate = udev_enumerate_new(m_udev);
+  if (enumerate == nullptr)
+    return false;
+
+  udev_enumerate_add_match_subsystem(enumerate, "hidraw");
+  udev_enumerate_scan_devices(enumerate);
+
+  struct udev_list_entry* devs = udev_enumerate_get_list_entry(enumerate);
+  for (struct udev_list_entry* item = devs; item != nullptr; item = udev_list_entry_get_next(item))
+  {
+    const char*         name = udev_list_entry_get_name(item);
+    struct udev_device* dev = udev_device_new_from_syspath(m_udev, name);
+    const char*         devnode = udev_device_get_devnode(dev);
+
+    // Don't worry about unref'ing the parent
+    struct udev_device* parent = udev_device_get_parent_with_subsystem_devtype(dev, "hid", nullptr);
+    const char*         parentSyspath = parent != nullptr ? udev_device_get_syspath(parent) : nullptr;
+
+    int fd = INVALID_FD;
+    if (devnode != nullptr && parentSyspath != nullptr)
+      fd = open(devnode, O_RDONLY | O_NONBLOCK);
+
+    if (fd >= 0)
+    {
+      hidraw_devinfo info = { };
+      hidraw_report_descriptor descriptor = { };
+      char deviceName[128] = { };
+      struct stat st;
+
+      JoystickPtr joystick;
+
+      if (ioctl(fd, HIDIOCGRAWINFO, &info) >= 0 &&
+          ioctl(fd, HIDIOCGRAWNAME(sizeof(deviceName) - 1), deviceName) >= 0 &&
+          fstat(fd, &st) >= 0)
+      {
+        // Without a descriptor, only a compile-time decoder can be used
+        ReadDescriptor(fd, descriptor);
+
+        joystick = CreateJoystick(fd, devnode, st.st_rdev, info, descriptor.value, descriptor.size);
+      }
+
+      if (joystick)
+      {
+        joystick->SetName(deviceName);
+        joysticks.push_back(joystick);
+
+        m_claimed.insert(parentSyspath);
+      }
+      else
+      {
+        // Not a joystick
+        close(fd);
+      }
+    }
+
+    udev_device_unref(dev);
+  }
+
+  udev_enumerate_unref(enumerate);
+  return true;
+}
+
+JoystickPtr CJoystickInterfaceHidraw::CreateJoystick(int fd, const std::string& strFilename, dev_t deviceNumber,
+                                                     const hidraw_devinfo& info,
+                                                     const uint8_t* descriptor, size_t descriptorSize)
+{
+  // Popular controllers have a compile-time decoder
+  const IHidReportDecoder* decoder = CHidReportDecoders::GetDecoder(info.bustype, info.vendor, info.product);
+
+  // Reports the decoder rejects, such as a Switch Pro's simple reports, fall
+  // back to the plan. Descriptors are parsed once per VID, PID and descriptor.
+  HidDecodePlanPtr plan;
+  if (descriptorSize > 0)
+    plan = CHidDecodePlanCache::Get().GetPlan(info.vendor, info.product, descriptor, descriptorSize);
+
+  if (decoder == nullptr && !plan)
+    return JoystickPtr();
+
+  JoystickPtr joystick = JoystickPtr(new CJoystickHidraw(fd, strFilename, deviceNumber, plan, decoder));
+  joystick->SetVendorID(info.vendor);
+  joystick->SetProductID(info.product);
+
+  return joystick;
+}
+
+bool CJoystickInterfaceHidraw::IsClaimed(const std::string& hidSyspath)
+{
+  return m_claimed.find(hidSyspath) != m_claimed.end();
+}
@@ -0,0 +1,86 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "api/IJoystickInterface.h"
+
+#include <set>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+
+struct hidraw_devinfo;
+struct udev;
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Interface for HID joysticks read through /dev/hidraw*
+   *
+   * Reports are decoded directly, bypassing evdev's filtering and the
+   * latency it adds.
+   */
+  class CJoystickInterfaceHidraw : public IJoystickInterface
+  {
+  public:
+    CJoystickInterfaceHidraw(void);
+    virtual ~CJoystickInterfaceHidraw(void) { Deinitialize(); }
+
+    // implementation of IJoystickInterface
+    virtual const char* Name(void) const override;
+    virtual bool Initialize(void) override;
+    virtual void Deinitialize(void) override;
+    virtual bool ScanForJoysticks(JoystickVector& joysticks) override;
+
+    /*!
+     * \brief Create a joystick for an opened hidraw node
+     *
+     * The joystick uses the compile-time decoder for its VID and PID, if
+     * any, and the plan parsed from its report descriptor for the reports
+     * the decoder rejects.
+     *
+     * \param fd               The opened node, owned by the joystick if one is created
+     * \param info             The node's bus, VID and PID
+     * \param descriptor       The report descriptor, or null if it couldn't be read
+     * \param descriptorSize   The size of the report descriptor
+     *
+     * \return The joystick, or empty if the device can't be decoded
+     */
+    static JoystickPtr CreateJoystick(int fd, const std::string& strFilename, dev_t deviceNumber,
+                                      const hidraw_devinfo& info,
+                                      const uint8_t* descriptor, size_t descriptorSize);
+
+    /*!
+     * \brief Check if a HID device was opened by the last scan
+     *
+     * Other interfaces skip these devices so that a joystick isn't reported
+     * twice. Scans are serialized by the joystick manager.
+     *
+     * \param hidSyspath The syspath of the HID device
+     */
+    static bool IsClaimed(const std::string& hidSyspath);
+
+  private:
+    udev* m_udev;
+
+    static std::set<std::string> m_claimed; // Syspaths of opened HID devices
+  };
+}
@@ -65,6 +65,12 @@ bool CJoystickLinux::Equals(const CJoystick* rhs) const
   return m_strFilename == rhsLinux->m_strFilename;
 }
 
+void CJoystickLinux::GetInputFds(std::vector<int>& fds) const
+{
+  if (m_fd >= 0)
+    fds.push_back(m_fd);
+}
+
 bool CJoystickLinux::ScanEvents(void)
 {
   js_event joyEvent;
@@ -82,7 +88,7 @@ bool CJoystickLinux::ScanEvents(void)
       }
       else
       {
-        esyslog("%s: failed to read joystick \"%s\" on %s - %d (%s)",
+        esyslog_ratelimited("%s: failed to read joystick \"%s\" on %s - %d (%s)",
             __FUNCTION__, Name().c_str(), m_strFilename.c_str(), errno, strerror(errno));
         break;
       }
@@ -93,6 +99,8 @@ bool CJoystickLinux::ScanEvents(void)
     // JS_EVENT_AXIS      0x02    // joystick moved
     // JS_EVENT_INIT      0x80    // (flag) initial state of device
 
+    TraceRawEvent(joyEvent.type, joyEvent.number, joyEvent.value);
+
     // Ignore initial events, because they mess up the buttons
     switch (joyEvent.type)
     {
@@ -35,6 +35,7 @@ namespace JOYSTICK
     // implementation of CJoystick
     virtual void Deinitialize(void) override;
     virtual bool Equals(const CJoystick* rhs) const override;
+    virtual void GetInputFds(std::vector<int>& fds) const override;
 
   protected:
     virtual bool ScanEvents(void) override;
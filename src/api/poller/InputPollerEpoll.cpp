@@ -0,0 +1,141 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "InputPollerEpoll.h"
+#include "api/Joystick.h"
+#include "log/Log.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#define INVALID_FD  (-1)
+
+CInputPollerEpoll::CInputPollerEpoll(void) :
+  m_epollFd(INVALID_FD)
+{
+}
+
+const char* CInputPollerEpoll::Name(void) const
+{
+  return "epoll";
+}
+
+bool CInputPollerEpoll::Initialize(void)
+{
+  m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epollFd < 0)
+  {
+    esyslog("[epoll]: Failed to create epoll instance: %s", strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+void CInputPollerEpoll::Deinitialize(void)
+{
+  if (m_epollFd >= 0)
+  {
+    close(m_epollFd);
+    m_epollFd = INVALID_FD;
+  }
+
+  m_joystickFds.clear();
+  m_events.clear();
+}
+
+bool CInputPollerEpoll::AddJoystick(CJoystick* joystick)
+{
+  std::vector<int> fds;
+  joystick->GetInputFds(fds);
+
+  std::vector<int>& added = m_joystickFds[joystick];
+
+  for (int fd : fds)
+  {
+    epoll_event event = { };
+    event.events = EPOLLIN;
+    event.data.ptr = joystick;
+
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+      esyslog("[epoll]: Failed to add fd %d of \"%s\": %s", fd, joystick->Name().c_str(), strerror(errno));
+      continue;
+    }
+
+    added.push_back(fd);
+  }
+
+  // Grown before a failed joystick is removed, which shrinks it by the
+  // number of added fds
+  m_events.resize(m_events.size() + added.size());
+
+  // Only poll joysticks whose fds were all added
+  if (added.empty() || added.size() != fds.size())
+  {
+    RemoveJoystick(joystick);
+    return false;
+  }
+
+  return true;
+}
+
+void CInputPollerEpoll::RemoveJoystick(CJoystick* joystick)
+{
+  auto it = m_joystickFds.find(joystick);
+  if (it == m_joystickFds.end())
+    return;
+
+  for (int fd : it->second)
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+  m_events.resize(m_events.size() - it->second.size());
+  m_joystickFds.erase(it);
+}
+
+bool CInputPollerEpoll::Poll(std::vector<CJoystick*>& readyJoysticks)
+{
+  readyJoysticks.clear();
+
+  if (m_events.empty())
+    return true;
+
+  const int count = epoll_wait(m_epollFd, m_events.data(), static_cast<int>(m_events.size()), 0);
+  if (count < 0)
+  {
+    if (errno == EINTR)
+      return false;
+
+    esyslog_ratelimited("[epoll]: Failed to wait for input: %s", strerror(errno));
+    return false;
+  }
+
+  for (int i = 0; i < count; i++)
+    readyJoysticks.push_back(static_cast<CJoystick*>(m_events[i].data.ptr));
+
+  std::sort(readyJoysticks.begin(), readyJoysticks.end());
+  readyJoysticks.erase(std::unique(readyJoysticks.begin(), readyJoysticks.end()), readyJoysticks.end());
+
+  return true;
+}
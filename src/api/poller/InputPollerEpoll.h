@@ -0,0 +1,52 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "api/IInputPoller.h"
+
+#include <map>
+#include <sys/epoll.h>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Input poller that waits on all fds with a single epoll_wait()
+   */
+  class CInputPollerEpoll : public IInputPoller
+  {
+  public:
+    CInputPollerEpoll(void);
+    virtual ~CInputPollerEpoll(void) { Deinitialize(); }
+
+    // implementation of IInputPoller
+    virtual const char* Name(void) const override;
+    virtual bool Initialize(void) override;
+    virtual void Deinitialize(void) override;
+    virtual bool AddJoystick(CJoystick* joystick) override;
+    virtual void RemoveJoystick(CJoystick* joystick) override;
+    virtual bool Poll(std::vector<CJoystick*>& readyJoysticks) override;
+
+  private:
+    int                                    m_epollFd;
+    std::map<CJoystick*, std::vector<int>>   m_joystickFds;
+    std::vector<epoll_event>               m_events; // Preallocated, one per fd
+  };
+}
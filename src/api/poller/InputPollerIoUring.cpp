@@ -0,0 +1,343 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "InputPollerIoUring.h"
+#include "api/Joystick.h"
+#include "log/Log.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#define INVALID_FD  (-1)
+
+#define RING_ENTRIES       64 // Submission queue size, the completion queue is twice as large
+#define CANCEL_USER_DATA   0  // User data of poll removals, whose completions are ignored
+
+// Multishot polls were added in Linux 5.13, along with resource tags
+#ifndef IORING_FEAT_RSRC_TAGS
+  #define IORING_FEAT_RSRC_TAGS  (1U << 10)
+#endif
+
+namespace
+{
+  int io_uring_setup(unsigned int entries, io_uring_params* params)
+  {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+  }
+
+  int io_uring_enter(int fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags)
+  {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+  }
+
+  void* MapRing(int fd, size_t size, off_t offset)
+  {
+    void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return ring != MAP_FAILED ? ring : nullptr;
+  }
+
+  unsigned int* RingPointer(void* ring, unsigned int offset)
+  {
+    return reinterpret_cast<unsigned int*>(static_cast<uint8_t*>(ring) + offset);
+  }
+}
+
+CInputPollerIoUring::CInputPollerIoUring(void) :
+  m_ringFd(INVALID_FD),
+  m_sqRing(nullptr),
+  m_sqRingSize(0),
+  m_cqRing(nullptr),
+  m_cqRingSize(0),
+  m_sqes(nullptr),
+  m_sqesSize(0),
+  m_sqHead(nullptr),
+  m_sqTail(nullptr),
+  m_sqMask(0),
+  m_sqEntries(0),
+  m_sqArray(nullptr),
+  m_cqHead(nullptr),
+  m_cqTail(nullptr),
+  m_cqMask(0),
+  m_cqes(nullptr),
+  m_pending(0),
+  m_nextId(CANCEL_USER_DATA + 1)
+{
+}
+
+const char* CInputPollerIoUring::Name(void) const
+{
+  return "io_uring";
+}
+
+bool CInputPollerIoUring::Initialize(void)
+{
+  io_uring_params params = { };
+
+  m_ringFd = io_uring_setup(RING_ENTRIES, &params);
+  if (m_ringFd < 0)
+  {
+    // Not built into the kernel, or blocked by a seccomp policy
+    dsyslog("[io_uring]: Failed to create ring: %s", strerror(errno));
+    return false;
+  }
+
+  if ((params.features & IORING_FEAT_RSRC_TAGS) == 0)
+  {
+    dsyslog("[io_uring]: Kernel doesn't support multishot polls");
+    Deinitialize();
+    return false;
+  }
+
+  m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+  // Since Linux 5.4, both rings share a mapping
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+  m_sqRing = MapRing(m_ringFd, m_sqRingSize, IORING_OFF_SQ_RING);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    m_cqRing = m_sqRing;
+  else if (m_sqRing != nullptr)
+    m_cqRing = MapRing(m_ringFd, m_cqRingSize, IORING_OFF_CQ_RING);
+
+  if (m_cqRing != nullptr)
+    m_sqes = static_cast<io_uring_sqe*>(MapRing(m_ringFd, m_sqesSize, IORING_OFF_SQES));
+
+  if (m_sqes == nullptr)
+  {
+    esyslog("[io_uring]: Failed to map rings: %s", strerror(errno));
+    Deinitialize();
+    return false;
+  }
+
+  m_sqHead = RingPointer(m_sqRing, params.sq_off.head);
+  m_sqTail = RingPointer(m_sqRing, params.sq_off.tail);
+  m_sqMask = *RingPointer(m_sqRing, params.sq_off.ring_mask);
+  m_sqEntries = *RingPointer(m_sqRing, params.sq_off.ring_entries);
+  m_sqArray = RingPointer(m_sqRing, params.sq_off.array);
+  m_cqHead = RingPointer(m_cqRing, params.cq_off.head);
+  m_cqTail = RingPointer(m_cqRing, params.cq_off.tail);
+  m_cqMask = *RingPointer(m_cqRing, params.cq_off.ring_mask);
+  m_cqes = reinterpret_cast<io_uring_cqe*>(static_cast<uint8_t*>(m_cqRing) + params.cq_off.cqes);
+
+  return true;
+}
+
+void CInputPollerIoUring::Deinitialize(void)
+{
+  if (m_sqes != nullptr)
+    munmap(m_sqes, m_sqesSize);
+  if (m_cqRing != nullptr && m_cqRing != m_sqRing)
+    munmap(m_cqRing, m_cqRingSize);
+  if (m_sqRing != nullptr)
+    munmap(m_sqRing, m_sqRingSize);
+
+  m_sqes = nullptr;
+  m_cqRing = nullptr;
+  m_sqRing = nullptr;
+
+  // Closing the ring cancels all polls
+  if (m_ringFd >= 0)
+  {
+    close(m_ringFd);
+    m_ringFd = INVALID_FD;
+  }
+
+  m_registrations.clear();
+  m_joystickIds.clear();
+  m_pending = 0;
+}
+
+bool CInputPollerIoUring::AddJoystick(CJoystick* joystick)
+{
+  std::vector<int> fds;
+  joystick->GetInputFds(fds);
+
+  if (fds.empty())
+    return false;
+
+  std::vector<uint64_t>& ids = m_joystickIds[joystick];
+
+  for (int fd : fds)
+  {
+    const uint64_t id = m_nextId++;
+
+    Registration& registration = m_registrations[id];
+    registration = { joystick, fd, false };
+    ids.push_back(id);
+
+    ArmPoll(id, registration);
+  }
+
+  // Submitted with the next poll
+  return true;
+}
+
+void CInputPollerIoUring::RemoveJoystick(CJoystick* joystick)
+{
+  auto it = m_joystickIds.find(joystick);
+  if (it == m_joystickIds.end())
+    return;
+
+  for (uint64_t id : it->second)
+  {
+    auto itRegistration = m_registrations.find(id);
+    if (itRegistration == m_registrations.end())
+      continue;
+
+    // The pending poll holds a reference to the file, so it must be removed
+    // for the device to be closed
+    if (itRegistration->second.bArmed)
+    {
+      io_uring_sqe* sqe = GetSqe();
+      if (sqe != nullptr)
+      {
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = id;
+        sqe->user_data = CANCEL_USER_DATA;
+      }
+    }
+
+    m_registrations.erase(itRegistration);
+  }
+
+  m_joystickIds.erase(it);
+
+  // Submit now, as the joystick's fds are about to be closed
+  Enter(false);
+}
+
+bool CInputPollerIoUring::Poll(std::vector<CJoystick*>& readyJoysticks)
+{
+  readyJoysticks.clear();
+
+  // Rearm polls that ended, submitted in the same syscall as the reap
+  for (auto& it : m_registrations)
+  {
+    if (!it.second.bArmed)
+      ArmPoll(it.first, it.second);
+  }
+
+  if (!Enter(true))
+    return false;
+
+  unsigned int head = *m_cqHead;
+  const unsigned int tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+
+  for (; head != tail; head++)
+  {
+    const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+
+    auto it = m_registrations.find(cqe.user_data);
+    if (it == m_registrations.end())
+      continue;
+
+    Registration& registration = it->second;
+
+    if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+      registration.bArmed = false;
+
+    // Errors are treated as readable, so the joystick is scanned and sees the
+    // error itself
+    if (cqe.res != 0 && cqe.res != -ECANCELED)
+      readyJoysticks.push_back(registration.joystick);
+  }
+
+  __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+  std::sort(readyJoysticks.begin(), readyJoysticks.end());
+  readyJoysticks.erase(std::unique(readyJoysticks.begin(), readyJoysticks.end()), readyJoysticks.end());
+
+  return true;
+}
+
+io_uring_sqe* CInputPollerIoUring::GetSqe(void)
+{
+  const unsigned int tail = *m_sqTail;
+
+  if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+  {
+    if (!Enter(false))
+      return nullptr;
+  }
+
+  const unsigned int index = tail & m_sqMask;
+
+  io_uring_sqe* sqe = &m_sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+
+  m_sqArray[index] = index;
+  __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+  m_pending++;
+
+  return sqe;
+}
+
+bool CInputPollerIoUring::ArmPoll(uint64_t id, Registration& registration)
+{
+  io_uring_sqe* sqe = GetSqe();
+  if (sqe == nullptr)
+    return false;
+
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = registration.fd;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  // The kernel reads the events as two 16-bit halves
+  sqe->poll32_events = (POLLIN << 16) | (POLLIN >> 16);
+#else
+  sqe->poll32_events = POLLIN;
+#endif
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = id;
+
+  registration.bArmed = true;
+
+  return true;
+}
+
+bool CInputPollerIoUring::Enter(bool bGetEvents)
+{
+  if (m_pending == 0 && !bGetEvents)
+    return true;
+
+  // Getting events also runs the completions queued by fd wakeups
+  const int ret = io_uring_enter(m_ringFd, m_pending, 0, bGetEvents ? IORING_ENTER_GETEVENTS : 0);
+  if (ret < 0)
+  {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+      esyslog_ratelimited("[io_uring]: Failed to enter ring: %s", strerror(errno));
+    return false;
+  }
+
+  m_pending -= std::min(m_pending, static_cast<unsigned int>(ret));
+
+  return true;
+}
@@ -0,0 +1,102 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "api/IInputPoller.h"
+
+#include <linux/io_uring.h>
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Input poller that keeps a multishot poll armed on every fd, and
+   *        collects the completions of all fds with one io_uring_enter()
+   *
+   * The kernel posts a completion each time an fd becomes readable, so a
+   * poll costs a single syscall regardless of the number of joysticks.
+   */
+  class CInputPollerIoUring : public IInputPoller
+  {
+  public:
+    CInputPollerIoUring(void);
+    virtual ~CInputPollerIoUring(void) { Deinitialize(); }
+
+    // implementation of IInputPoller
+    virtual const char* Name(void) const override;
+    virtual bool Initialize(void) override;
+    virtual void Deinitialize(void) override;
+    virtual bool AddJoystick(CJoystick* joystick) override;
+    virtual void RemoveJoystick(CJoystick* joystick) override;
+    virtual bool Poll(std::vector<CJoystick*>& readyJoysticks) override;
+
+  private:
+    struct Registration
+    {
+      CJoystick* joystick;
+      int        fd;
+      bool       bArmed; // A multishot poll is pending in the kernel
+    };
+
+    /*!
+     * \brief Queue a submission, flushing the queue first if it's full
+     */
+    io_uring_sqe* GetSqe(void);
+
+    /*!
+     * \brief Queue a multishot poll for a registration
+     */
+    bool ArmPoll(uint64_t id, Registration& registration);
+
+    /*!
+     * \brief Submit queued entries and optionally reap completions
+     */
+    bool Enter(bool bGetEvents);
+
+    // Ring
+    int           m_ringFd;
+    void*         m_sqRing;
+    size_t        m_sqRingSize;
+    void*         m_cqRing;
+    size_t        m_cqRingSize;
+    io_uring_sqe* m_sqes;
+    size_t        m_sqesSize;
+
+    // Pointers into the rings
+    unsigned int*  m_sqHead;
+    unsigned int*  m_sqTail;
+    unsigned int   m_sqMask;
+    unsigned int   m_sqEntries;
+    unsigned int*  m_sqArray;
+    unsigned int*  m_cqHead;
+    unsigned int*  m_cqTail;
+    unsigned int   m_cqMask;
+    io_uring_cqe*  m_cqes;
+    unsigned int   m_pending; // Queued entries that haven't been submitted
+
+    // Registrations
+    std::map<uint64_t, Registration>            m_registrations; // User data -> registration
+    std::map<CJoystick*, std::vector<uint64_t>> m_joystickIds;
+    uint64_t                                    m_nextId;
+  };
+}
@@ -22,7 +22,13 @@
 #include "JoystickUdev.h"
 #include "api/JoystickTypes.h"
 
+#if defined(HAVE_HIDRAW)
+  #include "api/hidraw/JoystickInterfaceHidraw.h"
+#endif
+
 #include <libudev.h>
+#include <map>
+#include <string>
 #include <utility>
 
 using namespace JOYSTICK;
@@ -95,6 +101,9 @@ bool CJoystickInterfaceUdev::ScanForJoysticks(JoystickVector& joysticks)
   udev_enumerate_add_match_property(enumerate, "ID_INPUT_JOYSTICK", "1");
   udev_enumerate_scan_devices(enumerate);
 
+  // Motion sensors are split into their own node by the kernel driver
+  std::map<std::string, std::string> motionSensors = GetMotionSensors();
+
   struct udev_list_entry* devs = udev_enumerate_get_list_entry(enumerate);
   for (struct udev_list_entry* item = devs; item != nullptr; item = udev_list_entry_get_next(item))
   {
@@ -102,9 +111,23 @@ bool CJoystickInterfaceUdev::ScanForJoysticks(JoystickVector& joysticks)
      struct udev_device* dev = udev_device_new_from_syspath(m_udev, name);
      const char*         devnode = udev_device_get_devnode(dev);
 
+     const std::string parentSyspath = GetParentSyspath(dev);
+
+#if defined(HAVE_HIDRAW)
+     // Read through hidraw instead
+     if (!parentSyspath.empty() && CJoystickInterfaceHidraw::IsClaimed(parentSyspath))
+       devnode = nullptr;
+#endif
+
      if (devnode != nullptr)
      {
-       JoystickPtr joystick = JoystickPtr(new CJoystickUdev(dev, devnode));
+       const char* motionPath = nullptr;
+
+       auto it = motionSensors.find(parentSyspath);
+       if (it != motionSensors.end())
+         motionPath = it->second.c_str();
+
+       JoystickPtr joystick = JoystickPtr(new CJoystickUdev(dev, devnode, motionPath));
        joysticks.push_back(joystick);
      }
 
@@ -115,6 +138,54 @@ bool CJoystickInterfaceUdev::ScanForJoysticks(JoystickVector& joysticks)
   return true;
 }
 
+std::map<std::string, std::string> CJoystickInterfaceUdev::GetMotionSensors()
+{
+  std::map<std::string, std::string> motionSensors;
+
+  struct udev_enumerate* enumerate = udev_enumerate_new(m_udev);
+  if (enumerate == nullptr)
+    return motionSensors;
+
+  // Set by udev's input_id builtin for nodes with INPUT_PROP_ACCELEROMETER
+  udev_enumerate_add_match_property(enumerate, "ID_INPUT_ACCELEROMETER", "1");
+  udev_enumerate_scan_devices(enumerate);
+
+  struct udev_list_entry* devs = udev_enumerate_get_list_entry(enumerate);
+  for (struct udev_list_entry* item = devs; item != nullptr; item = udev_list_entry_get_next(item))
+  {
+     const char*         name = udev_list_entry_get_name(item);
+     struct udev_device* dev = udev_device_new_from_syspath(m_udev, name);
+     const char*         devnode = udev_device_get_devnode(dev);
+
+     if (devnode != nullptr)
+     {
+       std::string parent = GetParentSyspath(dev);
+       if (!parent.empty())
+         motionSensors[parent] = devnode;
+     }
+
+     udev_device_unref(dev);
+  }
+
+  udev_enumerate_unref(enumerate);
+  return motionSensors;
+}
+
+std::string CJoystickInterfaceUdev::GetParentSyspath(udev_device* dev)
+{
+  // The pad and motion nodes are children of the same HID device. Don't
+  // worry about unref'ing the parent.
+  struct udev_device* parent = udev_device_get_parent_with_subsystem_devtype(dev, "hid", nullptr);
+  if (parent == nullptr)
+    return "";
+
+  const char* syspath = udev_device_get_syspath(parent);
+  if (syspath == nullptr)
+    return "";
+
+  return syspath;
+}
+
 const ButtonMap& CJoystickInterfaceUdev::GetButtonMap()
 {
   auto& dflt = m_buttonMap["game.controller.default"];
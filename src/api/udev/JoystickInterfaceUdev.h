@@ -41,6 +41,9 @@
 
 #include "api/IJoystickInterface.h"
 
+#include <map>
+#include <string>
+
 struct udev;
 struct udev_device;
 struct udev_monitor;
@@ -61,6 +64,18 @@ namespace JOYSTICK
     virtual const ButtonMap& GetButtonMap() override;
 
   private:
+    /*!
+     * \brief Get the motion sensor nodes, keyed by the syspath of their
+     *        parent HID device
+     */
+    std::map<std::string, std::string> GetMotionSensors();
+
+    /*!
+     * \brief Get the syspath of the HID device that a node belongs to, or
+     *        empty if the node isn't a HID device
+     */
+    static std::string GetParentSyspath(udev_device* dev);
+
     udev*         m_udev;
     udev_monitor* m_udev_mon;
 
@@ -21,15 +21,20 @@
 #include "JoystickUdev.h"
 #include "api/JoystickTypes.h"
 #include "log/Log.h"
+#include "metrics/Tracer.h"
+#include "storage/StorageManager.h"
 
 #include <algorithm>
 #include <errno.h>
 #include <fcntl.h>
 #include <libudev.h>
 #include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 using namespace JOYSTICK;
@@ -45,16 +50,53 @@ using namespace JOYSTICK;
 // From RetroArch
 #define NBITS(x)  ((((x) - 1) / (sizeof(long) * CHAR_BIT)) + 1)
 
-CJoystickUdev::CJoystickUdev(udev_device* dev, const char* path)
+#define set_bit(nr, addr) \
+   ((addr)[(nr) / (sizeof(long) * CHAR_BIT)] |= (1UL << ((nr) % (sizeof(long) * CHAR_BIT))))
+
+// Axis noise calibration
+#define AXIS_NOISE_SAMPLES        32 // Jittering events needed to learn an axis's noise
+#define AXIS_NOISE_LIMIT_DIVISOR  64 // Axis is at rest while it stays within 1/64 of its range
+#define AXIS_MAX_FUZZ_DIVISOR     32 // Fuzz is limited to 1/32 of the axis's range
+
+// Hat state by direction of the Y axis, then direction of the X axis
+static const JOYSTICK_STATE_HAT HAT_STATES[3][3] =
+{
+  { JOYSTICK_STATE_HAT_LEFT_UP,   JOYSTICK_STATE_HAT_UP,        JOYSTICK_STATE_HAT_RIGHT_UP   },
+  { JOYSTICK_STATE_HAT_LEFT,      JOYSTICK_STATE_HAT_UNPRESSED, JOYSTICK_STATE_HAT_RIGHT      },
+  { JOYSTICK_STATE_HAT_LEFT_DOWN, JOYSTICK_STATE_HAT_DOWN,      JOYSTICK_STATE_HAT_RIGHT_DOWN },
+};
+
+// Defined by kernel headers since 4.16
+#ifndef input_event_sec
+  #define input_event_sec   time.tv_sec
+  #define input_event_usec  time.tv_usec
+#endif
+
+// Defined by kernel headers since 4.4
+#ifndef INPUT_PROP_ACCELEROMETER
+  #define INPUT_PROP_ACCELEROMETER  0x06
+#endif
+
+CJoystickUdev::CJoystickUdev(udev_device* dev, const char* path, const char* motionPath /* = nullptr */)
  : CJoystick(INTERFACE_UDEV),
    m_dev(dev),
    m_path(path),
    m_deviceNumber(0),
    m_fd(INVALID_FD),
    m_bInitialized(false),
+   m_bMonotonicClock(false),
+   m_bGrabbed(false),
    m_effect(-1),
+   m_hats(),
    m_motors(),
-   m_previousMotors()
+   m_previousMotors(),
+   m_motionPath(motionPath != nullptr ? motionPath : ""),
+   m_motionDeviceNumber(0),
+   m_motionFd(INVALID_FD),
+   m_motionAxes(),
+   m_bCalibrationPending(false),
+   m_bRecenterPending(false),
+   m_mutex("JoystickUdev")
 {
   // Must initialize in the constructor to fill out joystick properties
   Initialize();
@@ -66,7 +108,9 @@ bool CJoystickUdev::Equals(const CJoystick* rhs) const
   if (rhsUdev == nullptr)
     return false;
 
-  return m_deviceNumber == rhsUdev->m_deviceNumber;
+  // A motion sensor that appears after its pad replaces the pad
+  return m_deviceNumber == rhsUdev->m_deviceNumber &&
+         m_motionDeviceNumber == rhsUdev->m_motionDeviceNumber;
 }
 
 bool CJoystickUdev::Initialize(void)
@@ -82,6 +126,9 @@ bool CJoystickUdev::Initialize(void)
     if (!CJoystick::Initialize())
       return false;
 
+    // Filter codes that aren't bound to a button or axis
+    UpdateEventMask(PrimitiveVector());
+
     m_bInitialized = true;
   }
 
@@ -92,10 +139,23 @@ void CJoystickUdev::Deinitialize(void)
 {
   if (m_fd >= 0)
   {
+    // Closing would release the grab too, but not before the fd's last
+    // reference is gone
+    SetExclusiveGrab(false);
+
+    // Calibration is shared by all readers of the device, so undo it
+    RestoreAbsCalibrations();
+
     close(m_fd);
     m_fd = INVALID_FD;
   }
 
+  if (m_motionFd >= 0)
+  {
+    close(m_motionFd);
+    m_motionFd = INVALID_FD;
+  }
+
   CJoystick::Deinitialize();
 }
 
@@ -107,7 +167,7 @@ void CJoystickUdev::ProcessEvents(void)
   std::array<uint16_t, MOTOR_COUNT> previousMotors;
 
   {
-    CLockObject lock(m_mutex);
+    CProfiledLockObject lock(m_mutex);
     motors         = m_motors;
     previousMotors = m_previousMotors;
   }
@@ -143,7 +203,7 @@ void CJoystickUdev::ProcessEvents(void)
   }
 
   {
-    CLockObject lock(m_mutex);
+    CProfiledLockObject lock(m_mutex);
     m_previousMotors = motors;
   }
 }
@@ -157,7 +217,7 @@ void CJoystickUdev::Play(bool bPlayStop)
   play.value = bPlayStop;
 
   if (write(m_fd, &play, sizeof(play)) < (ssize_t)sizeof(play))
-    esyslog("[udev]: Failed to play rumble effect %d on \"%s\" - %s", m_effect, Name().c_str(), strerror(errno));
+    esyslog_ratelimited("[udev]: Failed to play rumble effect %d on \"%s\" - %s", m_effect, Name().c_str(), strerror(errno));
 
   if (!bPlayStop)
     m_effect = -1;
@@ -174,7 +234,7 @@ void CJoystickUdev::UpdateMotorState(const std::array<uint16_t, MOTOR_COUNT>& mo
 
   if (ioctl(m_fd, EVIOCSFF, &e) < 0)
   {
-    esyslog("Failed to set rumble effect %d (0x%04x, 0x%04x) on \"%s\" - %s",
+    esyslog_ratelimited("Failed to set rumble effect %d (0x%04x, 0x%04x) on \"%s\" - %s",
         e.id, e.u.rumble.strong_magnitude, e.u.rumble.weak_magnitude,
         Name().c_str(), strerror(errno));
   }
@@ -184,6 +244,57 @@ void CJoystickUdev::UpdateMotorState(const std::array<uint16_t, MOTOR_COUNT>& mo
   }
 }
 
+void CJoystickUdev::GetInputFds(std::vector<int>& fds) const
+{
+  if (m_fd >= 0)
+    fds.push_back(m_fd);
+
+  if (m_motionFd >= 0)
+    fds.push_back(m_motionFd);
+}
+
+void CJoystickUdev::SetIgnoredPrimitives(const PrimitiveVector& primitives)
+{
+  CProfiledLockObject lock(m_mutex);
+
+  UpdateEventMask(primitives);
+}
+
+void CJoystickUdev::SetAxisCalibration(unsigned int axisIndex, unsigned int fuzz, unsigned int flat)
+{
+  CProfiledLockObject lock(m_mutex);
+
+  m_pendingCalibrations[axisIndex] = { fuzz, flat };
+
+  // Applied by the input thread, which owns the axis state
+  m_bCalibrationPending = true;
+}
+
+bool CJoystickUdev::SetExclusiveGrab(bool bExclusive)
+{
+  CProfiledLockObject lock(m_mutex);
+
+  if (m_fd < 0)
+    return false;
+
+  if (bExclusive == m_bGrabbed)
+    return true;
+
+  // While grabbed, the kernel only delivers events to this fd, so libinput,
+  // X and the js node stop processing the pad
+  if (ioctl(m_fd, EVIOCGRAB, bExclusive ? 1 : 0) < 0)
+  {
+    esyslog("[udev]: Failed to %s \"%s\": %s", bExclusive ? "grab" : "release", Name().c_str(), strerror(errno));
+    return false;
+  }
+
+  m_bGrabbed = bExclusive;
+
+  dsyslog("[udev]: %s \"%s\"", bExclusive ? "Grabbed" : "Released", Name().c_str());
+
+  return true;
+}
+
 bool CJoystickUdev::ScanEvents(void)
 {
   input_event events[32];
@@ -191,6 +302,14 @@ bool CJoystickUdev::ScanEvents(void)
   if (m_fd < 0)
     return false;
 
+  if (m_bCalibrationPending)
+    ApplyPendingCalibrations();
+
+  if (m_bRecenterPending)
+    ApplyPendingRecenters();
+
+  const int64_t scanTimeNs = GetEventTime();
+
   int len;
   while ((len = read(m_fd, events, sizeof(events))) > 0)
   {
@@ -201,6 +320,14 @@ bool CJoystickUdev::ScanEvents(void)
 
       int code = event.code;
 
+      // Stamp values with the kernel's time if it's on our clock
+      const int64_t eventTimeNs = static_cast<int64_t>(event.input_event_sec) * 1000000000 +
+                                  static_cast<int64_t>(event.input_event_usec) * 1000;
+      if (m_bMonotonicClock)
+        SetEventTime(eventTimeNs);
+
+      TraceRawEvent(event.type, event.code, event.value);
+
       switch (event.type)
       {
         case EV_KEY:
@@ -218,11 +345,18 @@ bool CJoystickUdev::ScanEvents(void)
         }
         case EV_ABS:
         {
-          if (code < ABS_MISC)
+          if (ABS_HAT0X <= code && code <= ABS_HAT3Y && m_hats[(code - ABS_HAT0X) / HAT_AXES].bPresent)
+          {
+            SetHatAxisValue(code, event.value);
+          }
+          else if (code < ABS_MISC)
           {
             auto it = m_axes_bind.find(code);
             if (it != m_axes_bind.end())
             {
+              if (!it->second.noise.bCalibrated)
+                LearnAxisNoise(code, it->second, event.value);
+
               const unsigned int axisIndex = it->second.axisIndex;
               const input_absinfo& info = it->second.axisInfo;
 
@@ -238,11 +372,207 @@ bool CJoystickUdev::ScanEvents(void)
           break;
       }
     }
+
+    // A short read means the queue is empty, so skip the read that would fail
+    if (static_cast<unsigned int>(len) < sizeof(events) / sizeof(*events))
+      break;
+  }
+
+  SetEventTime(scanTimeNs);
+
+  if (m_motionFd >= 0)
+    ScanMotionEvents();
+
+  return true;
+}
+
+void CJoystickUdev::ScanMotionEvents(void)
+{
+  // Sensors report at up to 1 kHz, so samples are accumulated instead of
+  // being reported individually
+  int len;
+  while ((len = read(m_motionFd, m_motionBatch.data(), m_motionBatch.size() * sizeof(input_event))) > 0)
+  {
+    len /= sizeof(input_event);
+    for (unsigned int i = 0; i < static_cast<unsigned int>(len); i++)
+    {
+      const input_event& event = m_motionBatch[i];
+
+      if (event.type != EV_ABS || event.code >= MOTION_AXES)
+        continue;
+
+      MotionAxis& axis = m_motionAxes[event.code];
+      if (axis.bPresent)
+      {
+        axis.sum += event.value;
+        axis.count++;
+      }
+    }
+
+    if (static_cast<size_t>(len) < m_motionBatch.size())
+      break;
+  }
+
+  // The mean is the average acceleration or angular velocity over the scan
+  // interval
+  for (MotionAxis& axis : m_motionAxes)
+  {
+    if (axis.count == 0)
+      continue;
+
+    const long value = static_cast<long>(axis.sum / static_cast<int64_t>(axis.count));
+
+    if (value >= 0)
+      SetAxisValue(axis.axisIndex, value, axis.maximum);
+    else
+      SetAxisValue(axis.axisIndex, value, -axis.minimum);
+
+    axis.sum = 0;
+    axis.count = 0;
+  }
+}
+
+void CJoystickUdev::SetHatAxisValue(unsigned int code, int value)
+{
+  Hat& hat = m_hats[(code - ABS_HAT0X) / HAT_AXES];
+  if (!hat.bPresent)
+    return;
+
+  const unsigned int hatAxis = (code - ABS_HAT0X) % HAT_AXES;
+
+  int direction = 0;
+  if (value < hat.center[hatAxis] - hat.threshold[hatAxis])
+    direction = -1;
+  else if (value > hat.center[hatAxis] + hat.threshold[hatAxis])
+    direction = 1;
+
+  hat.direction[hatAxis] = direction;
+
+  SetHatValue(hat.hatIndex, HAT_STATES[hat.direction[HAT_Y] + 1][hat.direction[HAT_X] + 1]);
+}
+
+void CJoystickUdev::LearnAxisNoise(unsigned int code, Axis& axis, int value)
+{
+  AxisNoise& noise = axis.noise;
+
+  const int range = axis.axisInfo.maximum - axis.axisInfo.minimum;
+  const int noiseLimit = std::max(range / AXIS_NOISE_LIMIT_DIVISOR, 1);
+
+  if (noise.samples == 0 || value < noise.restMax - noiseLimit || value > noise.restMin + noiseLimit)
+  {
+    // Axis moved, start over
+    noise.restMin = value;
+    noise.restMax = value;
+    noise.samples = 1;
+    return;
+  }
+
+  noise.restMin = std::min(noise.restMin, value);
+  noise.restMax = std::max(noise.restMax, value);
+
+  if (++noise.samples < AXIS_NOISE_SAMPLES)
+    return;
+
+  // The kernel drops changes within fuzz / 2 of the previous value
+  const int jitter = noise.restMax - noise.restMin;
+  unsigned int fuzz = std::min(2 * jitter + 2, std::max(range / AXIS_MAX_FUZZ_DIVISOR, 1));
+  fuzz = std::max(fuzz, static_cast<unsigned int>(axis.originalInfo.fuzz));
+
+  // Only centered axes (sticks) get a dead zone, triggers rest at an end
+  unsigned int flat = axis.originalInfo.flat;
+  const int center = axis.axisInfo.minimum + range / 2;
+  const int restCenter = noise.restMin + jitter / 2;
+  if (std::abs(restCenter - center) <= noiseLimit)
+    flat = std::max(flat, fuzz);
+
+  if (SetAbsCalibration(code, axis, fuzz, flat))
+  {
+    dsyslog("[udev]: \"%s\": Learned axis %u calibration, jitter %d, fuzz %u, flat %u",
+        Name().c_str(), axis.axisIndex, jitter, fuzz, flat);
+  }
+
+  // Don't retry on failure
+  noise.bCalibrated = true;
+}
+
+void CJoystickUdev::ApplyPendingCalibrations(void)
+{
+  std::map<unsigned int, AxisCalibration> calibrations;
+
+  {
+    CProfiledLockObject lock(m_mutex);
+    calibrations.swap(m_pendingCalibrations);
+    m_bCalibrationPending = false;
+  }
+
+  for (auto& it : m_axes_bind)
+  {
+    Axis& axis = it.second;
+
+    auto itCalibration = calibrations.find(axis.axisIndex);
+    if (itCalibration == calibrations.end())
+      continue;
+
+    const AxisCalibration& calibration = itCalibration->second;
+
+    SetAbsCalibration(it.first, axis, calibration.fuzz, calibration.flat);
+
+    // A configured calibration replaces learning
+    axis.noise.bCalibrated = true;
+  }
+}
+
+void CJoystickUdev::ApplyPendingRecenters(void)
+{
+  std::vector<unsigned int> recenters;
+
+  {
+    CProfiledLockObject lock(m_mutex);
+    recenters.swap(m_pendingRecenters);
+    m_bRecenterPending = false;
+  }
+
+  for (unsigned int axisIndex : recenters)
+    SetAxisValue(axisIndex, 0.0f);
+}
+
+bool CJoystickUdev::SetAbsCalibration(unsigned int code, Axis& axis, unsigned int fuzz, unsigned int flat)
+{
+  if (m_fd < 0)
+    return false;
+
+  if (static_cast<unsigned int>(axis.axisInfo.fuzz) == fuzz && static_cast<unsigned int>(axis.axisInfo.flat) == flat)
+    return true;
+
+  // Read the current value so that it isn't overwritten
+  input_absinfo info;
+  if (ioctl(m_fd, EVIOCGABS(code), &info) < 0)
+    return false;
+
+  info.fuzz = fuzz;
+  info.flat = flat;
+
+  if (ioctl(m_fd, EVIOCSABS(code), &info) < 0)
+  {
+    dsyslog("[udev]: \"%s\": Failed to set axis %u calibration: %s", Name().c_str(), axis.axisIndex, strerror(errno));
+    return false;
   }
 
+  axis.axisInfo.fuzz = fuzz;
+  axis.axisInfo.flat = flat;
+
   return true;
 }
 
+void CJoystickUdev::RestoreAbsCalibrations(void)
+{
+  for (auto& it : m_axes_bind)
+  {
+    Axis& axis = it.second;
+    SetAbsCalibration(it.first, axis, axis.originalInfo.fuzz, axis.originalInfo.flat);
+  }
+}
+
 bool CJoystickUdev::OpenJoystick()
 {
   unsigned long evbit[NBITS(EV_MAX)]   = { };
@@ -261,11 +591,19 @@ bool CJoystickUdev::OpenJoystick()
   if (!test_bit(EV_KEY, evbit))
     return false;
 
+#if defined(EVIOCSCLOCKID)
+  // Timestamp events with the clock used to order events across joysticks
+  int clockId = CLOCK_MONOTONIC;
+  m_bMonotonicClock = (ioctl(m_fd, EVIOCSCLOCKID, &clockId) == 0);
+#endif
+
   return true;
 }
 
 bool CJoystickUdev::GetProperties()
 {
+  TRACE_SPAN("CJoystickUdev::GetProperties");
+
   unsigned long keybit[NBITS(KEY_MAX)] = { };
   unsigned long absbit[NBITS(ABS_MAX)] = { };
   unsigned long ffbit[NBITS(FF_MAX)]   = { };
@@ -319,6 +657,7 @@ bool CJoystickUdev::GetProperties()
   SetButtonCount(m_button_bind.size());
 
   unsigned int axes = 0;
+  std::map<unsigned int, input_absinfo> hatAxes; // ABS_HAT code -> axis info
   for (unsigned i = 0; i < ABS_MISC; i++)
   {
     if (test_bit(i, absbit))
@@ -327,11 +666,48 @@ bool CJoystickUdev::GetProperties()
       if (ioctl(m_fd, EVIOCGABS(i), &abs) < 0)
         continue;
 
-      if (abs.maximum > abs.minimum)
-        m_axes_bind[i] = { axes++, abs };
+      if (abs.maximum <= abs.minimum)
+        continue;
+
+      if (ABS_HAT0X <= i && i <= ABS_HAT3Y)
+      {
+        // Hat axes are decoded into hats
+        Hat& hat = m_hats[(i - ABS_HAT0X) / HAT_AXES];
+        const unsigned int hatAxis = (i - ABS_HAT0X) % HAT_AXES;
+
+        hat.bPresent = true;
+        hat.center[hatAxis] = abs.minimum + (abs.maximum - abs.minimum) / 2;
+        hat.threshold[hatAxis] = (abs.maximum - abs.minimum) / 4;
+
+        hatAxes[i] = abs;
+      }
+      else
+      {
+        m_axes_bind[i] = { axes++, abs, abs, { } };
+      }
     }
   }
-  SetAxisCount(m_axes_bind.size());
+
+  if (!m_motionPath.empty())
+    OpenMotionSensor(axes);
+
+  unsigned int hats = 0;
+  for (Hat& hat : m_hats)
+  {
+    if (hat.bPresent)
+      hat.hatIndex = hats++;
+  }
+
+  // Button maps saved before hats were decoded bind the hat axes as axes
+  if (hats > 0 && HasLegacyButtonMap(axes, hats, hatAxes.size()))
+  {
+    dsyslog("[udev]: \"%s\": Keeping hat axes as axes for the saved button map", Name().c_str());
+    BindHatAxes(hatAxes, axes);
+    hats = 0;
+  }
+
+  SetAxisCount(axes);
+  SetHatCount(hats);
 
   // Check for rumble features
   if (ioctl(m_fd, EVIOCGBIT(EV_FF, sizeof(ffbit)), ffbit) >= 0)
@@ -344,6 +720,102 @@ bool CJoystickUdev::GetProperties()
   return true;
 }
 
+bool CJoystickUdev::HasLegacyButtonMap(unsigned int axes, unsigned int hats, unsigned int hatAxes) const
+{
+  ADDON::Joystick device(*this);
+  device.SetAxisCount(axes);
+  device.SetHatCount(hats);
+
+  ADDON::Joystick legacyDevice(*this);
+  legacyDevice.SetAxisCount(axes + hatAxes);
+  legacyDevice.SetHatCount(0);
+
+  // A map saved for the current layout replaces the legacy one
+  return !CStorageManager::Get().HasButtonMap(device) &&
+         CStorageManager::Get().HasButtonMap(legacyDevice);
+}
+
+void CJoystickUdev::BindHatAxes(const std::map<unsigned int, input_absinfo>& hatAxes, unsigned int& axes)
+{
+  for (const auto& it : hatAxes)
+    m_axes_bind[it.first] = { 0, it.second, it.second, { } };
+
+  m_hats.fill(Hat());
+
+  // Axes are numbered in ABS code order, followed by the motion axes
+  unsigned int axisIndex = 0;
+  for (auto& it : m_axes_bind)
+    it.second.axisIndex = axisIndex++;
+
+  for (MotionAxis& axis : m_motionAxes)
+  {
+    if (axis.bPresent)
+      axis.axisIndex += hatAxes.size();
+  }
+
+  axes += hatAxes.size();
+}
+
+bool CJoystickUdev::OpenMotionSensor(unsigned int& axes)
+{
+  unsigned long propbit[NBITS(INPUT_PROP_MAX)] = { };
+  unsigned long absbit[NBITS(ABS_MAX)]         = { };
+
+  m_motionFd = open(m_motionPath.c_str(), O_RDONLY | O_NONBLOCK);
+  if (m_motionFd < 0)
+  {
+    // Motion nodes aren't always tagged for user access
+    dsyslog("[udev]: \"%s\": Failed to open motion sensor %s: %s", Name().c_str(), m_motionPath.c_str(), strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (ioctl(m_motionFd, EVIOCGPROP(sizeof(propbit)), propbit) < 0 ||
+      !test_bit(INPUT_PROP_ACCELEROMETER, propbit) ||
+      ioctl(m_motionFd, EVIOCGBIT(EV_ABS, sizeof(absbit)), absbit) < 0 ||
+      fstat(m_motionFd, &st) < 0)
+  {
+    close(m_motionFd);
+    m_motionFd = INVALID_FD;
+    return false;
+  }
+  m_motionDeviceNumber = st.st_rdev;
+
+  for (unsigned int i = 0; i < MOTION_AXES; i++)
+  {
+    if (!test_bit(i, absbit))
+      continue;
+
+    input_absinfo abs;
+    if (ioctl(m_motionFd, EVIOCGABS(i), &abs) < 0)
+      continue;
+
+    if (abs.maximum <= 0 || abs.minimum >= 0)
+      continue;
+
+    m_motionAxes[i] = { true, axes++, abs.minimum, abs.maximum, 0, 0 };
+  }
+
+  m_motionBatch.resize(MOTION_BATCH_SIZE);
+
+#if defined(EVIOCSMASK)
+  // Drop MSC_TIMESTAMP, which is sent with every sample
+  unsigned long typeMask[NBITS(EV_CNT)] = { };
+  set_bit(EV_ABS, typeMask);
+
+  input_mask mask = { };
+  mask.type = 0;
+  mask.codes_size = sizeof(typeMask);
+  mask.codes_ptr = reinterpret_cast<uintptr_t>(typeMask);
+
+  ioctl(m_motionFd, EVIOCSMASK, &mask);
+#endif
+
+  dsyslog("[udev]: \"%s\": Opened motion sensor %s", Name().c_str(), m_motionPath.c_str());
+
+  return true;
+}
+
 bool CJoystickUdev::SetMotor(unsigned int motorIndex, float magnitude)
 {
   using namespace P8PLATFORM;
@@ -359,9 +831,116 @@ bool CJoystickUdev::SetMotor(unsigned int motorIndex, float magnitude)
 
   uint16_t strength = std::min(0xffff, static_cast<int>(magnitude * 0xffff));
 
-  CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   m_motors[motorIndex] = strength;
 
   return true;
 }
+
+bool CJoystickUdev::UpdateEventMask(const PrimitiveVector& ignoredPrimitives)
+{
+#if defined(EVIOCSMASK)
+  if (m_fd < 0)
+    return false;
+
+  std::set<unsigned int> ignoredButtons;
+  std::map<unsigned int, unsigned int> ignoredSemiaxes; // Axis index -> SEMIAXIS_* bits
+
+  for (const auto& primitive : ignoredPrimitives)
+  {
+    switch (primitive.Type())
+    {
+      case JOYSTICK_DRIVER_PRIMITIVE_TYPE_BUTTON:
+        ignoredButtons.insert(primitive.DriverIndex());
+        break;
+      case JOYSTICK_DRIVER_PRIMITIVE_TYPE_SEMIAXIS:
+        ignoredSemiaxes[primitive.DriverIndex()] |=
+            primitive.SemiAxisDirection() == JOYSTICK_DRIVER_SEMIAXIS_POSITIVE ? SEMIAXIS_POSITIVE : SEMIAXIS_NEGATIVE;
+        break;
+      default:
+        break;
+    }
+  }
+
+  // An axis is only masked when both of its directions are ignored
+  std::set<unsigned int> ignoredAxes;
+  for (const auto& it : ignoredSemiaxes)
+  {
+    if (it.second == SEMIAXIS_BOTH)
+      ignoredAxes.insert(it.first);
+  }
+
+  unsigned long typeMask[NBITS(EV_CNT)] = { };
+  unsigned long keyMask[NBITS(KEY_CNT)] = { };
+  unsigned long absMask[NBITS(ABS_CNT)] = { };
+
+  // EV_SYN is never filtered, and other types (EV_MSC, EV_FF status, etc.)
+  // aren't used
+  set_bit(EV_KEY, typeMask);
+  set_bit(EV_ABS, typeMask);
+
+  for (const auto& it : m_button_bind)
+  {
+    if (ignoredButtons.find(it.second) == ignoredButtons.end())
+      set_bit(it.first, keyMask);
+  }
+
+  for (const auto& it : m_axes_bind)
+  {
+    if (ignoredAxes.find(it.second.axisIndex) == ignoredAxes.end())
+      set_bit(it.first, absMask);
+  }
+
+  // The kernel stops reporting masked axes, so center any that were just
+  // masked instead of leaving them at their last value
+  for (unsigned int axisIndex : ignoredAxes)
+  {
+    if (m_maskedAxes.find(axisIndex) == m_maskedAxes.end())
+      m_pendingRecenters.push_back(axisIndex);
+  }
+  m_maskedAxes.swap(ignoredAxes);
+
+  if (!m_pendingRecenters.empty())
+    m_bRecenterPending = true;
+
+  for (unsigned int i = 0; i < m_hats.size(); i++)
+  {
+    if (m_hats[i].bPresent)
+    {
+      set_bit(ABS_HAT0X + i * HAT_AXES + HAT_X, absMask);
+      set_bit(ABS_HAT0X + i * HAT_AXES + HAT_Y, absMask);
+    }
+  }
+
+  // Type 0 sets the mask of event types
+  const struct { unsigned int type; const unsigned long* codes; size_t size; } masks[] =
+  {
+    { 0,      typeMask, sizeof(typeMask) },
+    { EV_KEY, keyMask,  sizeof(keyMask) },
+    { EV_ABS, absMask,  sizeof(absMask) },
+  };
+
+  for (const auto& entry : masks)
+  {
+    input_mask mask = { };
+    mask.type = entry.type;
+    mask.codes_size = entry.size;
+    mask.codes_ptr = reinterpret_cast<uintptr_t>(entry.codes);
+
+    if (ioctl(m_fd, EVIOCSMASK, &mask) < 0)
+    {
+      // Added in Linux 4.4
+      dsyslog("[udev]: Failed to set event mask for \"%s\": %s", Name().c_str(), strerror(errno));
+      return false;
+    }
+  }
+
+  dsyslog("[udev]: Masked events for \"%s\", ignoring %u buttons and %u axes", Name().c_str(),
+      static_cast<unsigned int>(ignoredButtons.size()), static_cast<unsigned int>(m_maskedAxes.size()));
+
+  return true;
+#else
+  return false;
+#endif
+}
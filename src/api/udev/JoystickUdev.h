@@ -40,12 +40,17 @@
  */
 
 #include "api/Joystick.h"
+#include "metrics/LockProfiler.h"
 
 #include "p8-platform/threads/mutex.h"
 
 #include <array>
+#include <atomic>
 #include <linux/input.h>
+#include <map>
+#include <set>
 #include <sys/types.h>
+#include <vector>
 
 struct udev_device;
 
@@ -61,7 +66,11 @@ namespace JOYSTICK
       MOTOR_COUNT  = 2,
     };
 
-    CJoystickUdev(udev_device* dev, const char* path);
+    /*!
+     * \param motionPath Path of the pad's motion sensor node, or nullptr if
+     *        the pad doesn't have one
+     */
+    CJoystickUdev(udev_device* dev, const char* path, const char* motionPath = nullptr);
     virtual ~CJoystickUdev(void) { Deinitialize(); }
 
     // implementation of CJoystick
@@ -69,6 +78,10 @@ namespace JOYSTICK
     virtual bool Initialize(void) override;
     virtual void Deinitialize(void) override;
     virtual void ProcessEvents(void) override;
+    virtual void GetInputFds(std::vector<int>& fds) const override;
+    virtual void SetIgnoredPrimitives(const PrimitiveVector& primitives) override;
+    virtual void SetAxisCalibration(unsigned int axisIndex, unsigned int fuzz, unsigned int flat) override;
+    virtual bool SetExclusiveGrab(bool bExclusive) override;
 
   protected:
     // implementation of CJoystick
@@ -79,28 +92,183 @@ namespace JOYSTICK
     void UpdateMotorState(const std::array<uint16_t, MOTOR_COUNT>& motors);
     void Play(bool bPlayStop);
 
+    /*!
+     * \brief Jitter observed while an axis is at rest
+     */
+    struct AxisNoise
+    {
+      int          restMin;
+      int          restMax;
+      unsigned int samples;
+      bool         bCalibrated; // Fuzz and flat have been set, learned or configured
+    };
+
     struct Axis
     {
       unsigned int  axisIndex;
       input_absinfo axisInfo;
+      input_absinfo originalInfo; // Restored when the device is closed
+      AxisNoise     noise;
+    };
+
+    struct AxisCalibration
+    {
+      unsigned int fuzz;
+      unsigned int flat;
+    };
+
+    enum
+    {
+      SEMIAXIS_NEGATIVE = 1 << 0,
+      SEMIAXIS_POSITIVE = 1 << 1,
+      SEMIAXIS_BOTH     = SEMIAXIS_NEGATIVE | SEMIAXIS_POSITIVE,
+    };
+
+    enum
+    {
+      HAT_X     = 0,
+      HAT_Y     = 1,
+      HAT_AXES  = 2,
+      HAT_CODES = 4, // ABS_HAT0X..ABS_HAT3Y
+    };
+
+    /*!
+     * \brief A hat reported as a pair of ABS_HAT axes
+     */
+    struct Hat
+    {
+      bool         bPresent;
+      unsigned int hatIndex;
+      int          center[HAT_AXES];
+      int          threshold[HAT_AXES];
+      int          direction[HAT_AXES]; // -1, 0 or 1
+    };
+
+    enum
+    {
+      MOTION_AXES       = 6,   // ABS_X..ABS_RZ, accelerometer then gyroscope
+      MOTION_BATCH_SIZE = 256, // Events read from the motion sensor per read()
+    };
+
+    /*!
+     * \brief Accelerometer or gyroscope axis of a motion sensor node
+     */
+    struct MotionAxis
+    {
+      bool         bPresent;
+      unsigned int axisIndex;
+      int          minimum;
+      int          maximum;
+      int64_t      sum;   // Sum of the samples since the last scan
+      unsigned int count; // Number of samples since the last scan
     };
 
     bool OpenJoystick();
     bool GetProperties();
 
+    /*!
+     * \brief Open the motion sensor node and append its axes to the pad's
+     *
+     * \param axes The pad's axis count, incremented for each motion axis
+     *
+     * \return true if the motion sensor was opened
+     */
+    bool OpenMotionSensor(unsigned int& axes);
+
+    /*!
+     * \brief Check if the device's only saved button map is for the layout
+     *        that bound hat axes as axes
+     *
+     * \param axes    The axis count with hats decoded
+     * \param hats    The hat count
+     * \param hatAxes The number of ABS_HAT axes
+     */
+    bool HasLegacyButtonMap(unsigned int axes, unsigned int hats, unsigned int hatAxes) const;
+
+    /*!
+     * \brief Bind the ABS_HAT axes as axes instead of hats
+     *
+     * \param axes The axis count, incremented for each hat axis
+     */
+    void BindHatAxes(const std::map<unsigned int, input_absinfo>& hatAxes, unsigned int& axes);
+
+    /*!
+     * \brief Drain the motion sensor and report the mean of each axis's
+     *        samples since the last scan
+     */
+    void ScanMotionEvents(void);
+
+    /*!
+     * \brief Update a hat from an ABS_HAT event
+     */
+    void SetHatAxisValue(unsigned int code, int value);
+
+    /*!
+     * \brief Ask the kernel to only queue events for bound, non-ignored codes
+     *
+     * \return true if the mask was installed
+     */
+    bool UpdateEventMask(const PrimitiveVector& ignoredPrimitives);
+
+    /*!
+     * \brief Learn the axis's rest noise, and set its fuzz and flat once
+     *        enough samples have been seen
+     */
+    void LearnAxisNoise(unsigned int code, Axis& axis, int value);
+
+    /*!
+     * \brief Apply calibrations received from SetAxisCalibration()
+     */
+    void ApplyPendingCalibrations(void);
+
+    /*!
+     * \brief Center the axes that UpdateEventMask() started masking
+     */
+    void ApplyPendingRecenters(void);
+
+    /*!
+     * \brief Set an axis's fuzz and flat in the kernel with EVIOCSABS
+     */
+    bool SetAbsCalibration(unsigned int code, Axis& axis, unsigned int fuzz, unsigned int flat);
+
+    /*!
+     * \brief Restore the fuzz and flat that the axes had when opened
+     */
+    void RestoreAbsCalibrations(void);
+
     // Udev properties
     udev_device* m_dev;
     std::string  m_path;
     dev_t        m_deviceNumber;
     int          m_fd;
     bool         m_bInitialized;
+    bool         m_bMonotonicClock; // Event timestamps use CLOCK_MONOTONIC
+    bool         m_bGrabbed;        // Holding EVIOCGRAB
     int          m_effect;
 
     // Joystick properties
     std::map<unsigned int, unsigned int> m_button_bind; // Maps keycodes -> button
     std::map<unsigned int, Axis>         m_axes_bind;   // Maps keycodes -> axis and axis info
+    std::array<Hat, HAT_CODES>           m_hats;        // Hats by ABS_HAT number
     std::array<uint16_t, MOTOR_COUNT>    m_motors;
     std::array<uint16_t, MOTOR_COUNT>    m_previousMotors;
-    P8PLATFORM::CMutex                   m_mutex;
+
+    // Motion sensor properties
+    std::string                         m_motionPath;
+    dev_t                               m_motionDeviceNumber;
+    int                                 m_motionFd;
+    std::array<MotionAxis, MOTION_AXES> m_motionAxes;  // Motion axes by ABS code
+    std::vector<input_event>            m_motionBatch; // Preallocated read buffer
+
+    // Axis calibration
+    std::map<unsigned int, AxisCalibration> m_pendingCalibrations; // Axis index -> configured calibration
+    std::atomic<bool>                       m_bCalibrationPending;
+
+    // Event mask
+    std::set<unsigned int>    m_maskedAxes;       // Axis indices masked in the kernel
+    std::vector<unsigned int> m_pendingRecenters; // Masked axis indices to center
+    std::atomic<bool>         m_bRecenterPending;
+
+    mutable CProfiledMutex               m_mutex;
   };
 }
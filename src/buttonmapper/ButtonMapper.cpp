@@ -20,18 +20,26 @@
 
 #include "ButtonMapper.h"
 #include "ControllerTransformer.h"
+#include "metrics/Metrics.h"
+#include "metrics/Tracer.h"
 #include "storage/IDatabase.h"
 
 #include "kodi_peripheral_utils.hpp"
 #include "libKODI_peripheral.h"
+#include "p8-platform/util/timeutils.h"
 
 #include <algorithm>
 #include <iterator>
 
 using namespace JOYSTICK;
 
+#define FEATURE_CACHE_SIZE         8    // Devices and controller profiles remembered
+#define FEATURE_CACHE_LIFETIME_MS  2000 // Matches the lifetime of loaded button maps
+
 CButtonMapper::CButtonMapper(ADDON::CHelper_libKODI_peripheral* peripheralLib) :
-  m_peripheralLib(peripheralLib)
+  m_peripheralLib(peripheralLib),
+  m_nextCacheEntry(0),
+  m_cacheMutex("ButtonMapper::cache")
 {
 }
 
@@ -47,6 +55,8 @@ bool CButtonMapper::Initialize(CJoystickFamilyManager& familyManager)
 
 void CButtonMapper::Deinitialize()
 {
+  InvalidateFeatures();
+
   m_controllerTransformer.reset();
   m_databases.clear();
 }
@@ -60,16 +70,117 @@ bool CButtonMapper::GetFeatures(const ADDON::Joystick& joystick,
                                 const std::string& strControllerId,
                                 FeatureVector& features)
 {
+  TRACE_SPAN("CButtonMapper::GetFeatures");
+
+  const int64_t nowMs = P8PLATFORM::GetTimeMs();
+
+  {
+    CProfiledLockObject lock(m_cacheMutex);
+
+    for (const FeatureCacheEntry& entry : m_featureCache)
+    {
+      if (IsCached(entry, joystick, strControllerId, nowMs))
+      {
+        features = entry.features;
+        return !features.empty();
+      }
+    }
+  }
+
   // Accumulate available button maps for this device
   ButtonMap accumulatedMap = GetButtonMap(joystick);
 
   GetFeatures(joystick, std::move(accumulatedMap), strControllerId, features);
 
+  UpdateCache(joystick, strControllerId, features, nowMs);
+
   return !features.empty();
 }
 
+void CButtonMapper::InvalidateFeatures()
+{
+  CProfiledLockObject lock(m_cacheMutex);
+
+  for (FeatureCacheEntry& entry : m_featureCache)
+    entry.bValid = false;
+}
+
+bool CButtonMapper::IsCached(const FeatureCacheEntry& entry, const ADDON::Joystick& joystick, const std::string& controllerId, int64_t nowMs) const
+{
+  if (!entry.bValid || nowMs >= entry.timestampMs + FEATURE_CACHE_LIFETIME_MS)
+    return false;
+
+  // Derived features change when the transformer learns a new map
+  if (m_controllerTransformer && entry.generation != m_controllerTransformer->Generation())
+    return false;
+
+  return entry.vendorId     == joystick.VendorID()    &&
+         entry.productId    == joystick.ProductID()   &&
+         entry.buttonCount  == joystick.ButtonCount() &&
+         entry.hatCount     == joystick.HatCount()    &&
+         entry.axisCount    == joystick.AxisCount()   &&
+         entry.controllerId == controllerId           &&
+         entry.name         == joystick.Name()        &&
+         entry.provider     == joystick.Provider();
+}
+
+void CButtonMapper::UpdateCache(const ADDON::Joystick& joystick, const std::string& controllerId, const FeatureVector& features, int64_t nowMs)
+{
+  CProfiledLockObject lock(m_cacheMutex);
+
+  // Reuse an entry for the same device and profile, then an invalid entry
+  auto it = std::find_if(m_featureCache.begin(), m_featureCache.end(),
+    [&joystick, &controllerId](const FeatureCacheEntry& entry)
+    {
+      return entry.controllerId == controllerId &&
+             entry.name == joystick.Name() &&
+             entry.provider == joystick.Provider();
+    });
+
+  if (it == m_featureCache.end())
+  {
+    it = std::find_if(m_featureCache.begin(), m_featureCache.end(),
+      [](const FeatureCacheEntry& entry)
+      {
+        return !entry.bValid;
+      });
+  }
+
+  if (it == m_featureCache.end())
+  {
+    if (m_featureCache.size() < FEATURE_CACHE_SIZE)
+    {
+      m_featureCache.emplace_back();
+      it = m_featureCache.end() - 1;
+    }
+    else
+    {
+      it = m_featureCache.begin() + m_nextCacheEntry;
+      m_nextCacheEntry = (m_nextCacheEntry + 1) % FEATURE_CACHE_SIZE;
+    }
+  }
+
+  FeatureCacheEntry& entry = *it;
+
+  entry.bValid       = true;
+  entry.timestampMs  = nowMs;
+  entry.generation   = m_controllerTransformer ? m_controllerTransformer->Generation() : 0;
+  entry.provider     = joystick.Provider();
+  entry.name         = joystick.Name();
+  entry.vendorId     = joystick.VendorID();
+  entry.productId    = joystick.ProductID();
+  entry.buttonCount  = joystick.ButtonCount();
+  entry.hatCount     = joystick.HatCount();
+  entry.axisCount    = joystick.AxisCount();
+  entry.controllerId = controllerId;
+  entry.features     = features;
+}
+
 ButtonMap CButtonMapper::GetButtonMap(const ADDON::Joystick& joystick) const
 {
+  TRACE_SPAN("CButtonMapper::GetButtonMap");
+  CMetricTimer timer(METRIC_MERGE_BUTTON_MAPS);
+
   ButtonMap accumulatedMap;
 
   for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
@@ -151,6 +262,8 @@ bool CButtonMapper::GetFeatures(const ADDON::Joystick& joystick, ButtonMap butto
   // Try to derive a button map from relations between controller profiles
   if (bNeedsFeatures)
   {
+    TRACE_SPAN("CButtonMapper::DeriveFeatures");
+
     FeatureVector derivedFeatures;
     DeriveFeatures(joystick, controllerId, buttonMap, derivedFeatures);
     MergeFeatures(features, derivedFeatures);
@@ -184,6 +297,7 @@ void CButtonMapper::DeriveFeatures(const ADDON::Joystick& joystick, const std::s
     const std::string& fromController = maxFeaturesIt->first;
     const FeatureVector& features = maxFeaturesIt->second;
 
+    CMetricTimer timer(METRIC_TRANSFORM_FEATURES);
     m_controllerTransformer->TransformFeatures(joystick, fromController, toController, features, transformedFeatures);
   }
 }
@@ -191,10 +305,21 @@ void CButtonMapper::DeriveFeatures(const ADDON::Joystick& joystick, const std::s
 void CButtonMapper::RegisterDatabase(const DatabasePtr& database)
 {
   if (std::find(m_databases.begin(), m_databases.end(), database) == m_databases.end())
+  {
     m_databases.push_back(database);
+    InvalidateFeatures();
+  }
 }
 
 void CButtonMapper::UnregisterDatabase(const DatabasePtr& database)
 {
   m_databases.erase(std::remove(m_databases.begin(), m_databases.end(), database), m_databases.end());
+  InvalidateFeatures();
+}
+
+void CButtonMapper::GetMemoryFootprint(StorageFootprint& footprint) const
+{
+  // Registered databases are owned and measured by the storage manager
+  if (m_controllerTransformer)
+    m_controllerTransformer->GetMemoryFootprint(footprint);
 }
@@ -20,10 +20,15 @@
 #pragma once
 
 #include "ButtonMapTypes.h"
+#include "metrics/LockProfiler.h"
 #include "storage/StorageTypes.h"
 
+#include "p8-platform/threads/mutex.h"
+
 #include <memory>
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace ADDON
 {
@@ -36,6 +41,7 @@ namespace JOYSTICK
   class CControllerTransformer;
   class CJoystickFamilyManager;
   class IDatabaseCallbacks;
+  struct StorageFootprint;
 
   class CButtonMapper
   {
@@ -48,11 +54,25 @@ namespace JOYSTICK
 
     IDatabaseCallbacks* GetCallbacks();
 
+    /*!
+     * \brief Get the features of a controller profile for a device
+     *
+     * Results are cached until the button maps change or the cache expires.
+     * A cached result is copied into the caller's vector, so a caller that
+     * reuses its vector doesn't allocate.
+     */
     bool GetFeatures(const ADDON::Joystick& joystick, const std::string& strDeviceId, FeatureVector& features);
 
+    /*!
+     * \brief Drop cached features after a button map was changed
+     */
+    void InvalidateFeatures(void);
+
     void RegisterDatabase(const DatabasePtr& database);
     void UnregisterDatabase(const DatabasePtr& database);
 
+    void GetMemoryFootprint(StorageFootprint& footprint) const;
+
   private:
     ButtonMap GetButtonMap(const ADDON::Joystick& joystick) const;
     static void MergeButtonMap(ButtonMap& accumulatedMap, const ButtonMap& newFeatures);
@@ -60,9 +80,35 @@ namespace JOYSTICK
     bool GetFeatures(const ADDON::Joystick& joystick, ButtonMap buttonMap, const std::string& controllerId, FeatureVector& features);
     void DeriveFeatures(const ADDON::Joystick& joystick, const std::string& toController, const ButtonMap& buttonMap, FeatureVector& transformedFeatures);
 
+    /*!
+     * \brief Features returned for a device and controller profile
+     */
+    struct FeatureCacheEntry
+    {
+      bool          bValid;
+      int64_t       timestampMs;
+      uint64_t      generation;  // Generation of the controller transformer
+      std::string   provider;
+      std::string   name;
+      uint16_t      vendorId;
+      uint16_t      productId;
+      unsigned int  buttonCount;
+      unsigned int  hatCount;
+      unsigned int  axisCount;
+      std::string   controllerId;
+      FeatureVector features;
+    };
+
+    bool IsCached(const FeatureCacheEntry& entry, const ADDON::Joystick& joystick, const std::string& controllerId, int64_t nowMs) const;
+    void UpdateCache(const ADDON::Joystick& joystick, const std::string& controllerId, const FeatureVector& features, int64_t nowMs);
+
     DatabaseVector    m_databases;
     std::unique_ptr<CControllerTransformer> m_controllerTransformer;
 
     ADDON::CHelper_libKODI_peripheral* m_peripheralLib;
+
+    std::vector<FeatureCacheEntry> m_featureCache;
+    unsigned int                   m_nextCacheEntry; // Replaced when the cache is full
+    CProfiledMutex                 m_cacheMutex;
   };
 }
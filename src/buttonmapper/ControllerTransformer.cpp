@@ -20,6 +20,7 @@
 
 #include "ControllerTransformer.h"
 #include "storage/Device.h"
+#include "storage/StorageFootprint.h"
 #include "utils/CommonMacros.h"
 
 #include "kodi_peripheral_utils.hpp"
@@ -29,12 +30,17 @@
 using namespace JOYSTICK;
 
 CControllerTransformer::CControllerTransformer(CJoystickFamilyManager& familyManager) :
-  m_familyManager(familyManager)
+  m_familyManager(familyManager),
+  m_generation(0),
+  m_mutex("ControllerTransformer")
 {
 }
 
 void CControllerTransformer::OnAdd(const DevicePtr& driverInfo, const ButtonMap& buttonMap)
 {
+  // Called by each database under its own lock
+  CProfiledLockObject lock(m_mutex);
+
   // Santity check
   if (m_observedDevices.size() > 200)
     return;
@@ -53,12 +59,16 @@ void CControllerTransformer::OnAdd(const DevicePtr& driverInfo, const ButtonMap&
       AddControllerMap(itFrom->first, itFrom->second, itTo->first, itTo->second);
     }
   }
+
+  m_generation++;
 }
 
 DevicePtr CControllerTransformer::CreateDevice(const CDevice& deviceInfo)
 {
   DevicePtr result = std::make_shared<CDevice>(deviceInfo);
 
+  CProfiledLockObject lock(m_mutex);
+
   for (const auto& device : m_observedDevices)
   {
     if (*device == deviceInfo)
@@ -68,6 +78,43 @@ DevicePtr CControllerTransformer::CreateDevice(const CDevice& deviceInfo)
   return result;
 }
 
+void CControllerTransformer::GetMemoryFootprint(StorageFootprint& footprint) const
+{
+  CProfiledLockObject lock(m_mutex);
+
+  for (const auto& it : m_controllerMap)
+  {
+    const ControllerTranslation& translation = it.first;
+    const FeatureMaps& featureMaps = it.second;
+
+    size_t bytes = CStorageFootprint::MapNode() + sizeof(ControllerMap::value_type);
+    bytes += CStorageFootprint::String(translation.fromController) + CStorageFootprint::String(translation.toController);
+
+    for (const auto& featureMap : featureMaps)
+    {
+      bytes += CStorageFootprint::MapNode() + sizeof(FeatureMaps::value_type);
+
+      for (const auto& feature : featureMap.first)
+      {
+        bytes += CStorageFootprint::MapNode() + sizeof(FeatureTranslation);
+        bytes += CStorageFootprint::String(feature.fromFeature) + CStorageFootprint::String(feature.toFeature);
+      }
+    }
+
+    footprint.controllerMap += bytes;
+    footprint.controllers[translation.fromController].controllerMap += bytes;
+  }
+
+  for (const auto& device : m_observedDevices)
+  {
+    footprint.observedDevices += CStorageFootprint::MapNode() + sizeof(DevicePtr);
+
+    // Devices still held by a database are counted there
+    if (device.use_count() == 1)
+      footprint.observedDevices += CStorageFootprint::SharedPointer() + CStorageFootprint::Device(*device);
+  }
+}
+
 bool CControllerTransformer::AddControllerMap(const std::string& controllerFrom, const FeatureVector& featuresFrom,
                                               const std::string& controllerTo, const FeatureVector& featuresTo)
 {
@@ -144,6 +191,8 @@ void CControllerTransformer::TransformFeatures(const ADDON::Joystick& driverInfo
                                                const FeatureVector& features,
                                                FeatureVector& transformedFeatures)
 {
+  CProfiledLockObject lock(m_mutex);
+
   bool bSwap = (fromController >= toController);
 
   ControllerTranslation needle = { bSwap ? toController : fromController,
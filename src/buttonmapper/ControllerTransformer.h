@@ -21,8 +21,13 @@
 
 #include "ButtonMapTypes.h"
 #include "JoystickFamily.h"
+#include "metrics/LockProfiler.h"
 #include "storage/IDatabase.h"
 
+#include "p8-platform/threads/mutex.h"
+
+#include <atomic>
+#include <stdint.h>
 #include <string>
 
 namespace ADDON
@@ -33,6 +38,7 @@ namespace ADDON
 namespace JOYSTICK
 {
   class CJoystickFamilyManager;
+  struct StorageFootprint;
 
   class CControllerTransformer : public IDatabaseCallbacks
   {
@@ -51,6 +57,17 @@ namespace JOYSTICK
                            const FeatureVector& features,
                            FeatureVector& transformedFeatures);
 
+    /*!
+     * \brief Number of times the controller map has been extended, used to
+     *        invalidate features derived from it
+     */
+    uint64_t Generation(void) const { return m_generation; }
+
+    /*!
+     * \brief Add the bytes held by the controller map and observed devices to a snapshot
+     */
+    void GetMemoryFootprint(StorageFootprint& footprint) const;
+
   private:
     bool AddControllerMap(const std::string& controllerFrom, const FeatureVector& featuresFrom,
                           const std::string& controllerTo, const FeatureVector& featuresTo);
@@ -58,5 +75,7 @@ namespace JOYSTICK
     ControllerMap           m_controllerMap;
     DeviceSet               m_observedDevices;
     CJoystickFamilyManager& m_familyManager;
+    std::atomic<uint64_t>   m_generation;
+    mutable CProfiledMutex  m_mutex;
   };
 }
@@ -19,6 +19,7 @@
  */
 
 #include "JoystickFamily.h"
+#include "storage/StorageFootprint.h"
 #include "storage/xml/JoystickFamiliesXml.h"
 #include "storage/xml/JoystickFamilyDefinitions.h"
 
@@ -69,3 +70,18 @@ const std::string& CJoystickFamilyManager::GetFamily(const std::string& name, co
 
   return empty;
 }
+
+size_t CJoystickFamilyManager::GetMemoryFootprint() const
+{
+  size_t bytes = 0;
+
+  for (const auto& family : m_families)
+  {
+    bytes += CStorageFootprint::MapNode() + sizeof(JoystickFamilyMap::value_type) + CStorageFootprint::String(family.first);
+
+    for (const auto& joystickName : family.second)
+      bytes += CStorageFootprint::MapNode() + sizeof(JoystickName) + CStorageFootprint::String(joystickName);
+  }
+
+  return bytes;
+}
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <set>
+#include <stddef.h>
 #include <string>
 
 namespace JOYSTICK
@@ -56,6 +57,11 @@ namespace JOYSTICK
 
     const std::string& GetFamily(const std::string& name, const std::string& provider) const;
 
+    /*!
+     * \brief Estimate the bytes held by the family map
+     */
+    size_t GetMemoryFootprint() const;
+
   private:
     bool LoadFamilies(const std::string& path);
 
@@ -19,6 +19,7 @@
  */
 
 #include "DirectoryCache.h"
+#include "storage/StorageFootprint.h"
 
 #include "p8-platform/util/timeutils.h"
 
@@ -109,3 +110,21 @@ void CDirectoryCache::UpdateDirectory(const std::string& path, const std::vector
   timestamp = P8PLATFORM::GetTimeMs();
   cachedItems = items;
 }
+
+size_t CDirectoryCache::GetMemoryFootprint(void) const
+{
+  size_t bytes = 0;
+
+  for (const auto& it : m_cache)
+  {
+    const ItemList& items = it.second.second;
+
+    bytes += CStorageFootprint::MapNode() + sizeof(ItemMap::value_type) + CStorageFootprint::String(it.first);
+    bytes += items.capacity() * sizeof(ADDON::CVFSDirEntry);
+
+    for (const auto& item : items)
+      bytes += CStorageFootprint::String(item.Label()) + CStorageFootprint::String(item.Path());
+  }
+
+  return bytes;
+}
@@ -22,6 +22,7 @@
 #include "kodi_vfs_utils.hpp"
 
 #include <map>
+#include <stddef.h>
 #include <stdint.h>
 #include <string>
 #include <vector>
@@ -46,6 +47,11 @@ namespace JOYSTICK
     bool GetDirectory(const std::string& path, std::vector<ADDON::CVFSDirEntry>& items);
     void UpdateDirectory(const std::string& path, const std::vector<ADDON::CVFSDirEntry>& items);
 
+    /*!
+     * \brief Estimate the bytes held by the cached directory listings
+     */
+    size_t GetMemoryFootprint(void) const;
+
   private:
     IDirectoryCacheCallback* m_callbacks;
 
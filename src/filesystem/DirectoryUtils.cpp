@@ -22,19 +22,35 @@
 #include "filesystem/vfs/VFSDirectoryUtils.h"
 #include "utils/CommonIncludes.h" // for libXBMC_addon.h
 
+#if defined(HAVE_POSIX_FILESYSTEM)
+  #include "filesystem/posix/PosixDirectoryUtils.h"
+  #include "filesystem/posix/PosixFileUtils.h"
+#endif
+
 using namespace JOYSTICK;
 
 ADDON::CHelper_libXBMC_addon* CDirectoryUtils::m_frontend = NULL;
+DirectoryUtilsPtr             CDirectoryUtils::m_vfsDirectoryUtils;
+DirectoryUtilsPtr             CDirectoryUtils::m_nativeDirectoryUtils;
 
 bool CDirectoryUtils::Initialize(ADDON::CHelper_libXBMC_addon* frontend)
 {
   m_frontend = frontend;
 
+  if (m_frontend)
+    m_vfsDirectoryUtils = DirectoryUtilsPtr(new CVFSDirectoryUtils(m_frontend));
+
+#if defined(HAVE_POSIX_FILESYSTEM)
+  m_nativeDirectoryUtils = DirectoryUtilsPtr(new CPosixDirectoryUtils);
+#endif
+
   return true;
 }
 
 void CDirectoryUtils::Deinitialize(void)
 {
+  m_nativeDirectoryUtils.reset();
+  m_vfsDirectoryUtils.reset();
   m_frontend = NULL;
 }
 
@@ -42,8 +58,8 @@ void CDirectoryUtils::Deinitialize(void)
 
 bool CDirectoryUtils::Create(const std::string& path)
 {
-  // Create directory utils
-  DirectoryUtilsPtr dirUtils = CreateDirectoryUtils(path);
+  // Get directory utils
+  DirectoryUtilsPtr dirUtils = GetDirectoryUtils(path);
   if (dirUtils)
     return dirUtils->Create(path);
 
@@ -52,8 +68,8 @@ bool CDirectoryUtils::Create(const std::string& path)
 
 bool CDirectoryUtils::Exists(const std::string& path)
 {
-  // Create directory utils
-  DirectoryUtilsPtr dirUtils = CreateDirectoryUtils(path);
+  // Get directory utils
+  DirectoryUtilsPtr dirUtils = GetDirectoryUtils(path);
   if (dirUtils)
     return dirUtils->Exists(path);
 
@@ -62,8 +78,8 @@ bool CDirectoryUtils::Exists(const std::string& path)
 
 bool CDirectoryUtils::Remove(const std::string& path)
 {
-  // Create directory utils
-  DirectoryUtilsPtr dirUtils = CreateDirectoryUtils(path);
+  // Get directory utils
+  DirectoryUtilsPtr dirUtils = GetDirectoryUtils(path);
   if (dirUtils)
     return dirUtils->Remove(path);
 
@@ -72,20 +88,20 @@ bool CDirectoryUtils::Remove(const std::string& path)
 
 bool CDirectoryUtils::GetDirectory(const std::string& path, const std::string& mask, std::vector<ADDON::CVFSDirEntry>& items)
 {
-  // Create directory utils
-  DirectoryUtilsPtr dirUtils = CreateDirectoryUtils(path);
+  // Get directory utils
+  DirectoryUtilsPtr dirUtils = GetDirectoryUtils(path);
   if (dirUtils)
     return dirUtils->GetDirectory(path, mask, items);
 
   return false;
 }
 
-DirectoryUtilsPtr CDirectoryUtils::CreateDirectoryUtils(const std::string& url)
+DirectoryUtilsPtr CDirectoryUtils::GetDirectoryUtils(const std::string& url)
 {
-  DirectoryUtilsPtr dirUtils;
-
-  if (m_frontend)
-    dirUtils = DirectoryUtilsPtr(new CVFSDirectoryUtils(m_frontend));
+#if defined(HAVE_POSIX_FILESYSTEM)
+  if (m_nativeDirectoryUtils && CPosixFileUtils::IsLocalPath(url))
+    return m_nativeDirectoryUtils;
+#endif
 
-  return dirUtils;
+  return m_vfsDirectoryUtils;
 }
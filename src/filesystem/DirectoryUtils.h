@@ -44,13 +44,15 @@ namespace JOYSTICK
 
   private:
     /*!
-     * \brief Create a directory utility instance to handle the specified URL
+     * \brief Get the directory utility instance to handle the specified URL
      *
      * \return The directory utility instance, or empty if no directory utility
      *         implementations can handle the URL
      */
-    static DirectoryUtilsPtr CreateDirectoryUtils(const std::string& url);
+    static DirectoryUtilsPtr GetDirectoryUtils(const std::string& url);
 
     static ADDON::CHelper_libXBMC_addon* m_frontend;
+    static DirectoryUtilsPtr             m_vfsDirectoryUtils;
+    static DirectoryUtilsPtr             m_nativeDirectoryUtils;
   };
 }
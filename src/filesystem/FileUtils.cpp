@@ -22,26 +22,42 @@
 #include "filesystem/vfs/VFSFileUtils.h"
 #include "utils/CommonIncludes.h" // for libXBMC_addon.h
 
+#if defined(HAVE_POSIX_FILESYSTEM)
+  #include "filesystem/posix/PosixFile.h"
+  #include "filesystem/posix/PosixFileUtils.h"
+#endif
+
 using namespace JOYSTICK;
 
 ADDON::CHelper_libXBMC_addon* CFileUtils::m_frontend = NULL;
+FileUtilsPtr                  CFileUtils::m_vfsFileUtils;
+FileUtilsPtr                  CFileUtils::m_nativeFileUtils;
 
 bool CFileUtils::Initialize(ADDON::CHelper_libXBMC_addon* frontend)
 {
   m_frontend = frontend;
 
+  if (m_frontend)
+    m_vfsFileUtils = FileUtilsPtr(new CVFSFileUtils(m_frontend));
+
+#if defined(HAVE_POSIX_FILESYSTEM)
+  m_nativeFileUtils = FileUtilsPtr(new CPosixFileUtils);
+#endif
+
   return true;
 }
 
 void CFileUtils::Deinitialize(void)
 {
+  m_nativeFileUtils.reset();
+  m_vfsFileUtils.reset();
   m_frontend = NULL;
 }
 
 bool CFileUtils::Exists(const std::string& url)
 {
-  // Create file utils
-  FileUtilsPtr fileUtils = CreateFileUtils(url);
+  // Get file utils
+  FileUtilsPtr fileUtils = GetFileUtils(url);
   if (fileUtils)
     return fileUtils->Exists(url);
 
@@ -50,8 +66,8 @@ bool CFileUtils::Exists(const std::string& url)
 
 bool CFileUtils::Stat(const std::string& url, STAT_STRUCTURE& buffer)
 {
-  // Create file utils
-  FileUtilsPtr fileUtils = CreateFileUtils(url);
+  // Get file utils
+  FileUtilsPtr fileUtils = GetFileUtils(url);
   if (fileUtils)
     return fileUtils->Stat(url, buffer);
 
@@ -60,9 +76,9 @@ bool CFileUtils::Stat(const std::string& url, STAT_STRUCTURE& buffer)
 
 bool CFileUtils::Rename(const std::string& url, const std::string& newUrl)
 {
-  // Create file utils
-  FileUtilsPtr fileUtils = CreateFileUtils(url);
-  if (fileUtils)
+  // Both URLs must be handled by the same implementation
+  FileUtilsPtr fileUtils = GetFileUtils(url);
+  if (fileUtils && fileUtils == GetFileUtils(newUrl))
     return fileUtils->Rename(url, newUrl);
 
   return false;
@@ -70,8 +86,8 @@ bool CFileUtils::Rename(const std::string& url, const std::string& newUrl)
 
 bool CFileUtils::Delete(const std::string& url)
 {
-  // Create file utils
-  FileUtilsPtr fileUtils = CreateFileUtils(url);
+  // Get file utils
+  FileUtilsPtr fileUtils = GetFileUtils(url);
   if (fileUtils)
     return fileUtils->Delete(url);
 
@@ -80,20 +96,35 @@ bool CFileUtils::Delete(const std::string& url)
 
 bool CFileUtils::SetHidden(const std::string& url, bool bHidden)
 {
-  // Create file utils
-  FileUtilsPtr fileUtils = CreateFileUtils(url);
+  // Get file utils
+  FileUtilsPtr fileUtils = GetFileUtils(url);
   if (fileUtils)
     return fileUtils->SetHidden(url, bHidden);
 
   return false;
 }
 
-FileUtilsPtr CFileUtils::CreateFileUtils(const std::string& url)
+FilePtr CFileUtils::OpenFile(const std::string& url, READ_FLAG flags /* = READ_FLAG_NONE */)
 {
-  FileUtilsPtr fileUtils;
+  FilePtr file;
 
-  if (m_frontend)
-    fileUtils = FileUtilsPtr(new CVFSFileUtils(m_frontend));
+#if defined(HAVE_POSIX_FILESYSTEM)
+  if (CPosixFileUtils::IsLocalPath(url))
+    file = FilePtr(new CPosixFile);
+#endif
+
+  if (file && !file->Open(url, flags))
+    file.reset();
+
+  return file;
+}
+
+FileUtilsPtr CFileUtils::GetFileUtils(const std::string& url)
+{
+#if defined(HAVE_POSIX_FILESYSTEM)
+  if (m_nativeFileUtils && CPosixFileUtils::IsLocalPath(url))
+    return m_nativeFileUtils;
+#endif
 
-  return fileUtils;
+  return m_vfsFileUtils;
 }
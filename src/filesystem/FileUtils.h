@@ -41,15 +41,25 @@ namespace JOYSTICK
     static bool Delete(const std::string& url);
     static bool SetHidden(const std::string& url, bool bHidden);
 
+    /*!
+     * \brief Open a file for reading
+     *
+     * \return The opened file, or empty if no file implementations can handle
+     *         the URL or the file could not be opened
+     */
+    static FilePtr OpenFile(const std::string& url, READ_FLAG flags = READ_FLAG_NONE);
+
   private:
     /*!
-     * \brief Create a file utilities instance to handle the specified URL
+     * \brief Get the file utilities instance to handle the specified URL
      *
      * \return The file utilities instance, or empty if no file utility
      *         implementations can handle the URL
      */
-    static FileUtilsPtr CreateFileUtils(const std::string& url);
+    static FileUtilsPtr GetFileUtils(const std::string& url);
 
     static ADDON::CHelper_libXBMC_addon* m_frontend;
+    static FileUtilsPtr                  m_vfsFileUtils;
+    static FileUtilsPtr                  m_nativeFileUtils;
   };
 }
@@ -100,6 +100,18 @@ namespace JOYSTICK
      */
     virtual int64_t ReadFile(std::string& buffer, const uint64_t maxBytes = 0) = 0;
 
+    /*!
+     * \brief Get a read-only view of the entire file
+     *
+     * \param data Set to the file's contents, which are NUL-terminated
+     * \param size Set to the number of bytes in the file
+     *
+     * The view remains valid until the file is closed.
+     *
+     * \return true if the view was created, false on error
+     */
+    virtual bool ReadView(const char*& data, uint64_t& size) = 0;
+
     /*!
      * \brief Write to a file open for writing
      *
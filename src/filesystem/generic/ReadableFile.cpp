@@ -28,6 +28,27 @@ using namespace JOYSTICK;
 #define READ_CHUNK_SIZE  (100 * 1024) // 100 KB
 
 int64_t CReadableFile::ReadFile(std::string& buffer, const uint64_t maxBytes /* = 0 */)
+{
+  // If the length is known, read the remainder of the file with a single
+  // Read() directly into the caller's buffer
+  if (buffer.empty())
+  {
+    const int64_t length = GetLength();
+    const int64_t position = GetPosition();
+    if (length > 0 && position >= 0 && position < length)
+    {
+      uint64_t bytesToRead = length - position;
+      if (maxBytes != 0)
+        bytesToRead = std::min(bytesToRead, maxBytes);
+
+      return Read(bytesToRead, buffer);
+    }
+  }
+
+  return ReadChunked(buffer, maxBytes);
+}
+
+int64_t CReadableFile::ReadChunked(std::string& buffer, const uint64_t maxBytes)
 {
   std::string chunkBuffer;
   chunkBuffer.reserve(READ_CHUNK_SIZE);
@@ -66,3 +87,25 @@ int64_t CReadableFile::ReadFile(std::string& buffer, const uint64_t maxBytes /*
 
   return bytesRead;
 }
+
+bool CReadableFile::ReadView(const char*& data, uint64_t& size)
+{
+  ReleaseView();
+
+  if (Seek(0) != 0 || ReadFile(m_viewBuffer) < 0)
+  {
+    ReleaseView();
+    return false;
+  }
+
+  // std::string guarantees NUL termination of c_str()
+  data = m_viewBuffer.c_str();
+  size = m_viewBuffer.size();
+
+  return true;
+}
+
+void CReadableFile::ReleaseView(void)
+{
+  std::string().swap(m_viewBuffer);
+}
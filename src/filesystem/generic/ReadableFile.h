@@ -21,6 +21,8 @@
 
 #include "filesystem/IFile.h"
 
+#include <string>
+
 namespace JOYSTICK
 {
   /*!
@@ -37,5 +39,24 @@ namespace JOYSTICK
      * \brief Read an entire file in chunks through calls to IFile::Read()
      */
     virtual int64_t ReadFile(std::string& buffer, const uint64_t maxBytes = 0) override;
+
+    /*!
+     * \brief Read the entire file into an internal buffer and return a view of it
+     */
+    virtual bool ReadView(const char*& data, uint64_t& size) override;
+
+  protected:
+    /*!
+     * \brief Release the buffer backing the last view
+     */
+    void ReleaseView(void);
+
+  private:
+    /*!
+     * \brief Read a file of unknown length in chunks, appending to buffer
+     */
+    int64_t ReadChunked(std::string& buffer, const uint64_t maxBytes);
+
+    std::string m_viewBuffer;
   };
 }
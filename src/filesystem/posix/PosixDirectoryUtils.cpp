@@ -0,0 +1,174 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PosixDirectoryUtils.h"
+#include "PosixFileUtils.h"
+
+#include <algorithm>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+  #include <sys/syscall.h>
+#endif
+
+using namespace JOYSTICK;
+
+// Size of buffer used for each getdents64() call
+#define DIRENT_BUFFER_SIZE  (8 * 1024) // 8 KB
+
+#if defined(__linux__)
+namespace JOYSTICK
+{
+  // glibc doesn't export a wrapper for getdents64() before 2.30
+  struct linux_dirent64
+  {
+    uint64_t       d_ino;
+    int64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+  };
+}
+#endif
+
+bool CPosixDirectoryUtils::Create(const std::string& path)
+{
+  const std::string strPath = CPosixFileUtils::TranslatePath(path);
+
+  if (mkdir(strPath.c_str(), 0755) == 0)
+    return true;
+
+  return errno == EEXIST && Exists(path);
+}
+
+bool CPosixDirectoryUtils::Exists(const std::string& path)
+{
+  struct stat buffer;
+  if (stat(CPosixFileUtils::TranslatePath(path).c_str(), &buffer) == 0)
+    return S_ISDIR(buffer.st_mode);
+
+  return false;
+}
+
+bool CPosixDirectoryUtils::Remove(const std::string& path)
+{
+  return rmdir(CPosixFileUtils::TranslatePath(path).c_str()) == 0;
+}
+
+bool CPosixDirectoryUtils::GetDirectory(const std::string& path, const std::string& mask, std::vector<ADDON::CVFSDirEntry>& items)
+{
+  std::string strPath = CPosixFileUtils::TranslatePath(path);
+
+  const int dirfd = openat(AT_FDCWD, strPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirfd < 0)
+    return false;
+
+  // Items are reported with the same prefix as the directory
+  std::string strPrefix = path;
+  if (strPrefix.empty() || strPrefix[strPrefix.size() - 1] != '/')
+    strPrefix += '/';
+
+  auto AddItem = [&](const char* name, unsigned char type)
+  {
+    // Skip ".", ".." and hidden files
+    if (name[0] == '.')
+      return;
+
+    struct stat buffer;
+    if (type == DT_UNKNOWN || type == DT_LNK)
+    {
+      // Type isn't reported by all filesystems, and links need to be resolved
+      if (fstatat(dirfd, name, &buffer, 0) != 0)
+        return;
+      type = S_ISDIR(buffer.st_mode) ? DT_DIR : DT_REG;
+    }
+
+    const bool bIsFolder = (type == DT_DIR);
+    if (!bIsFolder && (type != DT_REG || !MatchesMask(name, mask)))
+      return;
+
+    // Folders have a trailing slash, same as the frontend's VFS
+    std::string strItemPath = strPrefix + name;
+    if (bIsFolder)
+      strItemPath += '/';
+
+    items.push_back(ADDON::CVFSDirEntry(name, strItemPath, bIsFolder));
+  };
+
+#if defined(__linux__)
+  char buffer[DIRENT_BUFFER_SIZE];
+
+  long bytesRead;
+  while ((bytesRead = syscall(SYS_getdents64, dirfd, buffer, sizeof(buffer))) > 0)
+  {
+    for (long offset = 0; offset < bytesRead; )
+    {
+      const linux_dirent64* entry = reinterpret_cast<const linux_dirent64*>(buffer + offset);
+      AddItem(entry->d_name, entry->d_type);
+      offset += entry->d_reclen;
+    }
+  }
+
+  close(dirfd);
+
+  return bytesRead == 0;
+#else
+  // fdopendir() takes ownership of the file descriptor
+  DIR* dir = fdopendir(dirfd);
+  if (dir == nullptr)
+  {
+    close(dirfd);
+    return false;
+  }
+
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != nullptr)
+    AddItem(entry->d_name, entry->d_type);
+
+  closedir(dir);
+
+  return true;
+#endif
+}
+
+bool CPosixDirectoryUtils::MatchesMask(const std::string& filename, const std::string& mask)
+{
+  if (mask.empty())
+    return true;
+
+  const size_t extPos = filename.rfind('.');
+  if (extPos == std::string::npos)
+    return false;
+
+  // Mask looks like ".m4a|.flac|.aac|", compare case-insensitively
+  std::string strExtension = filename.substr(extPos) + "|";
+  std::transform(strExtension.begin(), strExtension.end(), strExtension.begin(), ::tolower);
+
+  std::string strMask = mask;
+  std::transform(strMask.begin(), strMask.end(), strMask.begin(), ::tolower);
+
+  const size_t maskPos = strMask.find(strExtension);
+  return maskPos != std::string::npos && (maskPos == 0 || strMask[maskPos - 1] == '|');
+}
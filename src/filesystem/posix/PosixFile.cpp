@@ -0,0 +1,262 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PosixFile.h"
+#include "PosixFileUtils.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#ifndef INVALID_FD
+  #define INVALID_FD  (-1)
+#endif
+
+// Size of buffer used when searching for the end of a line
+#define READ_LINE_CHUNK_SIZE  256
+
+CPosixFile::CPosixFile(void)
+  : m_fd(INVALID_FD),
+    m_mapping(nullptr),
+    m_mappingSize(0)
+{
+}
+
+bool CPosixFile::Open(const std::string& url, READ_FLAG flags /* = READ_FLAG_NONE */)
+{
+  Close();
+
+  m_fd = openat(AT_FDCWD, CPosixFileUtils::TranslatePath(url).c_str(), O_RDONLY | O_CLOEXEC);
+
+  return m_fd >= 0;
+}
+
+bool CPosixFile::OpenForWrite(const std::string& url, bool bOverWrite /* = false */)
+{
+  Close();
+
+  int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+  if (bOverWrite)
+    flags |= O_TRUNC;
+
+  m_fd = openat(AT_FDCWD, CPosixFileUtils::TranslatePath(url).c_str(), flags, 0644);
+
+  return m_fd >= 0;
+}
+
+int64_t CPosixFile::Read(uint64_t byteCount, std::string& buffer)
+{
+  if (m_fd < 0)
+    return -1;
+
+  buffer.resize(byteCount);
+
+  uint64_t bytesRead = 0;
+  while (bytesRead < byteCount)
+  {
+    const ssize_t result = read(m_fd, &buffer[bytesRead], byteCount - bytesRead);
+    if (result < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      buffer.clear();
+      return -1;
+    }
+
+    // End of file
+    if (result == 0)
+      break;
+
+    bytesRead += result;
+  }
+
+  buffer.resize(bytesRead);
+
+  return bytesRead;
+}
+
+int64_t CPosixFile::ReadLine(std::string& buffer)
+{
+  buffer.clear();
+
+  std::string chunk;
+  while (true)
+  {
+    const int64_t bytesRead = Read(READ_LINE_CHUNK_SIZE, chunk);
+    if (bytesRead < 0)
+      return -1;
+
+    if (bytesRead == 0)
+      break;
+
+    const size_t newline = chunk.find('\n');
+    if (newline != std::string::npos)
+    {
+      buffer.append(chunk, 0, newline + 1);
+
+      // Rewind to the start of the next line
+      if (lseek(m_fd, static_cast<off_t>(newline + 1) - bytesRead, SEEK_CUR) < 0)
+        return -1;
+
+      break;
+    }
+
+    buffer.append(chunk);
+  }
+
+  return buffer.size();
+}
+
+bool CPosixFile::ReadView(const char*& data, uint64_t& size)
+{
+  Unmap();
+
+  struct stat buffer;
+  if (m_fd < 0 || fstat(m_fd, &buffer) != 0)
+    return false;
+
+  const long pageSize = sysconf(_SC_PAGESIZE);
+
+  // The kernel zero-fills the remainder of the last page, so the mapping is
+  // NUL-terminated unless the file ends exactly on a page boundary
+  if (buffer.st_size > 0 && pageSize > 0 && buffer.st_size % pageSize != 0)
+  {
+    void* mapping = mmap(nullptr, buffer.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (mapping != MAP_FAILED)
+    {
+      m_mapping = mapping;
+      m_mappingSize = buffer.st_size;
+
+      data = static_cast<const char*>(m_mapping);
+      size = m_mappingSize;
+
+      return true;
+    }
+  }
+
+  // Fall back to reading the file into a single buffer
+  return CReadableFile::ReadView(data, size);
+}
+
+void CPosixFile::Unmap(void)
+{
+  if (m_mapping != nullptr)
+  {
+    munmap(m_mapping, m_mappingSize);
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+  }
+
+  ReleaseView();
+}
+
+int64_t CPosixFile::Write(uint64_t byteCount, const std::string& buffer)
+{
+  if (m_fd < 0)
+    return -1;
+
+  if (byteCount > buffer.size())
+    byteCount = buffer.size();
+
+  uint64_t bytesWritten = 0;
+  while (bytesWritten < byteCount)
+  {
+    const ssize_t result = write(m_fd, buffer.data() + bytesWritten, byteCount - bytesWritten);
+    if (result < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    bytesWritten += result;
+  }
+
+  return bytesWritten;
+}
+
+void CPosixFile::Flush(void)
+{
+  if (m_fd >= 0)
+    fsync(m_fd);
+}
+
+int64_t CPosixFile::Seek(int64_t filePosition, SEEK_FLAG whence /* = SEEK_FLAG_SET */)
+{
+  if (m_fd < 0)
+    return -1;
+
+  int posixWhence;
+  switch (whence)
+  {
+  case SEEK_FLAG_CUR:
+    posixWhence = SEEK_CUR;
+    break;
+  case SEEK_FLAG_END:
+    posixWhence = SEEK_END;
+    break;
+  case SEEK_FLAG_SET:
+  default:
+    posixWhence = SEEK_SET;
+    break;
+  }
+
+  return lseek(m_fd, filePosition, posixWhence);
+}
+
+bool CPosixFile::Truncate(uint64_t size)
+{
+  if (m_fd < 0)
+    return false;
+
+  return ftruncate(m_fd, size) == 0;
+}
+
+int64_t CPosixFile::GetPosition(void)
+{
+  if (m_fd < 0)
+    return -1;
+
+  return lseek(m_fd, 0, SEEK_CUR);
+}
+
+int64_t CPosixFile::GetLength(void)
+{
+  struct stat buffer;
+  if (m_fd < 0 || fstat(m_fd, &buffer) != 0)
+    return -1;
+
+  return buffer.st_size;
+}
+
+void CPosixFile::Close(void)
+{
+  Unmap();
+
+  if (m_fd >= 0)
+  {
+    close(m_fd);
+    m_fd = INVALID_FD;
+  }
+}
@@ -0,0 +1,87 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PosixFileUtils.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#define FILE_PROTOCOL  "file://"
+
+bool CPosixFileUtils::Exists(const std::string& url)
+{
+  struct stat buffer;
+  return stat(TranslatePath(url).c_str(), &buffer) == 0;
+}
+
+bool CPosixFileUtils::Stat(const std::string& url, STAT_STRUCTURE& buffer)
+{
+  struct stat statBuffer;
+  if (stat(TranslatePath(url).c_str(), &statBuffer) != 0)
+    return false;
+
+  buffer.deviceId         = statBuffer.st_dev;
+  buffer.size             = statBuffer.st_size;
+#if defined(__APPLE__)
+  buffer.accessTime       = statBuffer.st_atimespec;
+  buffer.modificationTime = statBuffer.st_mtimespec;
+  buffer.statusTime       = statBuffer.st_ctimespec;
+#else
+  buffer.accessTime       = statBuffer.st_atim;
+  buffer.modificationTime = statBuffer.st_mtim;
+  buffer.statusTime       = statBuffer.st_ctim;
+#endif
+  buffer.isDirectory      = S_ISDIR(statBuffer.st_mode);
+  buffer.isSymLink        = S_ISLNK(statBuffer.st_mode);
+  buffer.isHidden         = false;
+
+  return true;
+}
+
+bool CPosixFileUtils::Rename(const std::string& url, const std::string& newUrl)
+{
+  // renameat() atomically replaces newUrl if it exists
+  return renameat(AT_FDCWD, TranslatePath(url).c_str(), AT_FDCWD, TranslatePath(newUrl).c_str()) == 0;
+}
+
+bool CPosixFileUtils::Delete(const std::string& url)
+{
+  return unlink(TranslatePath(url).c_str()) == 0;
+}
+
+bool CPosixFileUtils::IsLocalPath(const std::string& url)
+{
+  if (url.compare(0, sizeof(FILE_PROTOCOL) - 1, FILE_PROTOCOL) == 0)
+    return true;
+
+  return !url.empty() && url[0] == '/';
+}
+
+std::string CPosixFileUtils::TranslatePath(const std::string& url)
+{
+  if (url.compare(0, sizeof(FILE_PROTOCOL) - 1, FILE_PROTOCOL) == 0)
+    return url.substr(sizeof(FILE_PROTOCOL) - 1);
+
+  return url;
+}
@@ -0,0 +1,57 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "filesystem/IFileUtils.h"
+
+#include <string>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Native file utilities for paths on the local filesystem
+   *
+   * Local paths are absolute POSIX paths or file:// URLs. These are handled
+   * directly by the OS instead of round-tripping through the frontend.
+   */
+  class CPosixFileUtils : public IFileUtils
+  {
+  public:
+    CPosixFileUtils(void) { }
+
+    virtual ~CPosixFileUtils(void) { }
+
+    // implementation of IFileUtils
+    virtual bool Exists(const std::string& url) override;
+    virtual bool Stat(const std::string& url, STAT_STRUCTURE& buffer) override;
+    virtual bool Rename(const std::string& url, const std::string& newUrl) override;
+    virtual bool Delete(const std::string& url) override;
+
+    /*!
+     * \brief Check if the URL refers to the local filesystem
+     */
+    static bool IsLocalPath(const std::string& url);
+
+    /*!
+     * \brief Translate a local URL to a path that can be passed to the OS
+     */
+    static std::string TranslatePath(const std::string& url);
+  };
+}
@@ -31,15 +31,20 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 using namespace JOYSTICK;
 using namespace P8PLATFORM;
 
 #define MAXSYSLOGBUF (256)
 
+#define LOG_FLUSH_INTERVAL_MS  20
+
 CLog::CLog(ILog* pipe)
  : m_pipe(pipe),
-   m_level(SYS_LOG_DEBUG)
+   m_level(SYS_LOG_DEBUG),
+   m_bAsync(false),
+   m_mutex("Log")
 {
 }
 
@@ -51,12 +56,13 @@ CLog& CLog::Get(void)
 
 CLog::~CLog(void)
 {
+  StopAsync();
   SetPipe(NULL);
 }
 
 bool CLog::SetType(SYS_LOG_TYPE type)
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
   if (m_pipe && m_pipe->Type() == type)
     return true; // Already set
 
@@ -84,7 +90,10 @@ bool CLog::SetType(SYS_LOG_TYPE type)
 
 void CLog::SetPipe(ILog* pipe)
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
+
+  // Queued messages belong to the old pipe
+  FlushLocked();
 
   const SYS_LOG_TYPE newType = pipe   ? pipe->Type()   : SYS_LOG_TYPE_NULL;
   const SYS_LOG_TYPE oldType = m_pipe ? m_pipe->Type() : SYS_LOG_TYPE_NULL;
@@ -95,7 +104,7 @@ void CLog::SetPipe(ILog* pipe)
 
 void CLog::SetLevel(SYS_LOG_LEVEL level)
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   const SYS_LOG_LEVEL newLevel = level;
   const SYS_LOG_LEVEL oldLevel = m_level;
@@ -105,22 +114,130 @@ void CLog::SetLevel(SYS_LOG_LEVEL level)
 
 void CLog::Log(SYS_LOG_LEVEL level, const char* format, ...)
 {
-  char fmt[MAXSYSLOGBUF];
-  char buf[MAXSYSLOGBUF];
+  if (!IsEnabled(level))
+    return;
+
   va_list ap;
+  va_start(ap, format);
+
+  if (m_bAsync.load(std::memory_order_acquire))
+  {
+    // Dropped messages are counted by the queue and reported on flush
+    m_queue.Push(level, format, ap);
+  }
+  else
+  {
+    char buf[MAXSYSLOGBUF];
+    vsnprintf(buf, sizeof(buf), format, ap); // TODO: Prepend CThread::ThreadId()
+
+    CProfiledLockObject lock(m_mutex);
+
+    // Preserve ordering with messages queued before async logging stopped
+    FlushLocked();
 
+    if (m_pipe)
+      m_pipe->Log(level, buf);
+  }
+
+  va_end(ap);
+}
+
+void CLog::LogRepeated(SYS_LOG_LEVEL level, CLogRateLimiter& rateLimiter, unsigned int suppressedCount, const char* format, ...)
+{
+  if (!IsEnabled(level))
+    return;
+
+  char buf[MAXSYSLOGBUF];
+
+  va_list ap;
   va_start(ap, format);
-  snprintf(fmt, sizeof(fmt), "%s", format); // TODO: Prepend CThread::ThreadId()
-  vsnprintf(buf, MAXSYSLOGBUF - 1, fmt, ap);
+  vsnprintf(buf, sizeof(buf), format, ap);
   va_end(ap);
 
-  P8PLATFORM::CLockObject lock(m_mutex);
+  // Used to report a count that is still pending when the interval ends
+  rateLimiter.SetLastMessage(level, buf);
 
-  if (level > m_level)
-    return;
+  if (suppressedCount > 0)
+    LogRepeatCount(level, buf, suppressedCount);
+  else
+    Log(level, "%s", buf);
+}
+
+void CLog::LogRepeatCount(SYS_LOG_LEVEL level, const char* message, unsigned int suppressedCount)
+{
+  char suffix[32];
+  const int suffixLength = snprintf(suffix, sizeof(suffix), " (repeated %u times)", suppressedCount);
+
+  // Truncate the message rather than the suffix
+  const int maxLength = MAXSYSLOGBUF - 1 - suffixLength;
+  const int messageLength = static_cast<int>(strnlen(message, maxLength));
+
+  Log(level, "%.*s%s", messageLength, message, suffix);
+}
+
+bool CLog::StartAsync(void)
+{
+  CProfiledLockObject lock(m_mutex);
+
+  if (m_bAsync)
+    return true; // Already started
+
+  if (!CreateThread(false))
+    return false;
+
+  m_bAsync = true;
+
+  return true;
+}
+
+void CLog::StopAsync(void)
+{
+  // Report messages suppressed after the last one that was logged
+  CLogRateLimiter::FlushSuppressed(false);
+
+  {
+    CProfiledLockObject lock(m_mutex);
+
+    if (!m_bAsync)
+      return;
+
+    m_bAsync = false;
+  }
+
+  StopThread();
+
+  Flush();
+}
+
+void CLog::Flush(void)
+{
+  CProfiledLockObject lock(m_mutex);
+  FlushLocked();
+}
+
+void CLog::FlushLocked(void)
+{
+  m_queue.Drain(m_pipe);
+
+  const uint64_t droppedCount = m_queue.TakeDroppedCount();
+  if (droppedCount > 0 && m_pipe)
+  {
+    char buf[MAXSYSLOGBUF];
+    snprintf(buf, sizeof(buf), "Log queue full, dropped %llu messages", static_cast<unsigned long long>(droppedCount));
+    m_pipe->Log(SYS_LOG_ERROR, buf);
+  }
+}
+
+void* CLog::Process(void)
+{
+  while (!IsStopped())
+  {
+    CLogRateLimiter::FlushSuppressed(true);
+    Flush();
+    Sleep(LOG_FLUSH_INTERVAL_MS);
+  }
 
-  if (m_pipe)
-    m_pipe->Log(level, buf);
+  return NULL;
 }
 
 const char* CLog::TypeToString(SYS_LOG_TYPE type)
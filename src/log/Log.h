@@ -21,26 +21,98 @@
 #pragma once
 
 #include "ILog.h"
+#include "LogQueue.h"
+#include "LogRateLimiter.h"
+#include "metrics/LockProfiler.h"
 
 #include "p8-platform/threads/mutex.h"
+#include "p8-platform/threads/threads.h"
+
+#include <atomic>
+
+/*!
+ * Log statements more verbose than JOYSTICK_LOG_LEVEL are compiled out
+ * entirely. Release builds keep errors and info by default; define
+ * JOYSTICK_LOG_LEVEL to override. Values match SYS_LOG_LEVEL.
+ */
+#ifndef JOYSTICK_LOG_LEVEL
+  #if defined(NDEBUG)
+    #define JOYSTICK_LOG_LEVEL  2 // SYS_LOG_INFO
+  #else
+    #define JOYSTICK_LOG_LEVEL  3 // SYS_LOG_DEBUG
+  #endif
+#endif
+
+/*!
+ * The level is checked before the arguments are evaluated or formatted, so
+ * disabled log statements cost a single relaxed load.
+ */
+#define JOYSTICK_LOG(level, ...) \
+  (JOYSTICK::CLog::Get().IsEnabled(level) ? JOYSTICK::CLog::Get().Log(level, __VA_ARGS__) : (void)0)
+
+/*!
+ * Compiled-out statements still type-check their arguments
+ */
+#define JOYSTICK_LOG_DISABLED(level, ...) \
+  (true ? (void)0 : JOYSTICK::CLog::Get().Log(level, __VA_ARGS__))
+
+/*!
+ * Rate-limited logging for statements that can fire on every poll. Each call
+ * site is limited independently (see CLogRateLimiter), and the number of
+ * suppressed messages is appended to the next message that gets through.
+ * Counts still pending when the interval ends are flushed by the background
+ * thread, and by StopAsync().
+ */
+#define JOYSTICK_LOG_RATELIMITED(level, ...) \
+  do \
+  { \
+    static JOYSTICK::CLogRateLimiter _rateLimiter; \
+    unsigned int _suppressedCount; \
+    if (JOYSTICK::CLog::Get().IsEnabled(level) && _rateLimiter.Allow(_suppressedCount)) \
+      JOYSTICK::CLog::Get().LogRepeated(level, _rateLimiter, _suppressedCount, __VA_ARGS__); \
+  } while (0)
 
 #ifndef esyslog
-#define esyslog(...) JOYSTICK::CLog::Get().Log(SYS_LOG_ERROR, __VA_ARGS__)
+#define esyslog(...) JOYSTICK_LOG(SYS_LOG_ERROR, __VA_ARGS__)
 #endif
 
 #ifndef isyslog
-#define isyslog(...) JOYSTICK::CLog::Get().Log(SYS_LOG_INFO, __VA_ARGS__)
+  #if JOYSTICK_LOG_LEVEL >= 2
+    #define isyslog(...) JOYSTICK_LOG(SYS_LOG_INFO, __VA_ARGS__)
+  #else
+    #define isyslog(...) JOYSTICK_LOG_DISABLED(SYS_LOG_INFO, __VA_ARGS__)
+  #endif
 #endif
 
 #ifndef dsyslog
-#define dsyslog(...) JOYSTICK::CLog::Get().Log(SYS_LOG_DEBUG, __VA_ARGS__)
+  #if JOYSTICK_LOG_LEVEL >= 3
+    #define dsyslog(...) JOYSTICK_LOG(SYS_LOG_DEBUG, __VA_ARGS__)
+  #else
+    #define dsyslog(...) JOYSTICK_LOG_DISABLED(SYS_LOG_DEBUG, __VA_ARGS__)
+  #endif
+#endif
+
+#define esyslog_ratelimited(...) JOYSTICK_LOG_RATELIMITED(SYS_LOG_ERROR, __VA_ARGS__)
+
+#if JOYSTICK_LOG_LEVEL >= 3
+  #define dsyslog_ratelimited(...) JOYSTICK_LOG_RATELIMITED(SYS_LOG_DEBUG, __VA_ARGS__)
+#else
+  #define dsyslog_ratelimited(...) JOYSTICK_LOG_DISABLED(SYS_LOG_DEBUG, __VA_ARGS__)
 #endif
 
 #define LOG_ERROR_STR(s)  esyslog("ERROR (%s,%d): %s: %m", __FILE__, __LINE__, s)
 
 namespace JOYSTICK
 {
-  class CLog
+  /*!
+   * \brief Process-wide logger
+   *
+   * By default, messages are written to the pipe synchronously. After
+   * StartAsync(), messages are formatted by the calling thread into a
+   * lock-free queue and written to the pipe by a background thread, so
+   * logging never blocks on the pipe or on other logging threads.
+   */
+  class CLog : private P8PLATFORM::CThread
   {
   private:
     CLog(ILog* pipe);
@@ -53,14 +125,61 @@ namespace JOYSTICK
     void SetPipe(ILog* pipe);
     void SetLevel(SYS_LOG_LEVEL level);
 
+    /*!
+     * \brief Check if messages of the given level will be logged
+     */
+    bool IsEnabled(SYS_LOG_LEVEL level) const { return level <= m_level.load(std::memory_order_relaxed); }
+
     void Log(SYS_LOG_LEVEL level, const char* format, ...);
 
+    /*!
+     * \brief Log a message, noting how many times it was suppressed by a
+     *        rate limiter
+     */
+    void LogRepeated(SYS_LOG_LEVEL level, CLogRateLimiter& rateLimiter, unsigned int suppressedCount, const char* format, ...);
+
+    /*!
+     * \brief Log a formatted message with a "(repeated N times)" suffix
+     *
+     * The message is truncated if needed so that the suffix is never lost.
+     */
+    void LogRepeatCount(SYS_LOG_LEVEL level, const char* message, unsigned int suppressedCount);
+
+    /*!
+     * \brief Start writing messages to the pipe from a background thread
+     */
+    bool StartAsync(void);
+
+    /*!
+     * \brief Stop the background thread and write any queued messages and
+     *        pending suppressed counts
+     */
+    void StopAsync(void);
+
+    /*!
+     * \brief Write any queued messages to the pipe
+     */
+    void Flush(void);
+
     static const char* TypeToString(SYS_LOG_TYPE type);
     static const char* LevelToString(SYS_LOG_LEVEL level);
 
+  protected:
+    // implementation of CThread
+    virtual void* Process(void) override;
+
   private:
-    ILog*            m_pipe;
-    SYS_LOG_LEVEL    m_level;
-    P8PLATFORM::CMutex m_mutex;
+    /*!
+     * \brief Write queued messages and report dropped messages
+     *
+     * NOTE: Must be called with m_mutex held
+     */
+    void FlushLocked(void);
+
+    ILog*                      m_pipe;
+    std::atomic<SYS_LOG_LEVEL> m_level;
+    std::atomic<bool>          m_bAsync;
+    CLogQueue                  m_queue;
+    CProfiledMutex             m_mutex;
   };
 }
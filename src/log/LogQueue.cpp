@@ -0,0 +1,103 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "LogQueue.h"
+
+#include <stdio.h>
+
+using namespace JOYSTICK;
+
+#define LOG_QUEUE_MASK  (LOG_QUEUE_SIZE - 1)
+
+static_assert((LOG_QUEUE_SIZE & LOG_QUEUE_MASK) == 0, "LOG_QUEUE_SIZE must be a power of two");
+
+CLogQueue::CLogQueue(void)
+ : m_writePosition(0),
+   m_readPosition(0),
+   m_droppedCount(0)
+{
+  // A record's sequence equals the write position that may claim it
+  for (size_t i = 0; i < LOG_QUEUE_SIZE; i++)
+    m_records[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool CLogQueue::Push(SYS_LOG_LEVEL level, const char* format, va_list args)
+{
+  LogRecord* record;
+
+  size_t position = m_writePosition.load(std::memory_order_relaxed);
+  while (true)
+  {
+    record = &m_records[position & LOG_QUEUE_MASK];
+
+    const size_t sequence = record->sequence.load(std::memory_order_acquire);
+    const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+    if (diff == 0)
+    {
+      // Record is free, try to claim it
+      if (m_writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      // Record still holds an unread message from the previous lap
+      m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    else
+    {
+      // Another producer claimed the record
+      position = m_writePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  record->level = level;
+  vsnprintf(record->message, sizeof(record->message), format, args);
+
+  // Publish the message to the consumer
+  record->sequence.store(position + 1, std::memory_order_release);
+
+  return true;
+}
+
+unsigned int CLogQueue::Drain(ILog* pipe)
+{
+  unsigned int count = 0;
+
+  while (true)
+  {
+    LogRecord& record = m_records[m_readPosition & LOG_QUEUE_MASK];
+
+    if (record.sequence.load(std::memory_order_acquire) != m_readPosition + 1)
+      break; // Queue is empty, or the next message is still being written
+
+    if (pipe)
+      pipe->Log(record.level, record.message);
+
+    // Release the record to producers on the next lap
+    record.sequence.store(m_readPosition + LOG_QUEUE_SIZE, std::memory_order_release);
+
+    m_readPosition++;
+    count++;
+  }
+
+  return count;
+}
@@ -0,0 +1,82 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "ILog.h"
+
+#include <atomic>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_QUEUE_SIZE     256 // Must be a power of two
+#define LOG_MESSAGE_SIZE   256 // Including NUL terminator
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Bounded lock-free queue of formatted log messages
+   *
+   * Any number of threads may call Push(). Only one thread at a time may call
+   * Drain(); the caller is responsible for serializing consumers.
+   *
+   * Messages are formatted directly into their slot, so a push never
+   * allocates. When the queue is full the message is discarded and counted.
+   */
+  class CLogQueue
+  {
+  public:
+    CLogQueue(void);
+
+    /*!
+     * \brief Format a message into the queue
+     *
+     * \return true if the message was queued, false if the queue was full
+     */
+    bool Push(SYS_LOG_LEVEL level, const char* format, va_list args);
+
+    /*!
+     * \brief Write all queued messages to the pipe, or discard them if the
+     *        pipe is NULL
+     *
+     * \return The number of messages removed from the queue
+     */
+    unsigned int Drain(ILog* pipe);
+
+    /*!
+     * \brief Get the number of messages dropped since the last call, and reset
+     *        the counter
+     */
+    uint64_t TakeDroppedCount(void) { return m_droppedCount.exchange(0, std::memory_order_relaxed); }
+
+  private:
+    struct LogRecord
+    {
+      std::atomic<size_t> sequence;
+      SYS_LOG_LEVEL       level;
+      char                message[LOG_MESSAGE_SIZE];
+    };
+
+    LogRecord             m_records[LOG_QUEUE_SIZE];
+    std::atomic<size_t>   m_writePosition;
+    size_t                m_readPosition;
+    std::atomic<uint64_t> m_droppedCount;
+  };
+}
@@ -0,0 +1,144 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "LogRateLimiter.h"
+#include "Log.h"
+
+#include "p8-platform/util/timeutils.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  /*!
+   * \brief Rate limiters with a static lifetime, so that pending counts can be
+   *        flushed
+   *
+   * Intentionally leaked so that the registry outlives every limiter and the
+   * logger, whatever their destruction order.
+   */
+  struct RateLimiterRegistry
+  {
+    std::vector<CLogRateLimiter*> limiters;
+    P8PLATFORM::CMutex            mutex;
+  };
+
+  RateLimiterRegistry& GetRegistry(void)
+  {
+    static RateLimiterRegistry* registry = new RateLimiterRegistry;
+    return *registry;
+  }
+}
+
+CLogRateLimiter::CLogRateLimiter(void)
+ : m_intervalEndMs(0),
+   m_allowedCount(0),
+   m_suppressedCount(0),
+   m_level(SYS_LOG_ERROR)
+{
+  m_lastMessage[0] = '\0';
+
+  RateLimiterRegistry& registry = GetRegistry();
+
+  P8PLATFORM::CLockObject lock(registry.mutex);
+  registry.limiters.push_back(this);
+}
+
+CLogRateLimiter::~CLogRateLimiter(void)
+{
+  RateLimiterRegistry& registry = GetRegistry();
+
+  P8PLATFORM::CLockObject lock(registry.mutex);
+  registry.limiters.erase(std::remove(registry.limiters.begin(), registry.limiters.end(), this), registry.limiters.end());
+}
+
+bool CLogRateLimiter::Allow(unsigned int& suppressedCount)
+{
+  P8PLATFORM::CLockObject lock(m_mutex);
+
+  const int64_t now = P8PLATFORM::GetTimeMs();
+  if (now >= m_intervalEndMs)
+  {
+    // Start a new interval
+    m_intervalEndMs = now + LOG_RATE_LIMIT_INTERVAL_MS;
+    m_allowedCount = 0;
+  }
+
+  if (m_allowedCount >= LOG_RATE_LIMIT_BURST)
+  {
+    m_suppressedCount++;
+    return false;
+  }
+
+  m_allowedCount++;
+
+  suppressedCount = m_suppressedCount;
+  m_suppressedCount = 0;
+
+  return true;
+}
+
+void CLogRateLimiter::SetLastMessage(SYS_LOG_LEVEL level, const char* message)
+{
+  P8PLATFORM::CLockObject lock(m_mutex);
+
+  m_level = level;
+  strncpy(m_lastMessage, message, sizeof(m_lastMessage) - 1);
+  m_lastMessage[sizeof(m_lastMessage) - 1] = '\0';
+}
+
+void CLogRateLimiter::FlushSuppressed(bool bExpiredOnly)
+{
+  RateLimiterRegistry& registry = GetRegistry();
+
+  P8PLATFORM::CLockObject registryLock(registry.mutex);
+
+  const int64_t now = P8PLATFORM::GetTimeMs();
+
+  for (CLogRateLimiter* limiter : registry.limiters)
+  {
+    SYS_LOG_LEVEL level;
+    unsigned int suppressedCount;
+    char message[LOG_MESSAGE_SIZE];
+
+    {
+      P8PLATFORM::CLockObject lock(limiter->m_mutex);
+
+      if (limiter->m_suppressedCount == 0)
+        continue;
+
+      if (bExpiredOnly && now < limiter->m_intervalEndMs)
+        continue;
+
+      level = limiter->m_level;
+      suppressedCount = limiter->m_suppressedCount;
+      strcpy(message, limiter->m_lastMessage);
+
+      limiter->m_suppressedCount = 0;
+    }
+
+    // Log outside the limiter's lock, logging may block on the pipe
+    CLog::Get().LogRepeatCount(level, message, suppressedCount);
+  }
+}
@@ -0,0 +1,82 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "ILog.h"
+#include "LogQueue.h"
+
+#include "p8-platform/threads/mutex.h"
+
+#include <stdint.h>
+
+#define LOG_RATE_LIMIT_INTERVAL_MS  5000 // Length of each rate limiting interval
+#define LOG_RATE_LIMIT_BURST        5    // Messages allowed per interval
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Limits how often a single log statement is written
+   *
+   * Each rate-limited call site owns one instance. Up to LOG_RATE_LIMIT_BURST
+   * messages are allowed per interval; the rest are counted, and the count is
+   * reported with the next message that is allowed through. If no message
+   * gets through, the count is reported with a copy of the last allowed
+   * message by FlushSuppressed().
+   */
+  class CLogRateLimiter
+  {
+  public:
+    CLogRateLimiter(void);
+    ~CLogRateLimiter(void);
+
+    /*!
+     * \brief Check if a message should be logged
+     *
+     * \param suppressedCount Set to the number of messages suppressed since the
+     *        last allowed message, if the message should be logged
+     *
+     * \return true if the message should be logged, false to suppress it
+     */
+    bool Allow(unsigned int& suppressedCount);
+
+    /*!
+     * \brief Remember the last allowed message so that a pending count can
+     *        be reported without it
+     */
+    void SetLastMessage(SYS_LOG_LEVEL level, const char* message);
+
+    /*!
+     * \brief Log the counts of messages suppressed after each call site's
+     *        last allowed message
+     *
+     * \param bExpiredOnly Only report call sites whose interval has ended,
+     *        otherwise report all pending counts
+     */
+    static void FlushSuppressed(bool bExpiredOnly);
+
+  private:
+    int64_t            m_intervalEndMs;
+    unsigned int       m_allowedCount;
+    unsigned int       m_suppressedCount;
+    SYS_LOG_LEVEL      m_level;
+    char               m_lastMessage[LOG_MESSAGE_SIZE];
+    P8PLATFORM::CMutex m_mutex;
+  };
+}
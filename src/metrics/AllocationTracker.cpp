@@ -0,0 +1,109 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AllocationTracker.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  thread_local AllocationStats threadStats = { };
+
+  void* Allocate(std::size_t size)
+  {
+    threadStats.allocations++;
+    threadStats.bytes += size;
+
+    return std::malloc(size != 0 ? size : 1);
+  }
+
+  void Deallocate(void* ptr)
+  {
+    if (ptr != nullptr)
+    {
+      threadStats.deallocations++;
+      std::free(ptr);
+    }
+  }
+}
+
+void* operator new(std::size_t size)
+{
+  void* ptr = Allocate(size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+  void* ptr = Allocate(size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+  Deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  Deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  Deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  Deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+  Deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+  Deallocate(ptr);
+}
+
+AllocationStats CAllocationTracker::GetThreadStats(void)
+{
+  return threadStats;
+}
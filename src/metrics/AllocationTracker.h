@@ -0,0 +1,72 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+namespace JOYSTICK
+{
+  struct AllocationStats
+  {
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t bytes;        // Bytes requested by allocations
+  };
+
+  /*!
+   * \brief Heap allocation accounting for finding allocations on hot paths
+   *
+   * Replaces the global operator new and operator delete with versions that
+   * count allocations per thread. The tracker is only linked into the tests,
+   * never into the shipped add-on.
+   */
+  class CAllocationTracker
+  {
+  public:
+    /*!
+     * \brief Get the allocations made by the calling thread so far
+     */
+    static AllocationStats GetThreadStats(void);
+  };
+
+  /*!
+   * \brief Counts the allocations made by the calling thread during the
+   *        lifetime of the object
+   */
+  class CAllocationScope
+  {
+  public:
+    CAllocationScope(void) : m_start(CAllocationTracker::GetThreadStats()) { }
+
+    /*!
+     * \brief Get the allocations made since the scope was entered
+     */
+    AllocationStats GetStats(void) const
+    {
+      const AllocationStats now = CAllocationTracker::GetThreadStats();
+      return AllocationStats{ now.allocations - m_start.allocations,
+                              now.deallocations - m_start.deallocations,
+                              now.bytes - m_start.bytes };
+    }
+
+  private:
+    const AllocationStats m_start;
+  };
+}
@@ -0,0 +1,218 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "LockProfiler.h"
+
+#if defined(JOYSTICK_LOCK_PROFILING)
+
+#include "log/Log.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  uint64_t NowNs(void)
+  {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  }
+
+  void UpdateMax(std::atomic<uint64_t>& maximum, uint64_t value)
+  {
+    uint64_t current = maximum.load(std::memory_order_relaxed);
+    while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+  }
+}
+
+// --- CProfiledMutex ----------------------------------------------------------
+
+CProfiledMutex::CProfiledMutex(const char* name)
+ : m_name(name),
+   m_depth(0),
+   m_acquireTimeNs(0),
+   m_acquisitions(0),
+   m_contentions(0),
+   m_waitNs(0),
+   m_maxWaitNs(0),
+   m_holdNs(0),
+   m_maxHoldNs(0)
+{
+  CLockProfiler::Get().Register(this);
+}
+
+CProfiledMutex::~CProfiledMutex(void)
+{
+  CLockProfiler::Get().Unregister(this);
+}
+
+bool CProfiledMutex::Lock(void)
+{
+  // Uncontended acquisitions cost a single clock read
+  if (m_mutex.TryLock())
+  {
+    OnAcquired(0, false);
+    return true;
+  }
+
+  const uint64_t startNs = NowNs();
+  const bool bLocked = m_mutex.Lock();
+  if (bLocked)
+    OnAcquired(NowNs() - startNs, true);
+
+  return bLocked;
+}
+
+bool CProfiledMutex::TryLock(void)
+{
+  if (!m_mutex.TryLock())
+  {
+    m_contentions.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  OnAcquired(0, false);
+  return true;
+}
+
+void CProfiledMutex::Unlock(void)
+{
+  if (--m_depth == 0)
+  {
+    const uint64_t holdNs = NowNs() - m_acquireTimeNs;
+    m_holdNs.fetch_add(holdNs, std::memory_order_relaxed);
+    UpdateMax(m_maxHoldNs, holdNs);
+  }
+
+  m_mutex.Unlock();
+}
+
+void CProfiledMutex::OnAcquired(uint64_t waitNs, bool bContended)
+{
+  // Recursive acquisitions extend the outermost hold
+  if (m_depth++ > 0)
+    return;
+
+  m_acquireTimeNs = NowNs();
+
+  m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if (bContended)
+  {
+    m_contentions.fetch_add(1, std::memory_order_relaxed);
+    m_waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    UpdateMax(m_maxWaitNs, waitNs);
+  }
+}
+
+// --- CLockProfiler -----------------------------------------------------------
+
+CLockProfiler& CLockProfiler::Get(void)
+{
+  static CLockProfiler _instance;
+  return _instance;
+}
+
+void CLockProfiler::Register(CProfiledMutex* mutex)
+{
+  P8PLATFORM::CLockObject lock(m_mutex);
+  m_mutexes.insert(mutex);
+}
+
+void CLockProfiler::Unregister(CProfiledMutex* mutex)
+{
+  P8PLATFORM::CLockObject lock(m_mutex);
+
+  if (m_mutexes.erase(mutex) > 0)
+  {
+    LockStats& stats = m_retiredStats[mutex->Name()];
+    stats.name = mutex->Name();
+    Accumulate(*mutex, stats);
+  }
+}
+
+std::vector<LockStats> CLockProfiler::GetStats(void) const
+{
+  std::map<std::string, LockStats> statsByName;
+
+  {
+    P8PLATFORM::CLockObject lock(m_mutex);
+
+    statsByName = m_retiredStats;
+
+    for (const CProfiledMutex* mutex : m_mutexes)
+    {
+      LockStats& stats = statsByName[mutex->Name()];
+      stats.name = mutex->Name();
+      Accumulate(*mutex, stats);
+    }
+  }
+
+  std::vector<LockStats> result;
+  result.reserve(statsByName.size());
+  for (const auto& it : statsByName)
+    result.push_back(it.second);
+
+  std::sort(result.begin(), result.end(),
+    [](const LockStats& lhs, const LockStats& rhs)
+    {
+      return lhs.waitNs > rhs.waitNs;
+    });
+
+  return result;
+}
+
+void CLockProfiler::LogReport(unsigned int maxLocks) const
+{
+  const std::vector<LockStats> stats = GetStats();
+
+  isyslog("Lock profile (worst %u of %u locks by total wait time):", std::min(maxLocks, static_cast<unsigned int>(stats.size())),
+      static_cast<unsigned int>(stats.size()));
+
+  for (unsigned int i = 0; i < stats.size() && i < maxLocks; i++)
+  {
+    const LockStats& lock = stats[i];
+
+    const double contendedPercent = lock.acquisitions > 0 ? 100.0 * lock.contentions / lock.acquisitions : 0.0;
+
+    isyslog("  %-24s acquired %llu, contended %llu (%.1f%%), wait %.3f ms (max %.3f ms), hold %.3f ms (max %.3f ms)",
+        lock.name.c_str(),
+        static_cast<unsigned long long>(lock.acquisitions),
+        static_cast<unsigned long long>(lock.contentions),
+        contendedPercent,
+        lock.waitNs / 1e6, lock.maxWaitNs / 1e6,
+        lock.holdNs / 1e6, lock.maxHoldNs / 1e6);
+  }
+}
+
+void CLockProfiler::Accumulate(const CProfiledMutex& mutex, LockStats& stats)
+{
+  stats.acquisitions += mutex.m_acquisitions.load(std::memory_order_relaxed);
+  stats.contentions  += mutex.m_contentions.load(std::memory_order_relaxed);
+  stats.waitNs       += mutex.m_waitNs.load(std::memory_order_relaxed);
+  stats.maxWaitNs     = std::max(stats.maxWaitNs, mutex.m_maxWaitNs.load(std::memory_order_relaxed));
+  stats.holdNs       += mutex.m_holdNs.load(std::memory_order_relaxed);
+  stats.maxHoldNs     = std::max(stats.maxHoldNs, mutex.m_maxHoldNs.load(std::memory_order_relaxed));
+}
+
+#endif // JOYSTICK_LOCK_PROFILING
@@ -0,0 +1,142 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "p8-platform/threads/mutex.h"
+
+#if defined(JOYSTICK_LOCK_PROFILING)
+  #include <atomic>
+  #include <map>
+  #include <set>
+  #include <stdint.h>
+  #include <string>
+  #include <vector>
+#endif
+
+namespace JOYSTICK
+{
+#if defined(JOYSTICK_LOCK_PROFILING)
+
+  /*!
+   * \brief Mutex that records wait time, hold time and contention
+   *
+   * Must be locked through CProfiledLockObject. Locks that share a name are
+   * reported together, e.g. the mutexes of all udev joysticks.
+   */
+  class CProfiledMutex
+  {
+  public:
+    CProfiledMutex(const char* name);
+    ~CProfiledMutex(void);
+
+    bool Lock(void);
+    bool TryLock(void);
+    void Unlock(void);
+
+    const char* Name(void) const { return m_name; }
+
+  private:
+    friend class CLockProfiler;
+
+    void OnAcquired(uint64_t waitNs, bool bContended);
+
+    const char*           m_name;
+    P8PLATFORM::CMutex    m_mutex;
+
+    // Written by the lock holder only
+    unsigned int          m_depth;       // Recursion depth
+    uint64_t              m_acquireTimeNs;
+
+    std::atomic<uint64_t> m_acquisitions;
+    std::atomic<uint64_t> m_contentions;
+    std::atomic<uint64_t> m_waitNs;
+    std::atomic<uint64_t> m_maxWaitNs;
+    std::atomic<uint64_t> m_holdNs;
+    std::atomic<uint64_t> m_maxHoldNs;
+  };
+
+  class CProfiledLockObject
+  {
+  public:
+    CProfiledLockObject(CProfiledMutex& mutex) : m_mutex(mutex) { m_mutex.Lock(); }
+    ~CProfiledLockObject(void) { m_mutex.Unlock(); }
+
+  private:
+    CProfiledMutex& m_mutex;
+  };
+
+  struct LockStats
+  {
+    std::string name;
+    uint64_t    acquisitions;
+    uint64_t    contentions;
+    uint64_t    waitNs;
+    uint64_t    maxWaitNs;
+    uint64_t    holdNs;
+    uint64_t    maxHoldNs;
+  };
+
+  /*!
+   * \brief Registry of profiled mutexes
+   */
+  class CLockProfiler
+  {
+  private:
+    CLockProfiler(void) { }
+
+  public:
+    static CLockProfiler& Get(void);
+
+    void Register(CProfiledMutex* mutex);
+    void Unregister(CProfiledMutex* mutex);
+
+    /*!
+     * \brief Get statistics per lock name, sorted by total wait time
+     */
+    std::vector<LockStats> GetStats(void) const;
+
+    /*!
+     * \brief Log the locks with the most wait time
+     */
+    void LogReport(unsigned int maxLocks) const;
+
+  private:
+    static void Accumulate(const CProfiledMutex& mutex, LockStats& stats);
+
+    std::set<CProfiledMutex*>        m_mutexes;
+    std::map<std::string, LockStats> m_retiredStats; // Stats of destroyed mutexes
+    mutable P8PLATFORM::CMutex       m_mutex;
+  };
+
+#else
+
+  /*!
+   * \brief Plain mutex when lock profiling is disabled at build time
+   */
+  class CProfiledMutex : public P8PLATFORM::CMutex
+  {
+  public:
+    CProfiledMutex(const char* name) { (void)name; }
+  };
+
+  typedef P8PLATFORM::CLockObject CProfiledLockObject;
+
+#endif
+}
@@ -0,0 +1,386 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Metrics.h"
+
+#include <stdio.h>
+#include <sstream>
+
+using namespace JOYSTICK;
+using namespace P8PLATFORM;
+
+#define METRICS_DUMP_INTERVAL_MS  10000
+#define METRICS_PREFIX            "joystick_"
+
+static_assert(METRICS_BUCKET_COUNT % METRICS_SUB_BUCKETS == 0, "Bucket count must be a multiple of the sub-bucket count");
+
+namespace
+{
+  struct MetricInfo
+  {
+    const char* name;
+    const char* help;
+  };
+
+  const MetricInfo COUNTER_INFO[] =
+  {
+    { "events_total",             "Events returned by GetEvents()" },
+    { "button_maps_loaded_total", "Button map files parsed" },
+    { "sanitized_features_total", "Features removed from button maps by sanitizing" },
+  };
+
+  const MetricInfo HISTOGRAM_INFO[] =
+  {
+    { "perform_device_scan_seconds", "Time spent in PerformDeviceScan()" },
+    { "get_events_seconds",          "Time spent in GetEvents()" },
+    { "send_event_seconds",          "Time spent in SendEvent()" },
+    { "get_features_seconds",        "Time spent in GetFeatures()" },
+    { "map_features_seconds",        "Time spent in MapFeatures()" },
+    { "save_button_map_seconds",     "Time spent in SaveButtonMap()" },
+    { "xml_parse_seconds",           "Time spent loading and parsing XML files" },
+    { "index_directory_seconds",     "Time spent indexing button map folders" },
+    { "merge_button_maps_seconds",   "Time spent merging button maps from all databases" },
+    { "transform_features_seconds",  "Time spent deriving features from other controller profiles" },
+    { "sanitize_seconds",            "Time spent sanitizing loaded button maps" },
+    { "poll_input_seconds",          "Time spent waiting on all joystick fds for pending input" },
+    { "diff_states_seconds",         "Time spent comparing all joysticks' states to their previous states" },
+    { "scan_events_seconds",         "Time spent reading a joystick's driver state" },
+    { "emit_events_seconds",         "Time spent turning a joystick's state changes into events" },
+  };
+
+  static_assert(sizeof(COUNTER_INFO) / sizeof(COUNTER_INFO[0]) == METRIC_COUNTER_COUNT, "Missing counter name");
+  static_assert(sizeof(HISTOGRAM_INFO) / sizeof(HISTOGRAM_INFO[0]) == METRIC_HISTOGRAM_COUNT, "Missing histogram name");
+
+  unsigned int HighestBit(uint64_t value)
+  {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    unsigned int bit = 0;
+    while (value >>= 1)
+      bit++;
+    return bit;
+#endif
+  }
+
+  // Only the owning thread writes to a block, so a relaxed load and store
+  // avoids the cost of an atomic read-modify-write
+  void Add(std::atomic<uint64_t>& value, uint64_t amount)
+  {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+  }
+}
+
+// --- HistogramSnapshot -------------------------------------------------------
+
+uint64_t HistogramSnapshot::Quantile(double quantile) const
+{
+  if (count == 0)
+    return 0;
+
+  const double rank = quantile * count;
+
+  uint64_t cumulative = 0;
+  for (unsigned int i = 0; i < buckets.size(); i++)
+  {
+    cumulative += buckets[i];
+    if (cumulative > 0 && cumulative >= rank)
+      return CMetrics::BucketUpperBound(i);
+  }
+
+  return CMetrics::BucketUpperBound(buckets.size() - 1);
+}
+
+// --- CMetrics ----------------------------------------------------------------
+
+CMetrics::CMetrics(void)
+{
+}
+
+CMetrics& CMetrics::Get(void)
+{
+  static CMetrics _instance;
+  return _instance;
+}
+
+CMetrics::~CMetrics(void)
+{
+  StopDump();
+}
+
+void CMetrics::Increment(METRIC_COUNTER counter, uint64_t amount /* = 1 */)
+{
+  Add(GetThreadMetrics().counters[counter], amount);
+}
+
+void CMetrics::Record(METRIC_HISTOGRAM histogram, uint64_t durationNs)
+{
+  ThreadMetrics& metrics = GetThreadMetrics();
+
+  Add(metrics.counts[histogram], 1);
+  Add(metrics.sums[histogram], durationNs);
+  Add(metrics.buckets[histogram][BucketIndex(durationNs)], 1);
+}
+
+MetricsSnapshot CMetrics::GetSnapshot(void) const
+{
+  MetricsSnapshot snapshot;
+
+  snapshot.counters.resize(METRIC_COUNTER_COUNT);
+  for (unsigned int i = 0; i < METRIC_COUNTER_COUNT; i++)
+  {
+    snapshot.counters[i].name = METRICS_PREFIX + std::string(COUNTER_INFO[i].name);
+    snapshot.counters[i].help = COUNTER_INFO[i].help;
+    snapshot.counters[i].value = 0;
+  }
+
+  snapshot.histograms.resize(METRIC_HISTOGRAM_COUNT);
+  for (unsigned int i = 0; i < METRIC_HISTOGRAM_COUNT; i++)
+  {
+    snapshot.histograms[i].name = METRICS_PREFIX + std::string(HISTOGRAM_INFO[i].name);
+    snapshot.histograms[i].help = HISTOGRAM_INFO[i].help;
+    snapshot.histograms[i].count = 0;
+    snapshot.histograms[i].sumNs = 0;
+    snapshot.histograms[i].buckets.assign(METRICS_BUCKET_COUNT, 0);
+  }
+
+  CLockObject lock(m_mutex);
+
+  for (const auto& threadMetrics : m_threadMetrics)
+  {
+    for (unsigned int i = 0; i < METRIC_COUNTER_COUNT; i++)
+      snapshot.counters[i].value += threadMetrics->counters[i].load(std::memory_order_relaxed);
+
+    for (unsigned int i = 0; i < METRIC_HISTOGRAM_COUNT; i++)
+    {
+      HistogramSnapshot& histogram = snapshot.histograms[i];
+
+      histogram.count += threadMetrics->counts[i].load(std::memory_order_relaxed);
+      histogram.sumNs += threadMetrics->sums[i].load(std::memory_order_relaxed);
+
+      for (unsigned int bucket = 0; bucket < METRICS_BUCKET_COUNT; bucket++)
+        histogram.buckets[bucket] += threadMetrics->buckets[i][bucket].load(std::memory_order_relaxed);
+    }
+  }
+
+  return snapshot;
+}
+
+std::string CMetrics::FormatPrometheus(const MetricsSnapshot& snapshot)
+{
+  std::ostringstream out;
+  char value[32];
+
+  for (const CounterSnapshot& counter : snapshot.counters)
+  {
+    out << "# HELP " << counter.name << " " << counter.help << "\n";
+    out << "# TYPE " << counter.name << " counter\n";
+    out << counter.name << " " << counter.value << "\n";
+  }
+
+  for (const HistogramSnapshot& histogram : snapshot.histograms)
+  {
+    out << "# HELP " << histogram.name << " " << histogram.help << "\n";
+    out << "# TYPE " << histogram.name << " histogram\n";
+
+    // Omit the empty buckets outside the range of recorded values
+    unsigned int firstBucket = 0;
+    unsigned int bucketCount = histogram.buckets.size();
+    while (bucketCount > 0 && histogram.buckets[bucketCount - 1] == 0)
+      bucketCount--;
+    while (firstBucket < bucketCount && histogram.buckets[firstBucket] == 0)
+      firstBucket++;
+
+    uint64_t cumulative = 0;
+    for (unsigned int i = firstBucket; i < bucketCount; i++)
+    {
+      cumulative += histogram.buckets[i];
+      snprintf(value, sizeof(value), "%.9g", BucketUpperBound(i) / 1e9);
+      out << histogram.name << "_bucket{le=\"" << value << "\"} " << cumulative << "\n";
+    }
+    out << histogram.name << "_bucket{le=\"+Inf\"} " << histogram.count << "\n";
+
+    snprintf(value, sizeof(value), "%.9g", histogram.sumNs / 1e9);
+    out << histogram.name << "_sum " << value << "\n";
+    out << histogram.name << "_count " << histogram.count << "\n";
+  }
+
+  return out.str();
+}
+
+std::string CMetrics::FormatJson(const MetricsSnapshot& snapshot)
+{
+  std::ostringstream out;
+
+  out << "{\n  \"counters\": {";
+
+  for (unsigned int i = 0; i < snapshot.counters.size(); i++)
+  {
+    const CounterSnapshot& counter = snapshot.counters[i];
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    \"" << counter.name << "\": " << counter.value;
+  }
+
+  out << "\n  },\n  \"histograms\": {";
+
+  for (unsigned int i = 0; i < snapshot.histograms.size(); i++)
+  {
+    const HistogramSnapshot& histogram = snapshot.histograms[i];
+    const uint64_t meanNs = histogram.count > 0 ? histogram.sumNs / histogram.count : 0;
+
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    \"" << histogram.name << "\": {"
+        << "\"count\": " << histogram.count << ", "
+        << "\"mean_ns\": " << meanNs << ", "
+        << "\"p50_ns\": " << histogram.Quantile(0.5) << ", "
+        << "\"p90_ns\": " << histogram.Quantile(0.9) << ", "
+        << "\"p99_ns\": " << histogram.Quantile(0.99) << ", "
+        << "\"max_ns\": " << histogram.Quantile(1.0) << "}";
+  }
+
+  out << "\n  }\n}\n";
+
+  return out.str();
+}
+
+bool CMetrics::WriteJson(const std::string& path) const
+{
+  return WriteFile(path, FormatJson(GetSnapshot()));
+}
+
+bool CMetrics::StartDump(const std::string& path)
+{
+  CLockObject lock(m_mutex);
+
+  if (!m_dumpPath.empty())
+    return true; // Already started
+
+  m_dumpPath = path;
+
+  if (!CreateThread(false))
+  {
+    m_dumpPath.clear();
+    return false;
+  }
+
+  return true;
+}
+
+void CMetrics::StopDump(void)
+{
+  StopThread();
+
+  CLockObject lock(m_mutex);
+
+  if (!m_dumpPath.empty())
+  {
+    WriteDump();
+    m_dumpPath.clear();
+  }
+}
+
+unsigned int CMetrics::BucketIndex(uint64_t value)
+{
+  if (value < METRICS_SUB_BUCKETS)
+    return static_cast<unsigned int>(value);
+
+  const unsigned int exponent = HighestBit(value);
+  const unsigned int subBucket = (value >> (exponent - METRICS_SUB_BUCKET_BITS)) & (METRICS_SUB_BUCKETS - 1);
+  const unsigned int bucket = ((exponent - METRICS_SUB_BUCKET_BITS + 1) << METRICS_SUB_BUCKET_BITS) + subBucket;
+
+  return bucket < METRICS_BUCKET_COUNT ? bucket : METRICS_BUCKET_COUNT - 1;
+}
+
+uint64_t CMetrics::BucketUpperBound(unsigned int bucket)
+{
+  if (bucket < METRICS_SUB_BUCKETS)
+    return bucket;
+
+  const unsigned int exponent = (bucket >> METRICS_SUB_BUCKET_BITS) + METRICS_SUB_BUCKET_BITS - 1;
+  const uint64_t subBucket = bucket & (METRICS_SUB_BUCKETS - 1);
+
+  return ((METRICS_SUB_BUCKETS + subBucket + 1) << (exponent - METRICS_SUB_BUCKET_BITS)) - 1;
+}
+
+void* CMetrics::Process(void)
+{
+  while (!IsStopped())
+  {
+    Sleep(METRICS_DUMP_INTERVAL_MS);
+
+    CLockObject lock(m_mutex);
+    WriteDump();
+  }
+
+  return NULL;
+}
+
+CMetrics::ThreadMetrics& CMetrics::GetThreadMetrics(void)
+{
+  static thread_local ThreadMetrics* threadMetrics = nullptr;
+
+  if (threadMetrics == nullptr)
+  {
+    std::unique_ptr<ThreadMetrics> metrics(new ThreadMetrics());
+
+    CLockObject lock(m_mutex);
+    threadMetrics = metrics.get();
+    m_threadMetrics.emplace_back(std::move(metrics));
+  }
+
+  return *threadMetrics;
+}
+
+bool CMetrics::WriteDump(void) const
+{
+  if (m_dumpPath.empty())
+    return false;
+
+  return WriteFile(m_dumpPath, FormatPrometheus(GetSnapshot()));
+}
+
+bool CMetrics::WriteFile(const std::string& path, const std::string& text)
+{
+  // Write to a temporary file and rename it, so readers never see a partial dump
+  const std::string tempPath = path + ".tmp";
+
+  FILE* file = fopen(tempPath.c_str(), "w");
+  if (file == nullptr)
+    return false;
+
+  bool bSuccess = (fwrite(text.data(), 1, text.size(), file) == text.size());
+
+  if (fclose(file) != 0)
+    bSuccess = false;
+
+#if defined(_WIN32)
+  // rename() doesn't replace existing files on Windows
+  if (bSuccess)
+    remove(path.c_str());
+#endif
+
+  if (bSuccess)
+    bSuccess = (rename(tempPath.c_str(), path.c_str()) == 0);
+
+  if (!bSuccess)
+    remove(tempPath.c_str());
+
+  return bSuccess;
+}
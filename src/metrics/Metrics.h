@@ -0,0 +1,228 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "p8-platform/threads/mutex.h"
+#include "p8-platform/threads/threads.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Log-linear histogram layout: each power of two is split into
+// 2^METRICS_SUB_BUCKET_BITS linear sub-buckets
+#define METRICS_SUB_BUCKET_BITS  2
+#define METRICS_SUB_BUCKETS      (1 << METRICS_SUB_BUCKET_BITS)
+#define METRICS_BUCKET_COUNT     160 // Covers values up to 2^41 ns (~36 minutes)
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Monotonic counters
+   *
+   * NOTE: Keep in sync with the names in Metrics.cpp
+   */
+  enum METRIC_COUNTER
+  {
+    METRIC_COUNTER_EVENTS,             // Events returned by GetEvents()
+    METRIC_COUNTER_BUTTON_MAPS_LOADED, // Button map files parsed
+    METRIC_COUNTER_SANITIZED_FEATURES, // Features removed by CButtonMap::Sanitize()
+    METRIC_COUNTER_COUNT
+  };
+
+  /*!
+   * \brief Latency histograms, in nanoseconds
+   *
+   * NOTE: Keep in sync with the names in Metrics.cpp
+   */
+  enum METRIC_HISTOGRAM
+  {
+    // Add-on entry points
+    METRIC_PERFORM_DEVICE_SCAN,
+    METRIC_GET_EVENTS,
+    METRIC_SEND_EVENT,
+    METRIC_GET_FEATURES,
+    METRIC_MAP_FEATURES,
+    METRIC_SAVE_BUTTON_MAP,
+
+    // Internal stages
+    METRIC_XML_PARSE,
+    METRIC_INDEX_DIRECTORY,
+    METRIC_MERGE_BUTTON_MAPS,
+    METRIC_TRANSFORM_FEATURES,
+    METRIC_SANITIZE,
+
+    // Input path
+    METRIC_POLL_INPUT,
+    METRIC_DIFF_STATES,
+
+    // Input path, per joystick
+    METRIC_SCAN_EVENTS,
+    METRIC_EMIT_EVENTS,
+
+    METRIC_HISTOGRAM_COUNT
+  };
+
+  struct CounterSnapshot
+  {
+    std::string name;
+    std::string help;
+    uint64_t    value;
+  };
+
+  struct HistogramSnapshot
+  {
+    std::string           name;
+    std::string           help;
+    uint64_t              count;
+    uint64_t              sumNs;
+    std::vector<uint64_t> buckets; // Non-cumulative count per bucket
+
+    /*!
+     * \brief Get an estimate of the given quantile, in nanoseconds
+     */
+    uint64_t Quantile(double quantile) const;
+  };
+
+  struct MetricsSnapshot
+  {
+    std::vector<CounterSnapshot>   counters;
+    std::vector<HistogramSnapshot> histograms;
+  };
+
+  /*!
+   * \brief Process-wide registry of counters and latency histograms
+   *
+   * Each thread records into its own block of relaxed atomics, so recording
+   * never takes a lock or performs a read-modify-write on a shared cache line.
+   * Snapshots sum the blocks of all threads that have ever recorded.
+   */
+  class CMetrics : private P8PLATFORM::CThread
+  {
+  private:
+    CMetrics(void);
+
+  public:
+    static CMetrics& Get(void);
+    virtual ~CMetrics(void);
+
+    /*!
+     * \brief Add to a counter
+     */
+    void Increment(METRIC_COUNTER counter, uint64_t amount = 1);
+
+    /*!
+     * \brief Record a duration in a histogram
+     */
+    void Record(METRIC_HISTOGRAM histogram, uint64_t durationNs);
+
+    /*!
+     * \brief Get the current value of all metrics
+     */
+    MetricsSnapshot GetSnapshot(void) const;
+
+    /*!
+     * \brief Format a snapshot in the Prometheus text exposition format
+     */
+    static std::string FormatPrometheus(const MetricsSnapshot& snapshot);
+
+    /*!
+     * \brief Format a snapshot as JSON, with quantiles instead of buckets
+     *
+     * Meant for comparing runs and tracking regressions.
+     */
+    static std::string FormatJson(const MetricsSnapshot& snapshot);
+
+    /*!
+     * \brief Write all metrics to a file once, as JSON
+     */
+    bool WriteJson(const std::string& path) const;
+
+    /*!
+     * \brief Periodically write all metrics to a file in Prometheus format
+     */
+    bool StartDump(const std::string& path);
+
+    /*!
+     * \brief Stop writing metrics, and write them one last time
+     */
+    void StopDump(void);
+
+    /*!
+     * \brief Histogram bucket that a value falls into
+     */
+    static unsigned int BucketIndex(uint64_t value);
+
+    /*!
+     * \brief Largest value that falls into a histogram bucket
+     */
+    static uint64_t BucketUpperBound(unsigned int bucket);
+
+  protected:
+    // implementation of CThread
+    virtual void* Process(void) override;
+
+  private:
+    struct ThreadMetrics
+    {
+      std::atomic<uint64_t> counters[METRIC_COUNTER_COUNT];
+      std::atomic<uint64_t> counts[METRIC_HISTOGRAM_COUNT];
+      std::atomic<uint64_t> sums[METRIC_HISTOGRAM_COUNT];
+      std::atomic<uint64_t> buckets[METRIC_HISTOGRAM_COUNT][METRICS_BUCKET_COUNT];
+    };
+
+    ThreadMetrics& GetThreadMetrics(void);
+
+    bool WriteDump(void) const;
+
+    static bool WriteFile(const std::string& path, const std::string& text);
+
+    // Blocks are never freed, so counts from exited threads are kept
+    std::vector<std::unique_ptr<ThreadMetrics>> m_threadMetrics;
+    std::string                                 m_dumpPath;
+    mutable P8PLATFORM::CMutex                  m_mutex;
+  };
+
+  /*!
+   * \brief Records the lifetime of the object in a histogram
+   */
+  class CMetricTimer
+  {
+  public:
+    CMetricTimer(METRIC_HISTOGRAM histogram)
+     : m_histogram(histogram),
+       m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~CMetricTimer(void)
+    {
+      const auto duration = std::chrono::steady_clock::now() - m_start;
+      CMetrics::Get().Record(m_histogram, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+  private:
+    const METRIC_HISTOGRAM                      m_histogram;
+    const std::chrono::steady_clock::time_point m_start;
+  };
+}
@@ -0,0 +1,203 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Tracer.h"
+#include "log/Log.h"
+
+#include <chrono>
+
+using namespace JOYSTICK;
+using namespace P8PLATFORM;
+
+#define TRACE_FLUSH_INTERVAL_MS  100
+
+static_assert((TRACE_BUFFER_SIZE & (TRACE_BUFFER_SIZE - 1)) == 0, "TRACE_BUFFER_SIZE must be a power of two");
+
+namespace
+{
+  uint64_t NowNs(void)
+  {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  }
+}
+
+CTracer::CTracer(void)
+ : m_bEnabled(false),
+   m_file(nullptr),
+   m_bFirstEvent(true),
+   m_startTimeNs(0)
+{
+}
+
+CTracer& CTracer::Get(void)
+{
+  static CTracer _instance;
+  return _instance;
+}
+
+CTracer::~CTracer(void)
+{
+  Stop();
+}
+
+bool CTracer::Start(const std::string& path)
+{
+  CLockObject lock(m_mutex);
+
+  if (m_file != nullptr)
+    return true; // Already started
+
+  m_file = fopen(path.c_str(), "w");
+  if (m_file == nullptr)
+  {
+    esyslog("Failed to open trace file %s", path.c_str());
+    return false;
+  }
+
+  fputs("[\n", m_file);
+  m_bFirstEvent = true;
+  m_startTimeNs = NowNs();
+
+  // Discard events recorded during a previous trace
+  for (const auto& buffer : m_buffers)
+    buffer->readCount.store(buffer->writeCount.load(std::memory_order_acquire), std::memory_order_release);
+
+  if (!CreateThread(false))
+  {
+    fclose(m_file);
+    m_file = nullptr;
+    return false;
+  }
+
+  m_bEnabled = true;
+
+  isyslog("Writing trace to %s", path.c_str());
+
+  return true;
+}
+
+void CTracer::Stop(void)
+{
+  m_bEnabled = false;
+
+  StopThread();
+
+  CLockObject lock(m_mutex);
+
+  if (m_file != nullptr)
+  {
+    Flush();
+
+    fputs("\n]\n", m_file);
+    fclose(m_file);
+    m_file = nullptr;
+  }
+}
+
+void CTracer::Record(const char* name, bool bBegin)
+{
+  ThreadBuffer& buffer = GetThreadBuffer();
+
+  const uint64_t writeCount = buffer.writeCount.load(std::memory_order_relaxed);
+  if (writeCount - buffer.readCount.load(std::memory_order_acquire) >= TRACE_BUFFER_SIZE)
+  {
+    buffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  TraceEvent& event = buffer.events[writeCount & (TRACE_BUFFER_SIZE - 1)];
+  event.name        = name;
+  event.timestampNs = NowNs();
+  event.bBegin      = bBegin;
+
+  // Publish the event to the flushing thread
+  buffer.writeCount.store(writeCount + 1, std::memory_order_release);
+}
+
+void* CTracer::Process(void)
+{
+  while (!IsStopped())
+  {
+    Sleep(TRACE_FLUSH_INTERVAL_MS);
+
+    CLockObject lock(m_mutex);
+    Flush();
+  }
+
+  return NULL;
+}
+
+CTracer::ThreadBuffer& CTracer::GetThreadBuffer(void)
+{
+  static thread_local ThreadBuffer* threadBuffer = nullptr;
+
+  if (threadBuffer == nullptr)
+  {
+    CLockObject lock(m_mutex);
+
+    m_buffers.emplace_back(new ThreadBuffer(m_buffers.size() + 1));
+    threadBuffer = m_buffers.back().get();
+  }
+
+  return *threadBuffer;
+}
+
+void CTracer::Flush(void)
+{
+  if (m_file == nullptr)
+    return;
+
+  for (const auto& buffer : m_buffers)
+  {
+    const uint64_t writeCount = buffer->writeCount.load(std::memory_order_acquire);
+    uint64_t readCount = buffer->readCount.load(std::memory_order_relaxed);
+
+    for (; readCount < writeCount; readCount++)
+    {
+      const TraceEvent& event = buffer->events[readCount & (TRACE_BUFFER_SIZE - 1)];
+
+      // Events from before the trace started are skipped
+      if (event.timestampNs < m_startTimeNs)
+        continue;
+
+      const uint64_t timestampNs = event.timestampNs - m_startTimeNs;
+
+      fprintf(m_file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%u}",
+          m_bFirstEvent ? "" : ",\n",
+          event.name,
+          event.bBegin ? 'B' : 'E',
+          static_cast<unsigned long long>(timestampNs / 1000),
+          static_cast<unsigned int>(timestampNs % 1000),
+          buffer->threadId);
+
+      m_bFirstEvent = false;
+    }
+
+    // Release the slots to the producer
+    buffer->readCount.store(readCount, std::memory_order_release);
+
+    const uint64_t droppedCount = buffer->droppedCount.exchange(0, std::memory_order_relaxed);
+    if (droppedCount > 0)
+      esyslog("Trace buffer of thread %u full, dropped %llu events", buffer->threadId, static_cast<unsigned long long>(droppedCount));
+  }
+
+  fflush(m_file);
+}
@@ -0,0 +1,144 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "p8-platform/threads/mutex.h"
+#include "p8-platform/threads/threads.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define TRACE_BUFFER_SIZE  8192 // Events per thread, must be a power of two
+
+/*!
+ * \brief Trace the enclosing scope as a span named by a string literal
+ */
+#define TRACE_SPAN(name)  JOYSTICK::CTraceSpan _traceSpan(name)
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Writes spans in Chrome's trace_event JSON format, which can be
+   *        viewed in Perfetto or chrome://tracing
+   *
+   * Each thread writes span begin/end events into its own lock-free buffer.
+   * A background thread drains the buffers to the trace file, so tracing
+   * never performs I/O on the traced thread. When tracing is stopped, the
+   * only cost of a span is an atomic load.
+   */
+  class CTracer : private P8PLATFORM::CThread
+  {
+  private:
+    CTracer(void);
+
+  public:
+    static CTracer& Get(void);
+    virtual ~CTracer(void);
+
+    /*!
+     * \brief Start writing spans to the given file
+     */
+    bool Start(const std::string& path);
+
+    /*!
+     * \brief Write any buffered spans and close the file
+     */
+    void Stop(void);
+
+    bool IsEnabled(void) const { return m_bEnabled.load(std::memory_order_relaxed); }
+
+    /*!
+     * \brief Record the beginning or end of a span
+     *
+     * \param name A string literal, or other string that outlives the tracer
+     * \param bBegin true for the beginning of the span, false for the end
+     */
+    void Record(const char* name, bool bBegin);
+
+  protected:
+    // implementation of CThread
+    virtual void* Process(void) override;
+
+  private:
+    struct TraceEvent
+    {
+      const char* name;
+      uint64_t    timestampNs;
+      bool        bBegin;
+    };
+
+    /*!
+     * \brief Single-producer, single-consumer ring owned by one thread
+     */
+    struct ThreadBuffer
+    {
+      ThreadBuffer(unsigned int threadId) : threadId(threadId), writeCount(0), readCount(0), droppedCount(0) { }
+
+      const unsigned int    threadId;
+      TraceEvent            events[TRACE_BUFFER_SIZE];
+      std::atomic<uint64_t> writeCount;
+      std::atomic<uint64_t> readCount;
+      std::atomic<uint64_t> droppedCount;
+    };
+
+    ThreadBuffer& GetThreadBuffer(void);
+
+    /*!
+     * \brief Write buffered events to the file
+     *
+     * NOTE: Must be called with m_mutex held
+     */
+    void Flush(void);
+
+    std::atomic<bool>                          m_bEnabled;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    FILE*                                      m_file;
+    bool                                       m_bFirstEvent;
+    uint64_t                                   m_startTimeNs;
+    P8PLATFORM::CMutex                         m_mutex;
+  };
+
+  /*!
+   * \brief Records the lifetime of the object as a span
+   */
+  class CTraceSpan
+  {
+  public:
+    CTraceSpan(const char* name)
+     : m_name(CTracer::Get().IsEnabled() ? name : nullptr)
+    {
+      if (m_name != nullptr)
+        CTracer::Get().Record(m_name, true);
+    }
+
+    ~CTraceSpan(void)
+    {
+      if (m_name != nullptr)
+        CTracer::Get().Record(m_name, false);
+    }
+
+  private:
+    const char* const m_name;
+  };
+}
@@ -19,15 +19,22 @@
  */
 
 #include "Settings.h"
+#include "api/InputHistory.h"
 #include "log/Log.h"
 
 using namespace JOYSTICK;
 
 #define SETTING_RETROARCH_CONFIG  "retroarchconfig"
+#define SETTING_EXCLUSIVE_GRAB    "exclusivegrab"
+#define SETTING_INPUT_HISTORY     "inputhistorysize"
+#define SETTING_DUMP_METRICS      "dumpmetrics"
 
 CSettings::CSettings(void)
   : m_bInitialized(false),
-    m_bGenerateRetroArchConfigs(false)
+    m_bGenerateRetroArchConfigs(false),
+    m_bExclusiveGrab(false),
+    m_inputHistorySize(INPUT_HISTORY_DEFAULT_SIZE),
+    m_bDumpMetrics(false)
 {
 }
 
@@ -44,6 +51,22 @@ void CSettings::SetSetting(const std::string& strName, const void* value)
     m_bGenerateRetroArchConfigs = *static_cast<const bool*>(value);
     dsyslog("Setting \"%s\" set to %f", SETTING_RETROARCH_CONFIG, m_bGenerateRetroArchConfigs ? "true" : "false");
   }
+  else if (strName == SETTING_EXCLUSIVE_GRAB)
+  {
+    m_bExclusiveGrab = *static_cast<const bool*>(value);
+    dsyslog("Setting \"%s\" set to %s", SETTING_EXCLUSIVE_GRAB, m_bExclusiveGrab ? "true" : "false");
+  }
+  else if (strName == SETTING_INPUT_HISTORY)
+  {
+    const int size = *static_cast<const int*>(value);
+    m_inputHistorySize = size > 0 ? static_cast<unsigned int>(size) : 0;
+    dsyslog("Setting \"%s\" set to %u", SETTING_INPUT_HISTORY, m_inputHistorySize);
+  }
+  else if (strName == SETTING_DUMP_METRICS)
+  {
+    m_bDumpMetrics = *static_cast<const bool*>(value);
+    dsyslog("Setting \"%s\" set to %s", SETTING_DUMP_METRICS, m_bDumpMetrics ? "true" : "false");
+  }
 
   m_bInitialized = true;
 }
@@ -48,8 +48,28 @@ namespace JOYSTICK
      */
     bool GenerateRetroArchConfigs(void) const { return m_bGenerateRetroArchConfigs; }
 
+    /*!
+     * \brief Grab joysticks so that other programs don't receive their input
+     */
+    bool ExclusiveGrab(void) const { return m_bExclusiveGrab; }
+
+    /*!
+     * \brief Number of state snapshots kept in each joystick's input history
+     *
+     * Applies to joysticks opened after the setting changes.
+     */
+    unsigned int InputHistorySize(void) const { return m_inputHistorySize; }
+
+    /*!
+     * \brief Periodically write metrics to the user folder
+     */
+    bool DumpMetrics(void) const { return m_bDumpMetrics; }
+
   private:
-    bool        m_bInitialized;
-    bool        m_bGenerateRetroArchConfigs;
+    bool         m_bInitialized;
+    bool         m_bGenerateRetroArchConfigs;
+    bool         m_bExclusiveGrab;
+    unsigned int m_inputHistorySize;
+    bool         m_bDumpMetrics;
   };
 }
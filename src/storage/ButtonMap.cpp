@@ -21,10 +21,12 @@
 #include "ButtonMap.h"
 #include "Device.h"
 #include "DeviceConfiguration.h"
+#include "StorageFootprint.h"
 #include "StorageManager.h"
 #include "StorageUtils.h"
 #include "buttonmapper/ButtonMapUtils.h"
 #include "log/Log.h"
+#include "metrics/Metrics.h"
 
 #include "kodi_peripheral_utils.hpp"
 #include "p8-platform/util/timeutils.h"
@@ -137,6 +139,10 @@ bool CButtonMap::Refresh(void)
     if (!Load())
       return false;
 
+    CMetrics::Get().Increment(METRIC_COUNTER_BUTTON_MAPS_LOADED);
+
+    CMetricTimer timer(METRIC_SANITIZE);
+
     for (auto it = m_buttonMap.begin(); it != m_buttonMap.end(); ++it)
       Sanitize(it->second, it->first);
 
@@ -147,6 +153,16 @@ bool CButtonMap::Refresh(void)
   return true;
 }
 
+void CButtonMap::GetMemoryFootprint(StorageFootprint& footprint) const
+{
+  ProviderFootprint& provider = footprint.providers[m_device->Provider()];
+
+  provider.buttonMaps += sizeof(*this) + CStorageFootprint::String(m_strResourcePath);
+  provider.buttonMaps += CStorageFootprint::AddButtonMap(m_buttonMap, false, footprint);
+  provider.originalButtonMaps += CStorageFootprint::AddButtonMap(m_originalButtonMap, true, footprint);
+  provider.buttonMapCount++;
+}
+
 void CButtonMap::MergeFeature(const ADDON::JoystickFeature& feature, FeatureVector& features, const std::string& controllerId)
 {
   // Find existing feature with the same name being updated
@@ -226,7 +242,7 @@ void CButtonMap::Sanitize(FeatureVector& features, const std::string& controller
       // Invalid the primitive if it has already been seen
       if (bFound)
       {
-        esyslog("%s: %s (%s) conflicts with %s (%s)",
+        esyslog_ratelimited("%s: %s (%s) conflicts with %s (%s)",
             controllerId.c_str(),
             CStorageUtils::PrimitiveToString(primitive).c_str(),
             existingFeature.Type() != JOYSTICK_FEATURE_TYPE_UNKNOWN ? existingFeature.Name().c_str() : feature.Name().c_str(),
@@ -255,7 +271,8 @@ void CButtonMap::Sanitize(FeatureVector& features, const std::string& controller
 
       if (!bIsValid)
       {
-        dsyslog("%s: Removing %s from button map", controllerId.c_str(), feature.Name().c_str());
+        dsyslog_ratelimited("%s: Removing %s from button map", controllerId.c_str(), feature.Name().c_str());
+        CMetrics::Get().Increment(METRIC_COUNTER_SANITIZED_FEATURES);
         return true;
       }
 
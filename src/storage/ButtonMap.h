@@ -28,6 +28,8 @@
 
 namespace JOYSTICK
 {
+  struct StorageFootprint;
+
   class CButtonMap
   {
   public:
@@ -54,6 +56,11 @@ namespace JOYSTICK
 
     bool Refresh(void);
 
+    /*!
+     * \brief Add the bytes held by this button map to a snapshot
+     */
+    void GetMemoryFootprint(StorageFootprint& footprint) const;
+
   protected:
     virtual bool Load(void) = 0;
     virtual bool Save(void) const = 0;
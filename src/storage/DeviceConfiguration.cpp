@@ -33,12 +33,14 @@ void CDeviceConfiguration::Reset(void)
 {
   m_axes.clear();
   m_buttons.clear();
+  m_bExclusiveGrab = false;
 }
 
 bool CDeviceConfiguration::IsEmpty() const
 {
   return m_axes.empty() &&
-         m_buttons.empty();
+         m_buttons.empty() &&
+         !m_bExclusiveGrab;
 }
 
 const AxisConfiguration& CDeviceConfiguration::Axis(unsigned int index) const
@@ -48,14 +48,17 @@ namespace JOYSTICK
     const ButtonConfigurationMap& Buttons(void) const              { return m_buttons; }
     const ButtonConfiguration&    Button(unsigned int index) const;
     PrimitiveVector               GetIgnoredPrimitives() const;
+    bool                          ExclusiveGrab(void) const        { return m_bExclusiveGrab; }
 
     void SetAxis(unsigned int index, const AxisConfiguration& config)     { m_axes[index] = config; }
     void SetButton(unsigned int index, const ButtonConfiguration& config) { m_buttons[index] = config; }
     void SetIgnoredPrimitives(const PrimitiveVector& primitives);
+    void SetExclusiveGrab(bool bExclusive)                                { m_bExclusiveGrab = bExclusive; }
 
   private:
     // Configuration parameters
     AxisConfigurationMap m_axes;
     ButtonConfigurationMap m_buttons;
+    bool m_bExclusiveGrab = false; // Grab the device even if the setting is off
   };
 }
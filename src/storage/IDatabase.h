@@ -19,6 +19,7 @@
  */
 #pragma once
 
+#include "PrimitiveConfiguration.h"
 #include "StorageTypes.h"
 #include "buttonmapper/ButtonMapTypes.h"
 
@@ -32,6 +33,7 @@ namespace ADDON
 namespace JOYSTICK
 {
   class CDevice;
+  struct StorageFootprint;
 
   class IDatabaseCallbacks
   {
@@ -55,6 +57,11 @@ namespace JOYSTICK
      */
     virtual const ButtonMap& GetButtonMap(const ADDON::Joystick& driverInfo) = 0;
 
+    /*!
+     * \copydoc CStorageManager::HasButtonMap()
+     */
+    virtual bool HasButtonMap(const ADDON::Joystick& driverInfo) = 0;
+
     /*!
      * \copydoc CStorageManager::MapFeatures()
      */
@@ -72,6 +79,18 @@ namespace JOYSTICK
      */
     virtual bool SetIgnoredPrimitives(const ADDON::Joystick& driverInfo, const PrimitiveVector& primitives) = 0;
 
+    /*!
+     * \copydoc CStorageManager::GetAxisConfigurations()
+     */
+    virtual bool GetAxisConfigurations(const ADDON::Joystick& driverInfo, AxisConfigurationMap& axes) = 0;
+
+    /*!
+     * \copydoc CStorageManager::GetExclusiveGrab()
+     *
+     * \return true if the device's configuration was found
+     */
+    virtual bool GetExclusiveGrab(const ADDON::Joystick& driverInfo, bool& bExclusive) = 0;
+
     /*!
      * \copydoc CStorageManager::SaveButtonMap()
      */
@@ -88,6 +107,11 @@ namespace JOYSTICK
     virtual bool ResetButtonMap(const ADDON::Joystick& driverInfo,
                                 const std::string& controllerId) = 0;
 
+    /*!
+     * \copydoc CStorageManager::GetMemoryFootprint()
+     */
+    virtual void GetMemoryFootprint(StorageFootprint& footprint) = 0;
+
     IDatabaseCallbacks* Callbacks() const { return m_callbacks; }
 
   protected:
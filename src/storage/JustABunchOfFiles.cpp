@@ -20,9 +20,12 @@
 
 #include "JustABunchOfFiles.h"
 #include "StorageDefinitions.h"
+#include "StorageFootprint.h"
 #include "StorageUtils.h"
 #include "filesystem/DirectoryUtils.h"
 #include "log/Log.h"
+#include "metrics/Metrics.h"
+#include "metrics/Tracer.h"
 #include "utils/StringUtils.h"
 
 #include <algorithm>
@@ -123,6 +126,30 @@ bool CResources::GetIgnoredPrimitives(const CDevice& deviceInfo, PrimitiveVector
   return false;
 }
 
+bool CResources::GetAxisConfigurations(const CDevice& deviceInfo, AxisConfigurationMap& axes) const
+{
+  DevicePtr device = GetDevice(deviceInfo);
+  if (device)
+  {
+    axes = device->Configuration().Axes();
+    return true;
+  }
+
+  return false;
+}
+
+bool CResources::GetExclusiveGrab(const CDevice& deviceInfo, bool& bExclusive) const
+{
+  DevicePtr device = GetDevice(deviceInfo);
+  if (device)
+  {
+    bExclusive = device->Configuration().ExclusiveGrab();
+    return true;
+  }
+
+  return false;
+}
+
 void CResources::SetIgnoredPrimitives(const CDevice& deviceInfo, const PrimitiveVector& primitives)
 {
   auto itDevice = m_devices.find(deviceInfo);
@@ -161,6 +188,32 @@ void CResources::Revert(const CDevice& deviceInfo)
   }
 }
 
+void CResources::GetMemoryFootprint(StorageFootprint& footprint) const
+{
+  for (const auto& it : m_devices)
+  {
+    ProviderFootprint& provider = footprint.providers[it.first.Provider()];
+    provider.devices += CStorageFootprint::DeviceRecord(it.first, it.second);
+    provider.deviceCount++;
+  }
+
+  for (const auto& it : m_originalDevices)
+  {
+    ProviderFootprint& provider = footprint.providers[it.first.Provider()];
+    provider.originalDevices += CStorageFootprint::DeviceRecord(it.first, it.second);
+  }
+
+  for (const auto& it : m_resources)
+  {
+    // The resource's device is shared with the device map, so only count the key
+    ProviderFootprint& provider = footprint.providers[it.first.Provider()];
+    provider.buttonMaps += CStorageFootprint::DeviceRecord(it.first, DevicePtr());
+
+    if (it.second != nullptr)
+      it.second->GetMemoryFootprint(footprint);
+  }
+}
+
 // --- CJustABunchOfFiles ------------------------------------------------------
 
 CJustABunchOfFiles::CJustABunchOfFiles(const std::string& strResourcePath,
@@ -171,7 +224,8 @@ CJustABunchOfFiles::CJustABunchOfFiles(const std::string& strResourcePath,
   m_strResourcePath(strResourcePath),
   m_strExtension(strExtension),
   m_bReadWrite(bReadWrite),
-  m_resources(this)
+  m_resources(this),
+  m_mutex("JustABunchOfFiles")
 {
   m_directoryCache.Initialize(this);
 
@@ -188,10 +242,13 @@ const ButtonMap& CJustABunchOfFiles::GetButtonMap(const ADDON::Joystick& driverI
 {
   static ButtonMap empty;
 
-  CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   // Update index
-  IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
+  {
+    CMetricTimer timer(METRIC_INDEX_DIRECTORY);
+    IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
+  }
 
   CButtonMap* resource = m_resources.GetResource(driverInfo, false);
 
@@ -201,6 +258,16 @@ const ButtonMap& CJustABunchOfFiles::GetButtonMap(const ADDON::Joystick& driverI
   return empty;
 }
 
+bool CJustABunchOfFiles::HasButtonMap(const ADDON::Joystick& driverInfo)
+{
+  CProfiledLockObject lock(m_mutex);
+
+  // Update index
+  IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
+
+  return m_resources.GetResource(driverInfo, false) != nullptr;
+}
+
 bool CJustABunchOfFiles::MapFeatures(const ADDON::Joystick& driverInfo,
                                      const std::string& controllerId,
                                      const FeatureVector& features)
@@ -208,7 +275,7 @@ bool CJustABunchOfFiles::MapFeatures(const ADDON::Joystick& driverInfo,
   if (!m_bReadWrite)
     return false;
 
-  CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   CButtonMap* resource = m_resources.GetResource(driverInfo, true);
   if (resource)
@@ -222,7 +289,7 @@ bool CJustABunchOfFiles::MapFeatures(const ADDON::Joystick& driverInfo,
 
 bool CJustABunchOfFiles::GetIgnoredPrimitives(const ADDON::Joystick& driverInfo, PrimitiveVector& primitives)
 {
-  CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   // Update index
   IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
@@ -235,7 +302,7 @@ bool CJustABunchOfFiles::SetIgnoredPrimitives(const ADDON::Joystick& driverInfo,
   if (!m_bReadWrite)
     return false;
 
-  CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   // Ensure resource exists
   m_resources.SetIgnoredPrimitives(driverInfo, primitives);
@@ -243,6 +310,26 @@ bool CJustABunchOfFiles::SetIgnoredPrimitives(const ADDON::Joystick& driverInfo,
   return true;
 }
 
+bool CJustABunchOfFiles::GetAxisConfigurations(const ADDON::Joystick& driverInfo, AxisConfigurationMap& axes)
+{
+  CProfiledLockObject lock(m_mutex);
+
+  // Update index
+  IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
+
+  return m_resources.GetAxisConfigurations(driverInfo, axes);
+}
+
+bool CJustABunchOfFiles::GetExclusiveGrab(const ADDON::Joystick& driverInfo, bool& bExclusive)
+{
+  CProfiledLockObject lock(m_mutex);
+
+  // Update index
+  IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
+
+  return m_resources.GetExclusiveGrab(driverInfo, bExclusive);
+}
+
 bool CJustABunchOfFiles::SaveButtonMap(const ADDON::Joystick& driverInfo)
 {
   if (!m_bReadWrite)
@@ -250,7 +337,7 @@ bool CJustABunchOfFiles::SaveButtonMap(const ADDON::Joystick& driverInfo)
 
   CDevice device(driverInfo);
 
-  CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   CButtonMap* resource = m_resources.GetResource(device, false);
 
@@ -267,7 +354,7 @@ bool CJustABunchOfFiles::RevertButtonMap(const ADDON::Joystick& driverInfo)
 
   CDevice device(driverInfo);
 
-  CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   m_resources.Revert(device);
 
@@ -281,7 +368,7 @@ bool CJustABunchOfFiles::ResetButtonMap(const ADDON::Joystick& driverInfo, const
 
   CDevice deviceInfo(driverInfo);
 
-  CLockObject lock(m_mutex);
+  CProfiledLockObject lock(m_mutex);
 
   DevicePtr device = m_resources.GetDevice(deviceInfo);
   if (device)
@@ -295,8 +382,18 @@ bool CJustABunchOfFiles::ResetButtonMap(const ADDON::Joystick& driverInfo, const
   return false;
 }
 
+void CJustABunchOfFiles::GetMemoryFootprint(StorageFootprint& footprint)
+{
+  CProfiledLockObject lock(m_mutex);
+
+  footprint.directoryCache += m_directoryCache.GetMemoryFootprint();
+  m_resources.GetMemoryFootprint(footprint);
+}
+
 void CJustABunchOfFiles::IndexDirectory(const std::string& path, unsigned int folderDepth)
 {
+  TRACE_SPAN("IndexDirectory");
+
   // Enumerate the directory
   std::vector<ADDON::CVFSDirEntry> items;
   if (!m_directoryCache.GetDirectory(path, items))
@@ -327,6 +424,8 @@ void CJustABunchOfFiles::IndexDirectory(const std::string& path, unsigned int fo
 
 void CJustABunchOfFiles::OnAdd(const ADDON::CVFSDirEntry& item)
 {
+  TRACE_SPAN("OnAdd");
+
   if (!item.IsFolder())
   {
     // TODO: Switch to unique_ptr or shared_ptr
@@ -23,6 +23,7 @@
 #include "Device.h"
 #include "IDatabase.h"
 #include "filesystem/DirectoryCache.h"
+#include "metrics/LockProfiler.h"
 
 #include "p8-platform/threads/mutex.h"
 
@@ -52,8 +53,13 @@ namespace JOYSTICK
     bool GetIgnoredPrimitives(const CDevice& deviceInfo, PrimitiveVector& primitives) const;
     void SetIgnoredPrimitives(const CDevice& deviceInfo, const PrimitiveVector& primitives);
 
+    bool GetAxisConfigurations(const CDevice& deviceInfo, AxisConfigurationMap& axes) const;
+    bool GetExclusiveGrab(const CDevice& deviceInfo, bool& bExclusive) const;
+
     void Revert(const CDevice& deviceInfo);
 
+    void GetMemoryFootprint(StorageFootprint& footprint) const;
+
   private:
     typedef std::map<CDevice, DevicePtr>   DeviceMap;
     typedef std::map<CDevice, CButtonMap*> ResourceMap;
@@ -80,15 +86,19 @@ namespace JOYSTICK
 
     // implementation of IDatabase
     virtual const ButtonMap& GetButtonMap(const ADDON::Joystick& driverInfo) override;
+    virtual bool HasButtonMap(const ADDON::Joystick& driverInfo) override;
     virtual bool MapFeatures(const ADDON::Joystick& driverInfo,
                              const std::string& controllerId,
                              const FeatureVector& features) override;
     virtual bool GetIgnoredPrimitives(const ADDON::Joystick& driverInfo, PrimitiveVector& primitives) override;
     virtual bool SetIgnoredPrimitives(const ADDON::Joystick& driverInfo, const PrimitiveVector& primitives) override;
+    virtual bool GetAxisConfigurations(const ADDON::Joystick& driverInfo, AxisConfigurationMap& axes) override;
+    virtual bool GetExclusiveGrab(const ADDON::Joystick& driverInfo, bool& bExclusive) override;
     virtual bool SaveButtonMap(const ADDON::Joystick& driverInfo) override;
     virtual bool RevertButtonMap(const ADDON::Joystick& driverInfo) override;
     virtual bool ResetButtonMap(const ADDON::Joystick& driverInfo,
                                 const std::string& controllerId) override;
+    virtual void GetMemoryFootprint(StorageFootprint& footprint) override;
 
     // implementation of IDirectoryCacheCallback
     virtual void OnAdd(const ADDON::CVFSDirEntry& item) override;
@@ -121,6 +131,6 @@ namespace JOYSTICK
     const bool        m_bReadWrite;
     CDirectoryCache   m_directoryCache;
     CResources        m_resources;
-    P8PLATFORM::CMutex  m_mutex;
+    CProfiledMutex    m_mutex;
   };
 }
@@ -47,11 +47,15 @@ namespace JOYSTICK
   {
     TriggerProperties trigger;
     bool bIgnore = false;
+    unsigned int fuzz = 0; // Configured noise filter in driver units, or 0 to learn it
+    unsigned int flat = 0; // Configured dead zone in driver units, or 0 to learn it
 
     bool operator==(const AxisConfiguration& other) const
     {
       return trigger == other.trigger &&
-             bIgnore == other.bIgnore;
+             bIgnore == other.bIgnore &&
+             fuzz == other.fuzz &&
+             flat == other.flat;
     }
   };
 
@@ -0,0 +1,159 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "StorageFootprint.h"
+#include "Device.h"
+#include "log/Log.h"
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <stdint.h>
+
+using namespace JOYSTICK;
+
+// Color, parent, left and right of a red-black tree node
+#define TREE_NODE_SIZE  (4 * sizeof(void*))
+
+// Reference counts of a shared pointer's control block
+#define SHARED_PTR_CONTROL_BLOCK_SIZE  (2 * sizeof(long) + sizeof(void*))
+
+// --- StorageFootprint --------------------------------------------------------
+
+size_t StorageFootprint::Total(void) const
+{
+  size_t total = directoryCache + controllerMap + observedDevices + familyMap;
+
+  for (const auto& provider : providers)
+    total += provider.second.Total();
+
+  return total;
+}
+
+// --- CStorageFootprint -------------------------------------------------------
+
+size_t CStorageFootprint::MapNode(void)
+{
+  return TREE_NODE_SIZE;
+}
+
+size_t CStorageFootprint::SharedPointer(void)
+{
+  return SHARED_PTR_CONTROL_BLOCK_SIZE;
+}
+
+size_t CStorageFootprint::String(const std::string& str)
+{
+  // Short strings are stored inside the string object, and the inline
+  // capacity differs between standard libraries
+  const uintptr_t data = reinterpret_cast<uintptr_t>(str.data());
+  const uintptr_t object = reinterpret_cast<uintptr_t>(&str);
+  if (object <= data && data < object + sizeof(std::string))
+    return 0;
+
+  return str.capacity() + 1;
+}
+
+size_t CStorageFootprint::Device(const CDevice& device)
+{
+  size_t bytes = sizeof(CDevice);
+
+  bytes += String(device.Name());
+  bytes += String(device.Provider());
+
+  const CDeviceConfiguration& config = device.Configuration();
+
+  bytes += config.Axes().size() * (MapNode() + sizeof(AxisConfigurationMap::value_type));
+  bytes += config.Buttons().size() * (MapNode() + sizeof(ButtonConfigurationMap::value_type));
+
+  return bytes;
+}
+
+size_t CStorageFootprint::DeviceRecord(const CDevice& key, const DevicePtr& device)
+{
+  // The map value type holds the key and the pointer, so only count the
+  // key's heap blocks
+  size_t bytes = MapNode() + sizeof(std::pair<const CDevice, DevicePtr>) + Device(key) - sizeof(CDevice);
+
+  if (device)
+    bytes += SharedPointer() + Device(*device);
+
+  return bytes;
+}
+
+size_t CStorageFootprint::Features(const FeatureVector& features)
+{
+  size_t bytes = features.capacity() * sizeof(ADDON::JoystickFeature);
+
+  for (const auto& feature : features)
+    bytes += String(feature.Name());
+
+  return bytes;
+}
+
+size_t CStorageFootprint::AddButtonMap(const ButtonMap& buttonMap, bool bOriginal, StorageFootprint& footprint)
+{
+  size_t total = 0;
+
+  for (const auto& it : buttonMap)
+  {
+    const std::string& controllerId = it.first;
+    const FeatureVector& features = it.second;
+
+    const size_t bytes = MapNode() + sizeof(ButtonMap::value_type) + String(controllerId) + Features(features);
+
+    ControllerFootprint& controller = footprint.controllers[controllerId];
+    if (bOriginal)
+      controller.originalButtonMaps += bytes;
+    else
+      controller.buttonMaps += bytes;
+
+    total += bytes;
+  }
+
+  return total;
+}
+
+void CStorageFootprint::Log(const StorageFootprint& footprint)
+{
+  isyslog("Storage memory footprint: %zu bytes", footprint.Total());
+  isyslog("  directory cache:  %zu bytes", footprint.directoryCache);
+  isyslog("  controller map:   %zu bytes", footprint.controllerMap);
+  isyslog("  observed devices: %zu bytes", footprint.observedDevices);
+  isyslog("  family map:       %zu bytes", footprint.familyMap);
+
+  for (const auto& it : footprint.providers)
+  {
+    const ProviderFootprint& provider = it.second;
+
+    isyslog("  provider \"%s\": %zu bytes (%u devices: %zu bytes, backup %zu bytes; %u button maps: %zu bytes, backup %zu bytes)",
+        it.first.c_str(), provider.Total(),
+        provider.deviceCount, provider.devices, provider.originalDevices,
+        provider.buttonMapCount, provider.buttonMaps, provider.originalButtonMaps);
+  }
+
+  for (const auto& it : footprint.controllers)
+  {
+    const ControllerFootprint& controller = it.second;
+
+    isyslog("  controller \"%s\": %zu bytes (button maps %zu bytes, backup %zu bytes, controller map %zu bytes)",
+        it.first.c_str(), controller.Total(),
+        controller.buttonMaps, controller.originalButtonMaps, controller.controllerMap);
+  }
+}
@@ -0,0 +1,132 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "StorageTypes.h"
+#include "buttonmapper/ButtonMapTypes.h"
+
+#include <map>
+#include <stddef.h>
+#include <string>
+
+namespace JOYSTICK
+{
+  class CDevice;
+
+  /*!
+   * \brief Bytes held for the devices and button maps of a single provider
+   */
+  struct ProviderFootprint
+  {
+    size_t devices            = 0; // Device records in the resource database
+    size_t originalDevices    = 0; // Backup copies of modified device records
+    size_t buttonMaps         = 0; // Button maps, including their paths
+    size_t originalButtonMaps = 0; // Backup copies of button maps
+    unsigned int deviceCount    = 0;
+    unsigned int buttonMapCount = 0;
+
+    size_t Total(void) const { return devices + originalDevices + buttonMaps + originalButtonMaps; }
+  };
+
+  /*!
+   * \brief Bytes held for a single controller profile
+   */
+  struct ControllerFootprint
+  {
+    size_t buttonMaps         = 0; // Features mapped to this controller
+    size_t originalButtonMaps = 0; // Backup copies of those features
+    size_t controllerMap      = 0; // Feature translations from this controller
+
+    size_t Total(void) const { return buttonMaps + originalButtonMaps + controllerMap; }
+  };
+
+  /*!
+   * \brief Snapshot of the memory held by the storage subsystems
+   *
+   * Sizes are estimates. They count the objects, the heap blocks owned by
+   * their strings and vectors, and one tree node per container entry, but
+   * not allocator bookkeeping.
+   */
+  struct StorageFootprint
+  {
+    std::map<std::string, ProviderFootprint>   providers;   // Provider -> footprint
+    std::map<std::string, ControllerFootprint> controllers; // Controller ID -> footprint, a second view of the bytes
+
+    size_t directoryCache  = 0; // Cached directory listings
+    size_t controllerMap   = 0; // Feature translations learned by the controller transformer
+    size_t observedDevices = 0; // Devices seen by the controller transformer
+    size_t familyMap       = 0; // Joystick families
+
+    size_t Total(void) const;
+  };
+
+  class CStorageFootprint
+  {
+  public:
+    /*!
+     * \brief Estimate the bytes held by a tree node, excluding its value
+     */
+    static size_t MapNode(void);
+
+    /*!
+     * \brief Estimate the bytes held by the control block of a shared pointer
+     */
+    static size_t SharedPointer(void);
+
+    /*!
+     * \brief Estimate the heap bytes owned by a string
+     */
+    static size_t String(const std::string& str);
+
+    /*!
+     * \brief Estimate the bytes held by a device record
+     */
+    static size_t Device(const CDevice& device);
+
+    /*!
+     * \brief Estimate the bytes held by a device map entry
+     *
+     * \param key The device record used as the map key
+     * \param device The shared device record stored in the map
+     */
+    static size_t DeviceRecord(const CDevice& key, const DevicePtr& device);
+
+    /*!
+     * \brief Estimate the bytes held by a list of features
+     */
+    static size_t Features(const FeatureVector& features);
+
+    /*!
+     * \brief Add the bytes held by a button map to a snapshot
+     *
+     * \param buttonMap The controller profiles of a device
+     * \param bOriginal True if the button map is a backup copy
+     * \param footprint The snapshot to update
+     *
+     * \return The total bytes held by the button map
+     */
+    static size_t AddButtonMap(const ButtonMap& buttonMap, bool bOriginal, StorageFootprint& footprint);
+
+    /*!
+     * \brief Log a snapshot, broken down by provider and controller profile
+     */
+    static void Log(const StorageFootprint& footprint);
+  };
+}
@@ -20,6 +20,7 @@
 
 #include "StorageManager.h"
 #include "JustABunchOfFiles.h"
+#include "StorageFootprint.h"
 #include "StorageUtils.h"
 #include "buttonmapper/ButtonMapper.h"
 #include "log/Log.h"
@@ -63,7 +64,7 @@ bool CStorageManager::Initialize(ADDON::CHelper_libKODI_peripheral* peripheralLi
   std::string strUserPath = props.user_path ? props.user_path : "";
   std::string strAddonPath = props.addon_path ? props.addon_path : "";
 
-  if (peripheralLib == NULL || strUserPath.empty() || strAddonPath.empty())
+  if (strUserPath.empty() || strAddonPath.empty())
     return false;
 
   m_peripheralLib = peripheralLib;
@@ -129,6 +130,10 @@ bool CStorageManager::MapFeatures(const ADDON::Joystick& joystick,
   for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
     bSuccess |= (*it)->MapFeatures(joystick, strControllerId, features);
 
+  // Features built from the old button map may be cached
+  if (m_buttonMapper)
+    m_buttonMapper->InvalidateFeatures();
+
   return bSuccess;
 }
 
@@ -148,9 +153,45 @@ bool CStorageManager::SetIgnoredPrimitives(const ADDON::Joystick& joystick, cons
   for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
     bSuccess |= (*it)->SetIgnoredPrimitives(joystick, primitives);
 
+  if (m_buttonMapper)
+    m_buttonMapper->InvalidateFeatures();
+
   return bSuccess;
 }
 
+void CStorageManager::GetAxisConfigurations(const ADDON::Joystick& joystick, AxisConfigurationMap& axes)
+{
+  for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
+  {
+    if ((*it)->GetAxisConfigurations(joystick, axes))
+      break;
+  }
+}
+
+bool CStorageManager::GetExclusiveGrab(const ADDON::Joystick& joystick)
+{
+  bool bExclusive = false;
+
+  for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
+  {
+    if ((*it)->GetExclusiveGrab(joystick, bExclusive))
+      break;
+  }
+
+  return bExclusive;
+}
+
+bool CStorageManager::HasButtonMap(const ADDON::Joystick& joystick)
+{
+  for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
+  {
+    if ((*it)->HasButtonMap(joystick))
+      return true;
+  }
+
+  return false;
+}
+
 bool CStorageManager::SaveButtonMap(const ADDON::Joystick& joystick)
 {
   bool bModified = false;
@@ -158,6 +199,9 @@ bool CStorageManager::SaveButtonMap(const ADDON::Joystick& joystick)
   for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
     bModified |= (*it)->SaveButtonMap(joystick);
 
+  if (m_buttonMapper)
+    m_buttonMapper->InvalidateFeatures();
+
   return bModified;
 }
 
@@ -168,6 +212,9 @@ bool CStorageManager::RevertButtonMap(const ADDON::Joystick& joystick)
   for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
     bModified |= (*it)->RevertButtonMap(joystick);
 
+  if (m_buttonMapper)
+    m_buttonMapper->InvalidateFeatures();
+
   return bModified;
 }
 
@@ -178,6 +225,9 @@ bool CStorageManager::ResetButtonMap(const ADDON::Joystick& joystick, const std:
   for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
     bModified |= (*it)->ResetButtonMap(joystick, strControllerId);
 
+  if (m_buttonMapper)
+    m_buttonMapper->InvalidateFeatures();
+
   return bModified;
 }
 
@@ -187,3 +237,22 @@ void CStorageManager::RefreshButtonMaps(const std::string& strDeviceName /* = ""
   if (m_peripheralLib)
     m_peripheralLib->RefreshButtonMaps(strDeviceName);
 }
+
+void CStorageManager::GetMemoryFootprint(StorageFootprint& footprint)
+{
+  for (DatabaseVector::const_iterator it = m_databases.begin(); it != m_databases.end(); ++it)
+    (*it)->GetMemoryFootprint(footprint);
+
+  if (m_buttonMapper)
+    m_buttonMapper->GetMemoryFootprint(footprint);
+
+  footprint.familyMap += m_familyManager.GetMemoryFootprint();
+}
+
+void CStorageManager::LogMemoryFootprint(void)
+{
+  StorageFootprint footprint;
+  GetMemoryFootprint(footprint);
+
+  CStorageFootprint::Log(footprint);
+}
@@ -19,6 +19,7 @@
  */
 #pragma once
 
+#include "PrimitiveConfiguration.h"
 #include "StorageTypes.h"
 #include "buttonmapper/ButtonMapTypes.h"
 #include "buttonmapper/JoystickFamily.h"
@@ -41,6 +42,7 @@ namespace JOYSTICK
   class CButtonMapper;
   class CDevice;
   class IDatabase;
+  struct StorageFootprint;
 
   class CStorageManager
   {
@@ -55,7 +57,8 @@ namespace JOYSTICK
     /*!
      * \brief Initialize storage manager
      *
-     * \param peripheralLib The peripheral API helper library
+     * \param peripheralLib The peripheral API helper library, or null when running
+     *                      without the frontend, such as in the benchmarks
      * \param props used in add-on creation (TODO: Change to two strings)
      *
      * \return true if the storage manager has been initialized and can be safely used
@@ -112,6 +115,32 @@ namespace JOYSTICK
      */
     bool SetIgnoredPrimitives(const ADDON::Joystick& joystick, const PrimitiveVector& primitives);
 
+    /*!
+     * \brief Get the axis configurations from a storage backend
+     *
+     * \param joystick      The device's joystick properties; unknown values may be left at their default
+     * \param axes          The configuration of each axis, such as its calibration
+     */
+    void GetAxisConfigurations(const ADDON::Joystick& joystick, AxisConfigurationMap& axes);
+
+    /*!
+     * \brief Check if a device is configured to be grabbed from other programs
+     *
+     * \param joystick      The device's joystick properties; unknown values may be left at their default
+     *
+     * \return true if a storage backend configures the device for exclusive grab
+     */
+    bool GetExclusiveGrab(const ADDON::Joystick& joystick);
+
+    /*!
+     * \brief Check if a button map is stored for the device
+     *
+     * \param joystick      The device's joystick properties; unknown values may be left at their default
+     *
+     * \return true if a storage backend has a button map for the device record
+     */
+    bool HasButtonMap(const ADDON::Joystick& joystick);
+
     /*!
      * \brief Save the button map for the specified device
      *
@@ -149,6 +178,18 @@ namespace JOYSTICK
      */
     void RefreshButtonMaps(const std::string& strDeviceName = "");
 
+    /*!
+     * \brief Take a snapshot of the memory held by the storage subsystems
+     *
+     * \param footprint The snapshot, broken down by provider and controller profile
+     */
+    void GetMemoryFootprint(StorageFootprint& footprint);
+
+    /*!
+     * \brief Log a snapshot of the memory held by the storage subsystems
+     */
+    void LogMemoryFootprint(void);
+
   private:
     ADDON::CHelper_libKODI_peripheral* m_peripheralLib;
 
@@ -29,6 +29,12 @@ const ButtonMap& CDatabaseJoystickAPI::GetButtonMap(const ADDON::Joystick& drive
   return CJoystickManager::Get().GetButtonMap(driverInfo.Provider());
 }
 
+bool CDatabaseJoystickAPI::HasButtonMap(const ADDON::Joystick& driverInfo)
+{
+  // The drivers' button maps are per provider, not per device
+  return false;
+}
+
 bool CDatabaseJoystickAPI::MapFeatures(const ADDON::Joystick& driverInfo, const std::string& controllerId, const FeatureVector& features)
 {
   return false;
@@ -44,6 +50,16 @@ bool CDatabaseJoystickAPI::SetIgnoredPrimitives(const ADDON::Joystick& joystick,
   return false;
 }
 
+bool CDatabaseJoystickAPI::GetAxisConfigurations(const ADDON::Joystick& driverInfo, AxisConfigurationMap& axes)
+{
+  return false;
+}
+
+bool CDatabaseJoystickAPI::GetExclusiveGrab(const ADDON::Joystick& driverInfo, bool& bExclusive)
+{
+  return false;
+}
+
 bool CDatabaseJoystickAPI::SaveButtonMap(const ADDON::Joystick& driverInfo)
 {
   return false;
@@ -58,3 +74,8 @@ bool CDatabaseJoystickAPI::ResetButtonMap(const ADDON::Joystick& driverInfo, con
 {
   return false;
 }
+
+void CDatabaseJoystickAPI::GetMemoryFootprint(StorageFootprint& footprint)
+{
+  // Button maps are owned by the joystick interfaces
+}
@@ -32,11 +32,15 @@ namespace JOYSTICK
 
     // implementation of IDatabase
     virtual const ButtonMap& GetButtonMap(const ADDON::Joystick& driverInfo) override;
+    virtual bool HasButtonMap(const ADDON::Joystick& driverInfo) override;
     virtual bool MapFeatures(const ADDON::Joystick& driverInfo, const std::string& controllerId, const FeatureVector& features) override;
     virtual bool GetIgnoredPrimitives(const ADDON::Joystick& driverInfo, PrimitiveVector& primitives) override;
     virtual bool SetIgnoredPrimitives(const ADDON::Joystick& driverInfo, const PrimitiveVector& primitives) override;
+    virtual bool GetAxisConfigurations(const ADDON::Joystick& driverInfo, AxisConfigurationMap& axes) override;
+    virtual bool GetExclusiveGrab(const ADDON::Joystick& driverInfo, bool& bExclusive) override;
     virtual bool SaveButtonMap(const ADDON::Joystick& driverInfo) override;
     virtual bool RevertButtonMap(const ADDON::Joystick& driverInfo) override;
     virtual bool ResetButtonMap(const ADDON::Joystick& driverInfo, const std::string& controllerId) override;
+    virtual void GetMemoryFootprint(StorageFootprint& footprint) override;
   };
 }
@@ -57,4 +57,7 @@
 #define BUTTONMAP_XML_ATTR_DRIVER_INDEX        "index"
 #define BUTTONMAP_XML_ATTR_AXIS_CENTER         "center"
 #define BUTTONMAP_XML_ATTR_AXIS_RANGE          "range"
+#define BUTTONMAP_XML_ATTR_AXIS_FUZZ           "fuzz"
+#define BUTTONMAP_XML_ATTR_AXIS_FLAT           "flat"
 #define BUTTONMAP_XML_ATTR_IGNORE              "ignore"
+#define BUTTONMAP_XML_ATTR_EXCLUSIVE_GRAB      "exclusivegrab"
@@ -21,9 +21,12 @@
 #include "ButtonMapXml.h"
 #include "ButtonMapDefinitions.h"
 #include "DeviceXml.h"
+#include "XmlUtils.h"
 #include "buttonmapper/ButtonMapTranslator.h"
+#include "filesystem/FileUtils.h"
 #include "storage/Device.h"
 #include "log/Log.h"
+#include "metrics/Tracer.h"
 
 #include "tinyxml.h"
 
@@ -47,8 +50,10 @@ CButtonMapXml::CButtonMapXml(const std::string& strResourcePath, const DevicePtr
 
 bool CButtonMapXml::Load(void)
 {
+  TRACE_SPAN("CButtonMapXml::Load");
+
   TiXmlDocument xmlFile;
-  if (!xmlFile.LoadFile(m_strResourcePath))
+  if (!CXmlUtils::LoadFile(m_strResourcePath, xmlFile))
   {
     esyslog("Error opening %s: %s", m_strResourcePath.c_str(), xmlFile.ErrorDesc());
     return false;
@@ -149,6 +154,17 @@ bool CButtonMapXml::Save(void) const
   if (!SerializeButtonMaps(deviceElem))
     return false;
 
+  // Save to a temporary file and rename it over the button map, so that an
+  // interrupted save can't leave a truncated button map behind
+  const std::string strTempPath = m_strResourcePath + ".tmp";
+  if (xmlFile.SaveFile(strTempPath))
+  {
+    if (CFileUtils::Rename(strTempPath, m_strResourcePath))
+      return true;
+
+    CFileUtils::Delete(strTempPath);
+  }
+
   return xmlFile.SaveFile(m_strResourcePath);
 }
 
@@ -126,6 +126,9 @@ bool CDeviceXml::SerializeConfig(const CDeviceConfiguration& config, TiXmlElemen
     if (configurationElem == nullptr)
       return false;
 
+    if (config.ExclusiveGrab())
+      configurationElem->SetAttribute(BUTTONMAP_XML_ATTR_EXCLUSIVE_GRAB, "true");
+
     for (const auto& axis : config.Axes())
     {
       if (!SerializeAxis(axis.first, axis.second, configurationElem))
@@ -148,6 +151,10 @@ bool CDeviceXml::DeserializeConfig(const TiXmlElement* pElement, CDeviceConfigur
 
   if (pDevice)
   {
+    const char* exclusiveGrab = pDevice->Attribute(BUTTONMAP_XML_ATTR_EXCLUSIVE_GRAB);
+    if (exclusiveGrab)
+      config.SetExclusiveGrab(std::string(exclusiveGrab) == "true");
+
     const TiXmlElement* pAxis = pDevice->FirstChildElement(BUTTONMAP_XML_ELEM_AXIS);
 
     for ( ; pAxis != nullptr; pAxis = pAxis->NextSiblingElement(BUTTONMAP_XML_ELEM_AXIS))
@@ -199,6 +206,12 @@ bool CDeviceXml::SerializeAxis(unsigned int index, const AxisConfiguration& axis
       axisElem->SetAttribute(BUTTONMAP_XML_ATTR_AXIS_RANGE, axisConfig.trigger.range);
     }
 
+    if (axisConfig.fuzz != 0)
+      axisElem->SetAttribute(BUTTONMAP_XML_ATTR_AXIS_FUZZ, axisConfig.fuzz);
+
+    if (axisConfig.flat != 0)
+      axisElem->SetAttribute(BUTTONMAP_XML_ATTR_AXIS_FLAT, axisConfig.flat);
+
     if (axisConfig.bIgnore)
       axisElem->SetAttribute(BUTTONMAP_XML_ATTR_IGNORE, "true");
   }
@@ -249,6 +262,14 @@ bool CDeviceXml::DeserializeAxis(const TiXmlElement* pElement, unsigned int& ind
   if (range)
     config.trigger.range = std::atoi(range);
 
+  const char* fuzz = pElement->Attribute(BUTTONMAP_XML_ATTR_AXIS_FUZZ);
+  if (fuzz)
+    config.fuzz = std::atoi(fuzz);
+
+  const char* flat = pElement->Attribute(BUTTONMAP_XML_ATTR_AXIS_FLAT);
+  if (flat)
+    config.flat = std::atoi(flat);
+
   const char* ignore = pElement->Attribute(BUTTONMAP_XML_ATTR_IGNORE);
   if (ignore)
     config.bIgnore = (std::string(ignore) == "true");
@@ -20,6 +20,7 @@
 
 #include "JoystickFamiliesXml.h"
 #include "JoystickFamilyDefinitions.h"
+#include "XmlUtils.h"
 #include "log/Log.h"
 
 #include "tinyxml.h"
@@ -29,7 +30,7 @@ using namespace JOYSTICK;
 bool CJoystickFamiliesXml::LoadFamilies(const std::string& path, JoystickFamilyMap& result)
 {
   TiXmlDocument xmlFile;
-  if (!xmlFile.LoadFile(path))
+  if (!CXmlUtils::LoadFile(path, xmlFile))
   {
     esyslog("Error opening %s: %s", path.c_str(), xmlFile.ErrorDesc());
     return false;
@@ -0,0 +1,47 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "XmlUtils.h"
+#include "filesystem/FileUtils.h"
+#include "metrics/Metrics.h"
+
+#include "tinyxml.h"
+
+using namespace JOYSTICK;
+
+bool CXmlUtils::LoadFile(const std::string& path, TiXmlDocument& xmlFile)
+{
+  CMetricTimer timer(METRIC_XML_PARSE);
+  FilePtr file = CFileUtils::OpenFile(path);
+  if (file)
+  {
+    const char* data = nullptr;
+    uint64_t size = 0;
+    if (file->ReadView(data, size))
+    {
+      xmlFile.SetValue(path);
+      xmlFile.Parse(data);
+      return !xmlFile.Error();
+    }
+  }
+
+  // Fall back to letting TinyXML open the file
+  return xmlFile.LoadFile(path);
+}
@@ -0,0 +1,216 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/SyntheticInterface.h"
+#include "support/SyntheticJoystick.h"
+
+#include "api/JoystickManager.h"
+#include "api/JoystickStateArena.h"
+#include "buttonmapper/ButtonMapper.h"
+#include "buttonmapper/JoystickFamily.h"
+#include "metrics/AllocationTracker.h"
+#include "storage/IDatabase.h"
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <catch2/catch.hpp>
+#include <memory>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define WARMUP_FRAMES    64   // Frames before allocations are counted
+#define MEASURED_FRAMES  1000 // Frames that must not allocate
+
+namespace
+{
+  /*!
+   * \brief Change a few values each frame, including held axes
+   */
+  void SimulateFrame(CSyntheticJoystick& joystick, unsigned int frame)
+  {
+    joystick.SetButton(frame % joystick.ButtonCount(), (frame / joystick.ButtonCount()) % 2 == 0);
+    joystick.SetHat(0, frame % 4 == 0 ? JOYSTICK_STATE_HAT_UP : JOYSTICK_STATE_HAT_UNPRESSED);
+    joystick.SetAxis(0, (frame % 20) / 10.0f - 1.0f);
+    joystick.SetAxis(1, 0.5f);
+  }
+
+  /*!
+   * \brief Database that returns the same button map for every device
+   */
+  class CMemoryDatabase : public IDatabase
+  {
+  public:
+    CMemoryDatabase(const ButtonMap& buttonMap) : IDatabase(nullptr), m_buttonMap(buttonMap) { }
+
+    // implementation of IDatabase
+    virtual const ButtonMap& GetButtonMap(const ADDON::Joystick& driverInfo) override { return m_buttonMap; }
+    virtual bool HasButtonMap(const ADDON::Joystick& driverInfo) override { return !m_buttonMap.empty(); }
+    virtual bool MapFeatures(const ADDON::Joystick& driverInfo, const std::string& controllerId, const FeatureVector& features) override { return false; }
+    virtual bool GetIgnoredPrimitives(const ADDON::Joystick& driverInfo, PrimitiveVector& primitives) override { return false; }
+    virtual bool SetIgnoredPrimitives(const ADDON::Joystick& driverInfo, const PrimitiveVector& primitives) override { return false; }
+    virtual bool GetAxisConfigurations(const ADDON::Joystick& driverInfo, AxisConfigurationMap& axes) override { return false; }
+    virtual bool GetExclusiveGrab(const ADDON::Joystick& driverInfo, bool& bExclusive) override { return false; }
+    virtual bool SaveButtonMap(const ADDON::Joystick& driverInfo) override { return false; }
+    virtual bool RevertButtonMap(const ADDON::Joystick& driverInfo) override { return false; }
+    virtual bool ResetButtonMap(const ADDON::Joystick& driverInfo, const std::string& controllerId) override { return false; }
+    virtual void GetMemoryFootprint(StorageFootprint& footprint) override { }
+
+  private:
+    const ButtonMap m_buttonMap;
+  };
+}
+
+TEST_CASE("Allocation tracking counts the test's allocations", "[allocations]")
+{
+  CAllocationScope scope;
+  std::unique_ptr<int> allocation(new int(0));
+
+  REQUIRE(scope.GetStats().allocations == 1);
+}
+
+TEST_CASE("CJoystick::GetEvents doesn't allocate after warm-up", "[allocations]")
+{
+  std::shared_ptr<CSyntheticJoystick> joystick = std::make_shared<CSyntheticJoystick>("Synthetic pad", 16, 1, 6);
+  REQUIRE(joystick->Initialize());
+
+  CJoystickStateArena arena;
+  arena.Rebuild(JoystickVector{ joystick });
+
+  std::vector<ADDON::PeripheralEvent> events;
+  std::vector<int64_t> eventTimes;
+
+  uint64_t eventCount = 0;
+
+  auto runFrames = [&](unsigned int begin, unsigned int end)
+  {
+    for (unsigned int frame = begin; frame < end; frame++)
+    {
+      SimulateFrame(*joystick, frame);
+
+      events.clear();
+      eventTimes.clear();
+
+      REQUIRE(joystick->ScanState());
+      arena.Diff();
+      joystick->GetEvents(events, eventTimes);
+      arena.Commit();
+
+      eventCount += events.size();
+    }
+  };
+
+  runFrames(0, WARMUP_FRAMES);
+
+  CAllocationScope scope;
+  runFrames(WARMUP_FRAMES, WARMUP_FRAMES + MEASURED_FRAMES);
+  const AllocationStats stats = scope.GetStats();
+
+  CHECK(eventCount > MEASURED_FRAMES);
+  REQUIRE(stats.allocations == 0);
+
+  arena.Clear(JoystickVector{ joystick });
+}
+
+TEST_CASE("CJoystickManager::GetEvents doesn't allocate after warm-up", "[allocations]")
+{
+  std::vector<std::shared_ptr<CSyntheticJoystick>> pads;
+  JoystickVector joysticks;
+  for (unsigned int i = 0; i < 4; i++)
+  {
+    pads.push_back(std::make_shared<CSyntheticJoystick>("Synthetic pad " + std::to_string(i), 16, 1, 6));
+    joysticks.push_back(pads.back());
+  }
+
+  CNullScanner scanner;
+  REQUIRE(CJoystickManager::Get().Initialize(&scanner, { new CSyntheticInterface(joysticks) }));
+
+  JoystickVector scanned;
+  REQUIRE(CJoystickManager::Get().PerformJoystickScan(scanned));
+  REQUIRE(scanned.size() == pads.size());
+
+  std::vector<ADDON::PeripheralEvent> events;
+
+  uint64_t eventCount = 0;
+
+  auto runFrames = [&](unsigned int begin, unsigned int end)
+  {
+    for (unsigned int frame = begin; frame < end; frame++)
+    {
+      for (unsigned int i = 0; i < pads.size(); i++)
+        SimulateFrame(*pads[i], frame + i);
+
+      events.clear();
+      REQUIRE(CJoystickManager::Get().GetEvents(events));
+
+      eventCount += events.size();
+    }
+  };
+
+  runFrames(0, WARMUP_FRAMES);
+
+  CAllocationScope scope;
+  runFrames(WARMUP_FRAMES, WARMUP_FRAMES + MEASURED_FRAMES);
+  const AllocationStats stats = scope.GetStats();
+
+  CJoystickManager::Get().Deinitialize();
+
+  CHECK(eventCount > MEASURED_FRAMES * pads.size());
+  REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Cached CButtonMapper::GetFeatures doesn't allocate", "[allocations]")
+{
+  FeatureVector features;
+  for (unsigned int i = 0; i < 20; i++)
+  {
+    ADDON::JoystickFeature feature("feature" + std::to_string(i), JOYSTICK_FEATURE_TYPE_SCALAR);
+    feature.SetPrimitive(JOYSTICK_SCALAR_PRIMITIVE, ADDON::DriverPrimitive::CreateButton(i));
+    features.push_back(feature);
+  }
+
+  const std::string controllerId = "game.controller.default";
+
+  ButtonMap buttonMap;
+  buttonMap[controllerId] = features;
+
+  CJoystickFamilyManager familyManager;
+  CButtonMapper buttonMapper(nullptr);
+  REQUIRE(buttonMapper.Initialize(familyManager));
+  buttonMapper.RegisterDatabase(DatabasePtr(new CMemoryDatabase(buttonMap)));
+
+  ADDON::Joystick joystick(INTERFACE_SYNTHETIC, "Synthetic pad");
+  joystick.SetButtonCount(20);
+
+  // The caller reuses its vector, so only the first call grows it
+  FeatureVector result;
+  REQUIRE(buttonMapper.GetFeatures(joystick, controllerId, result));
+  REQUIRE(result.size() == features.size());
+
+  CAllocationScope scope;
+  for (unsigned int i = 0; i < MEASURED_FRAMES; i++)
+    buttonMapper.GetFeatures(joystick, controllerId, result);
+  const AllocationStats stats = scope.GetStats();
+
+  REQUIRE(result.size() == features.size());
+  REQUIRE(stats.allocations == 0);
+
+  buttonMapper.Deinitialize();
+}
@@ -0,0 +1,291 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/HidTestData.h"
+
+#include "api/JoystickState.h"
+#include "api/JoystickStateArena.h"
+#include "api/hidraw/HidDecodePlan.h"
+#include "api/hidraw/HidReportDecoder.h"
+#include "api/hidraw/JoystickHidraw.h"
+#include "api/hidraw/JoystickInterfaceHidraw.h"
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <fcntl.h>
+#include <linux/hidraw.h>
+#include <linux/input.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  /*!
+   * \brief State expected after replaying a report
+   */
+  struct ExpectedState
+  {
+    std::vector<unsigned int> pressedButtons;
+    std::vector<float>        axes;
+    JOYSTICK_STATE_HAT        hat;
+  };
+
+  /*!
+   * \brief Value of an axis with a logical range of 0 to 255
+   */
+  float Axis8(unsigned int value)
+  {
+    return (static_cast<float>(value) - 127.5f) / 127.5f;
+  }
+
+  /*!
+   * \brief Replay reports the way hidraw delivers them, and compare the
+   *        state after each one
+   *
+   * \param joystick The joystick, reading from the other end of reportFd
+   * \param reportFd The write end of the joystick's pipe
+   */
+  void ReplayReports(const JoystickPtr& joystick, int reportFd, const std::vector<std::vector<uint8_t>>& reports, const std::vector<ExpectedState>& expected)
+  {
+    REQUIRE(reports.size() == expected.size());
+    REQUIRE(joystick->Initialize());
+
+    CJoystickStateArena arena;
+    arena.Rebuild(JoystickVector{ joystick });
+
+    std::vector<ADDON::PeripheralEvent> events;
+    std::vector<int64_t> eventTimes;
+    std::vector<uint64_t> record((joystick->StateRecordSize() + 7) / 8);
+
+    for (unsigned int i = 0; i < reports.size(); i++)
+    {
+      INFO("Report " << i);
+
+      const std::vector<uint8_t>& report = reports[i];
+      REQUIRE(write(reportFd, report.data(), report.size()) == static_cast<ssize_t>(report.size()));
+
+      REQUIRE(joystick->ScanState());
+      arena.Diff();
+      joystick->GetEvents(events, eventTimes);
+      arena.Commit();
+
+      joystick->CopyState(reinterpret_cast<uint8_t*>(record.data()));
+
+      const JoystickStateRecord& header = *reinterpret_cast<const JoystickStateRecord*>(record.data());
+      REQUIRE(header.axisCount == expected[i].axes.size());
+
+      const float* axes = reinterpret_cast<const float*>(&header + 1);
+      for (unsigned int axis = 0; axis < header.axisCount; axis++)
+        CHECK(axes[axis] == Approx(expected[i].axes[axis]).margin(0.001));
+
+      const uint8_t* buttons = reinterpret_cast<const uint8_t*>(axes + header.axisCount);
+      for (unsigned int button = 0; button < header.buttonCount; button++)
+      {
+        const bool bExpected = std::find(expected[i].pressedButtons.begin(), expected[i].pressedButtons.end(), button) != expected[i].pressedButtons.end();
+
+        INFO("Button " << button);
+        CHECK((buttons[button] == JOYSTICK_STATE_BUTTON_PRESSED) == bExpected);
+      }
+
+      REQUIRE(header.hatCount == 1);
+      const uint8_t* hats = buttons + header.buttonCount;
+      CHECK(hats[0] == expected[i].hat);
+    }
+
+    arena.Clear(JoystickVector{ joystick });
+  }
+
+  /*!
+   * \brief Replay reports through a joystick with the given plan and decoder
+   *
+   * \param decoder The compile-time decoder, or nullptr to only use the plan
+   */
+  void ReplayReports(const CHidDecodePlan& parsedPlan, const IHidReportDecoder* decoder, const std::vector<std::vector<uint8_t>>& reports, const std::vector<ExpectedState>& expected)
+  {
+    int fds[2];
+    REQUIRE(pipe2(fds, O_CLOEXEC | O_NONBLOCK) == 0);
+
+    // The joystick owns the read end
+    HidDecodePlanPtr plan = std::make_shared<CHidDecodePlan>(parsedPlan);
+    ReplayReports(std::make_shared<CJoystickHidraw>(fds[0], "pipe", 0, plan, decoder), fds[1], reports, expected);
+
+    close(fds[1]);
+  }
+}
+
+TEST_CASE("DualShock 4 descriptor is parsed into a decode plan", "[hid]")
+{
+  const std::vector<uint8_t> descriptor = CHidTestData::ReadDescriptor("ds4.rdesc");
+  REQUIRE(!descriptor.empty());
+
+  CHidDecodePlan plan;
+  REQUIRE(plan.Parse(descriptor.data(), descriptor.size()));
+
+  CHECK(plan.ButtonCount() == 14);
+  CHECK(plan.AxisCount() == 6);
+  CHECK(plan.HatCount() == 1);
+  CHECK(plan.MaxReportLength() == 64);
+
+  // Report 1 is the input report, the output report isn't decoded
+  const uint8_t inputReport[64] = { 0x01 };
+  const HidReportPlan* reportPlan = plan.GetReportPlan(inputReport, sizeof(inputReport));
+  REQUIRE(reportPlan != nullptr);
+  CHECK(reportPlan->byteLength == 64);
+  CHECK(reportPlan->hats[0].bitOffset == 40);
+  CHECK(reportPlan->buttons[0].bitOffset == 44);
+  CHECK(reportPlan->axes[4].bitOffset == 64);
+
+  const uint8_t outputReport[64] = { 0x05 };
+  CHECK(plan.GetReportPlan(outputReport, sizeof(outputReport)) == nullptr);
+}
+
+TEST_CASE("DualShock 4 reports are decoded by the generic plan", "[hid]")
+{
+  const std::vector<uint8_t> descriptor = CHidTestData::ReadDescriptor("ds4.rdesc");
+
+  CHidDecodePlan plan;
+  REQUIRE(plan.Parse(descriptor.data(), descriptor.size()));
+
+  const float rest = Axis8(0x80);
+  const float trigger = Axis8(0x40);
+
+  // Axes are LX, LY, RX, RY, L2, R2
+  const std::vector<ExpectedState> expected =
+  {
+    { { },          { rest, rest, rest, rest, trigger, trigger },                 JOYSTICK_STATE_HAT_UNPRESSED },
+    { { 1 },        { -1.0f, 1.0f, rest, rest, trigger, trigger },                JOYSTICK_STATE_HAT_UP },
+    { { 4, 5, 9 },  { rest, rest, rest, rest, trigger, 1.0f },                    JOYSTICK_STATE_HAT_RIGHT_DOWN },
+    { { 12, 13 },   { rest, rest, Axis8(0xC0), Axis8(0x40), trigger, trigger },   JOYSTICK_STATE_HAT_LEFT },
+    { { },          { rest, rest, rest, rest, trigger, trigger },                 JOYSTICK_STATE_HAT_UNPRESSED },
+    { { },          { rest, rest, rest, rest, trigger, trigger },                 JOYSTICK_STATE_HAT_UNPRESSED },
+  };
+
+  ReplayReports(plan, nullptr, CHidTestData::ReadReports("ds4.reports"), expected);
+}
+
+TEST_CASE("DragonRise descriptor is parsed into a decode plan", "[hid]")
+{
+  const std::vector<uint8_t> descriptor = CHidTestData::ReadDescriptor("dragonrise.rdesc");
+  REQUIRE(!descriptor.empty());
+
+  CHidDecodePlan plan;
+  REQUIRE(plan.Parse(descriptor.data(), descriptor.size()));
+
+  CHECK(plan.ButtonCount() == 12);
+  CHECK(plan.AxisCount() == 5);
+  CHECK(plan.HatCount() == 1);
+  CHECK(plan.MaxReportLength() == 8);
+}
+
+TEST_CASE("DragonRise reports are decoded by the generic plan", "[hid]")
+{
+  const std::vector<uint8_t> descriptor = CHidTestData::ReadDescriptor("dragonrise.rdesc");
+
+  CHidDecodePlan plan;
+  REQUIRE(plan.Parse(descriptor.data(), descriptor.size()));
+
+  const float rest = Axis8(0x80);
+
+  // Axes are X, Y, Z, Z, Rz
+  const std::vector<ExpectedState> expected =
+  {
+    { { },       { rest, rest, rest, rest, rest },          JOYSTICK_STATE_HAT_UNPRESSED },
+    { { 0, 2 },  { -1.0f, 1.0f, rest, rest, rest },         JOYSTICK_STATE_HAT_UP },
+    { { 4, 11 }, { rest, rest, rest, rest, Axis8(0xC0) },   JOYSTICK_STATE_HAT_DOWN },
+    { { },       { rest, rest, rest, rest, rest },          JOYSTICK_STATE_HAT_LEFT_UP },
+    { { },       { rest, rest, rest, rest, rest },          JOYSTICK_STATE_HAT_LEFT_UP },
+  };
+
+  ReplayReports(plan, nullptr, CHidTestData::ReadReports("dragonrise.reports"), expected);
+}
+
+TEST_CASE("Switch Pro full reports are decoded by the compile-time layout", "[hid]")
+{
+  const IHidReportDecoder* decoder = CHidReportDecoders::GetDecoder(BUS_BLUETOOTH, 0x057E, 0x2009);
+  REQUIRE(decoder != nullptr);
+
+  // Without a descriptor, reports the layout rejects are ignored
+  CHidDecodePlan plan;
+
+  // Sticks rest at 0x808, and range from 0x001 to 0xFFF
+  const float rest = static_cast<float>(0x008) / 0x7FF;
+  const float half = static_cast<float>(0x400) / 0x7FF;
+
+  // Axes are LX, LY, RX, RY
+  const std::vector<ExpectedState> expected =
+  {
+    { { },          { rest, rest, rest, rest },     JOYSTICK_STATE_HAT_UNPRESSED },
+    { { 1, 12 },    { -1.0f, 1.0f, rest, rest },    JOYSTICK_STATE_HAT_RIGHT_UP },
+    { { 5, 6, 10 }, { rest, rest, half, -half },    JOYSTICK_STATE_HAT_LEFT_DOWN },
+    { { 2 },        { rest, rest, rest, rest },     JOYSTICK_STATE_HAT_UNPRESSED },
+    { { 2 },        { rest, rest, rest, rest },     JOYSTICK_STATE_HAT_UNPRESSED },
+  };
+
+  ReplayReports(plan, decoder, CHidTestData::ReadReports("switchpro.reports"), expected);
+}
+
+TEST_CASE("Switch Pro simple reports fall back to the descriptor's plan", "[hid]")
+{
+  const std::vector<uint8_t> descriptor = CHidTestData::ReadDescriptor("switchpro.rdesc");
+  REQUIRE(!descriptor.empty());
+
+  int fds[2];
+  REQUIRE(pipe2(fds, O_CLOEXEC | O_NONBLOCK) == 0);
+
+  // Create the joystick the way the interface does for a hidraw node
+  hidraw_devinfo info = { };
+  info.bustype = BUS_BLUETOOTH;
+  info.vendor = 0x057E;
+  info.product = 0x2009;
+
+  JoystickPtr joystick = CJoystickInterfaceHidraw::CreateJoystick(fds[0], "pipe", 0, info, descriptor.data(), descriptor.size());
+  REQUIRE(joystick);
+
+  // The descriptor has more buttons than the compile-time layout
+  CHECK(joystick->ButtonCount() == 16);
+  CHECK(joystick->AxisCount() == 4);
+  CHECK(joystick->HatCount() == 1);
+
+  // Simple report sticks have a logical range of 0 to 65535
+  const float half = (static_cast<float>(0xC000) - 32767.5f) / 32767.5f;
+
+  // Full report sticks rest at 0x808
+  const float fullRest = static_cast<float>(0x008) / 0x7FF;
+
+  // Axes are LX, LY, RX, RY
+  const std::vector<ExpectedState> expected =
+  {
+    { { },      { 0.0f, 0.0f, 0.0f, 0.0f },                   JOYSTICK_STATE_HAT_UNPRESSED },
+    { { 0, 9 }, { -1.0f, 1.0f, 0.0f, 0.0f },                  JOYSTICK_STATE_HAT_UP },
+    { { 15 },   { 0.0f, 0.0f, half, 0.0f },                   JOYSTICK_STATE_HAT_RIGHT },
+    { { },      { fullRest, fullRest, fullRest, fullRest },   JOYSTICK_STATE_HAT_UNPRESSED },
+    { { },      { 0.0f, 0.0f, 0.0f, 0.0f },                   JOYSTICK_STATE_HAT_UNPRESSED },
+  };
+
+  ReplayReports(joystick, fds[1], CHidTestData::ReadReports("switchpro_simple.reports"), expected);
+
+  close(fds[1]);
+}
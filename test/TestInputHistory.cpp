@@ -0,0 +1,317 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "api/InputHistory.h"
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <catch2/catch.hpp>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define BUTTON_COUNT  33 // Two button words
+#define HAT_COUNT     1
+#define AXIS_COUNT    3
+
+#define AXIS_EPSILON  (1.0f / 32767.0f) // Axes are quantized to 16 bits
+
+namespace
+{
+  /*!
+   * \brief A joystick state that is recorded into the history
+   */
+  struct HistoryState
+  {
+    HistoryState(void) :
+      buttons(BUTTON_COUNT, JOYSTICK_STATE_BUTTON_UNPRESSED),
+      hats(HAT_COUNT, JOYSTICK_STATE_HAT_UNPRESSED),
+      axes(AXIS_COUNT, 0.0f)
+    {
+    }
+
+    void Record(CInputHistory& history, int64_t timeNs) const
+    {
+      history.Record(timeNs, buttons, hats, axes);
+    }
+
+    std::vector<JOYSTICK_STATE_BUTTON> buttons;
+    std::vector<JOYSTICK_STATE_HAT>    hats;
+    std::vector<JOYSTICK_STATE_AXIS>   axes;
+  };
+
+  /*!
+   * \brief State with only one button pressed
+   */
+  HistoryState PressButton(unsigned int buttonIndex)
+  {
+    HistoryState state;
+    state.buttons[buttonIndex] = JOYSTICK_STATE_BUTTON_PRESSED;
+    return state;
+  }
+
+  void CheckButtonEvent(const ADDON::PeripheralEvent& event, unsigned int buttonIndex, JOYSTICK_STATE_BUTTON state)
+  {
+    CHECK(event.Type() == PERIPHERAL_EVENT_TYPE_DRIVER_BUTTON);
+    CHECK(event.DriverIndex() == buttonIndex);
+    CHECK(event.ButtonState() == state);
+  }
+}
+
+TEST_CASE("CInputHistory::GetState returns the latest snapshot at or before a time", "[history]")
+{
+  CInputHistory history;
+  history.Initialize(BUTTON_COUNT, HAT_COUNT, AXIS_COUNT, 8);
+
+  HistoryState state;
+  state.buttons[0] = JOYSTICK_STATE_BUTTON_PRESSED;
+  state.Record(history, 100);
+
+  state.hats[0] = JOYSTICK_STATE_HAT_UP;
+  state.Record(history, 200);
+
+  state.axes[2] = -0.5f;
+  state.Record(history, 300);
+
+  REQUIRE(history.Size() == 3);
+
+  SECTION("Times before the first snapshot have no state")
+  {
+    CHECK_FALSE(history.GetState(99).IsValid());
+    CHECK_FALSE(history.GetState(-1).IsValid());
+  }
+
+  SECTION("Times that tie a snapshot return that snapshot")
+  {
+    const CInputHistorySnapshot first = history.GetState(100);
+    REQUIRE(first.IsValid());
+    CHECK(first.TimeNs() == 100);
+    CHECK(first.Button(0) == JOYSTICK_STATE_BUTTON_PRESSED);
+    CHECK(first.Hat(0) == JOYSTICK_STATE_HAT_UNPRESSED);
+
+    const CInputHistorySnapshot second = history.GetState(200);
+    REQUIRE(second.IsValid());
+    CHECK(second.TimeNs() == 200);
+    CHECK(second.Hat(0) == JOYSTICK_STATE_HAT_UP);
+    CHECK(second.Axis(2) == 0.0f);
+  }
+
+  SECTION("Times between snapshots return the earlier snapshot")
+  {
+    CHECK(history.GetState(199).TimeNs() == 100);
+    CHECK(history.GetState(201).TimeNs() == 200);
+
+    const CInputHistorySnapshot last = history.GetState(1000000);
+    REQUIRE(last.IsValid());
+    CHECK(last.TimeNs() == 300);
+    CHECK(last.Button(0) == JOYSTICK_STATE_BUTTON_PRESSED);
+    CHECK(last.Button(32) == JOYSTICK_STATE_BUTTON_UNPRESSED);
+    CHECK(last.Axis(2) == Approx(-0.5f).margin(AXIS_EPSILON));
+  }
+}
+
+TEST_CASE("CInputHistory drops snapshots identical to the last one", "[history]")
+{
+  CInputHistory history;
+  history.Initialize(BUTTON_COUNT, HAT_COUNT, AXIS_COUNT, 8);
+
+  HistoryState state;
+  state.axes[0] = 0.25f;
+  state.Record(history, 100);
+  state.Record(history, 200);
+
+  REQUIRE(history.Size() == 1);
+  CHECK(history.GetSnapshot(0).TimeNs() == 100);
+
+  // Changes smaller than the quantization are dropped too
+  state.axes[0] = 0.25f + AXIS_EPSILON / 4;
+  state.Record(history, 300);
+  CHECK(history.Size() == 1);
+
+  state.buttons[32] = JOYSTICK_STATE_BUTTON_PRESSED;
+  state.Record(history, 400);
+  REQUIRE(history.Size() == 2);
+  CHECK(history.GetSnapshot(1).TimeNs() == 400);
+  CHECK(history.GetSnapshot(1).Button(32) == JOYSTICK_STATE_BUTTON_PRESSED);
+
+  // Earlier times are clamped to keep the ring in time order
+  state.buttons[32] = JOYSTICK_STATE_BUTTON_UNPRESSED;
+  state.Record(history, 350);
+  REQUIRE(history.Size() == 3);
+  CHECK(history.GetSnapshot(2).TimeNs() == 400);
+  CHECK(history.GetState(400).Button(32) == JOYSTICK_STATE_BUTTON_UNPRESSED);
+}
+
+TEST_CASE("CInputHistory overwrites the oldest snapshots when full", "[history]")
+{
+  CInputHistory history;
+
+  // Rounded up to 8
+  history.Initialize(BUTTON_COUNT, HAT_COUNT, AXIS_COUNT, 5);
+
+  const unsigned int recordCount = 20;
+  for (unsigned int i = 0; i < recordCount; i++)
+  {
+    HistoryState state = PressButton(i % BUTTON_COUNT);
+    state.axes[1] = static_cast<float>(i) / recordCount;
+    state.Record(history, 10 * i);
+  }
+
+  REQUIRE(history.Size() == 8);
+  CHECK_FALSE(history.GetSnapshot(8).IsValid());
+
+  for (unsigned int i = 0; i < history.Size(); i++)
+  {
+    const unsigned int recordIndex = recordCount - 8 + i;
+
+    INFO("Snapshot " << i);
+    const CInputHistorySnapshot snapshot = history.GetSnapshot(i);
+    REQUIRE(snapshot.IsValid());
+    CHECK(snapshot.TimeNs() == 10 * recordIndex);
+    CHECK(snapshot.Button(recordIndex) == JOYSTICK_STATE_BUTTON_PRESSED);
+    CHECK(snapshot.Axis(1) == Approx(static_cast<float>(recordIndex) / recordCount).margin(AXIS_EPSILON));
+  }
+
+  // Overwritten snapshots are no longer available
+  CHECK_FALSE(history.GetState(110).IsValid());
+  CHECK(history.GetState(120).TimeNs() == 120);
+  CHECK(history.GetState(195).TimeNs() == 190);
+}
+
+TEST_CASE("CInputHistory::GetChanges reports changes in an interval", "[history]")
+{
+  CInputHistory history;
+  history.Initialize(BUTTON_COUNT, HAT_COUNT, AXIS_COUNT, 8);
+
+  HistoryState state;
+  state.buttons[0] = JOYSTICK_STATE_BUTTON_PRESSED;
+  state.Record(history, 100);
+
+  state.buttons[32] = JOYSTICK_STATE_BUTTON_PRESSED;
+  state.hats[0] = JOYSTICK_STATE_HAT_LEFT_UP;
+  state.Record(history, 200);
+
+  state.buttons[0] = JOYSTICK_STATE_BUTTON_UNPRESSED;
+  state.axes[1] = -0.25f;
+  state.Record(history, 300);
+
+  std::vector<ADDON::PeripheralEvent> events;
+  std::vector<int64_t> eventTimes;
+
+  SECTION("Changes since the initial state")
+  {
+    REQUIRE(history.GetChanges(0, 1000, 3, events, eventTimes));
+
+    REQUIRE(events.size() == 5);
+    REQUIRE(eventTimes == std::vector<int64_t>({ 100, 200, 200, 300, 300 }));
+
+    CheckButtonEvent(events[0], 0, JOYSTICK_STATE_BUTTON_PRESSED);
+    CheckButtonEvent(events[1], 32, JOYSTICK_STATE_BUTTON_PRESSED);
+
+    CHECK(events[2].Type() == PERIPHERAL_EVENT_TYPE_DRIVER_HAT);
+    CHECK(events[2].HatState() == JOYSTICK_STATE_HAT_LEFT_UP);
+
+    CheckButtonEvent(events[3], 0, JOYSTICK_STATE_BUTTON_UNPRESSED);
+
+    CHECK(events[4].Type() == PERIPHERAL_EVENT_TYPE_DRIVER_AXIS);
+    CHECK(events[4].DriverIndex() == 1);
+    CHECK(events[4].AxisState() == Approx(-0.25f).margin(AXIS_EPSILON));
+
+    for (const ADDON::PeripheralEvent& event : events)
+      CHECK(event.PeripheralIndex() == 3);
+  }
+
+  SECTION("The interval excludes fromNs and includes toNs")
+  {
+    REQUIRE(history.GetChanges(100, 200, 3, events, eventTimes));
+
+    REQUIRE(events.size() == 2);
+    CHECK(eventTimes == std::vector<int64_t>({ 200, 200 }));
+    CheckButtonEvent(events[0], 32, JOYSTICK_STATE_BUTTON_PRESSED);
+  }
+
+  SECTION("No changes after the last snapshot")
+  {
+    REQUIRE(history.GetChanges(300, 1000, 3, events, eventTimes));
+    CHECK(events.empty());
+    CHECK(eventTimes.empty());
+  }
+}
+
+TEST_CASE("CInputHistory::GetChanges starts at the oldest snapshot after overwrites", "[history]")
+{
+  CInputHistory history;
+  history.Initialize(BUTTON_COUNT, HAT_COUNT, AXIS_COUNT, 4);
+
+  // Snapshots at 10 to 60, each with only one button pressed. The ring keeps
+  // the snapshots at 30 to 60.
+  for (unsigned int i = 0; i < 6; i++)
+    PressButton(i).Record(history, 10 * (i + 1));
+
+  REQUIRE(history.Size() == 4);
+  REQUIRE(history.GetSnapshot(0).TimeNs() == 30);
+
+  std::vector<ADDON::PeripheralEvent> events;
+  std::vector<int64_t> eventTimes;
+
+  SECTION("Intervals starting before the ring are incomplete")
+  {
+    // The oldest snapshot is the starting state, so the changes into it are lost
+    CHECK_FALSE(history.GetChanges(25, 1000, 0, events, eventTimes));
+
+    REQUIRE(events.size() == 6);
+    CHECK(eventTimes == std::vector<int64_t>({ 40, 40, 50, 50, 60, 60 }));
+    CheckButtonEvent(events[0], 2, JOYSTICK_STATE_BUTTON_UNPRESSED);
+    CheckButtonEvent(events[1], 3, JOYSTICK_STATE_BUTTON_PRESSED);
+    CheckButtonEvent(events[5], 5, JOYSTICK_STATE_BUTTON_PRESSED);
+  }
+
+  SECTION("Intervals starting at the oldest snapshot are complete")
+  {
+    CHECK(history.GetChanges(30, 1000, 0, events, eventTimes));
+
+    REQUIRE(events.size() == 6);
+    CHECK(eventTimes.front() == 40);
+    CheckButtonEvent(events[0], 2, JOYSTICK_STATE_BUTTON_UNPRESSED);
+  }
+
+  SECTION("Intervals that end before the ring have no changes")
+  {
+    CHECK_FALSE(history.GetChanges(0, 20, 0, events, eventTimes));
+    CHECK(events.empty());
+  }
+}
+
+TEST_CASE("CInputHistory is disabled with a capacity of 0", "[history]")
+{
+  CInputHistory history;
+  history.Initialize(BUTTON_COUNT, HAT_COUNT, AXIS_COUNT, 0);
+
+  REQUIRE_FALSE(history.IsEnabled());
+
+  PressButton(0).Record(history, 100);
+  CHECK(history.Size() == 0);
+  CHECK_FALSE(history.GetState(100).IsValid());
+
+  std::vector<ADDON::PeripheralEvent> events;
+  std::vector<int64_t> eventTimes;
+  CHECK_FALSE(history.GetChanges(0, 1000, 0, events, eventTimes));
+  CHECK(events.empty());
+}
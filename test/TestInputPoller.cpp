@@ -0,0 +1,126 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/PipeJoystick.h"
+#include "support/SyntheticInterface.h"
+
+#include "api/JoystickManager.h"
+#include "api/poller/InputPollerEpoll.h"
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <memory>
+#include <vector>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  /*!
+   * \brief Joystick with a second fd that can't be polled
+   */
+  class CBadFdJoystick : public CPipeJoystick
+  {
+  public:
+    CBadFdJoystick(void) : CPipeJoystick("Bad fd pad", 1, 1) { }
+
+    // implementation of CJoystick
+    virtual void GetInputFds(std::vector<int>& fds) const override
+    {
+      CPipeJoystick::GetInputFds(fds);
+      fds.push_back(-1);
+    }
+  };
+
+  unsigned int CountAxisEvents(const std::vector<ADDON::PeripheralEvent>& events)
+  {
+    return static_cast<unsigned int>(std::count_if(events.begin(), events.end(), [](const ADDON::PeripheralEvent& event)
+    {
+      return event.Type() == PERIPHERAL_EVENT_TYPE_DRIVER_AXIS;
+    }));
+  }
+}
+
+TEST_CASE("Epoll rejects a joystick whose fds can't all be added", "[poller]")
+{
+  CInputPollerEpoll poller;
+  REQUIRE(poller.Initialize());
+
+  CBadFdJoystick badJoystick;
+  REQUIRE(badJoystick.Open());
+  CHECK(!poller.AddJoystick(&badJoystick));
+
+  // Joysticks added afterwards are still polled
+  CPipeJoystick joystick("Pipe pad", 1, 1);
+  REQUIRE(joystick.Open());
+  REQUIRE(poller.AddJoystick(&joystick));
+
+  std::vector<CJoystick*> readyJoysticks;
+  REQUIRE(poller.Poll(readyJoysticks));
+  CHECK(readyJoysticks.empty());
+
+  REQUIRE(joystick.WriteButton(0, true) >= 0);
+  REQUIRE(poller.Poll(readyJoysticks));
+  CHECK(readyJoysticks == std::vector<CJoystick*>{ &joystick });
+
+  poller.RemoveJoystick(&joystick);
+  poller.Deinitialize();
+}
+
+TEST_CASE("Held axes are reported while a polled joystick has no input", "[poller]")
+{
+  std::shared_ptr<CPipeJoystick> joystick = std::make_shared<CPipeJoystick>("Pipe pad", 1, 1);
+  REQUIRE(joystick->Open());
+
+  CNullScanner scanner;
+  REQUIRE(CJoystickManager::Get().Initialize(&scanner, { new CSyntheticInterface(JoystickVector{ joystick }) }));
+
+  JoystickVector scanned;
+  REQUIRE(CJoystickManager::Get().PerformJoystickScan(scanned));
+  REQUIRE(scanned.size() == 1);
+
+  std::vector<ADDON::PeripheralEvent> events;
+
+  REQUIRE(joystick->WriteAxis(0, 16000) >= 0);
+  REQUIRE(CJoystickManager::Get().GetEvents(events));
+  CHECK(CountAxisEvents(events) == 1);
+
+  // Nothing to read, but the axis is still off-center
+  for (unsigned int i = 0; i < 3; i++)
+  {
+    events.clear();
+    REQUIRE(CJoystickManager::Get().GetEvents(events));
+    CHECK(CountAxisEvents(events) == 1);
+  }
+
+  REQUIRE(joystick->WriteAxis(0, 0) >= 0);
+  events.clear();
+  REQUIRE(CJoystickManager::Get().GetEvents(events));
+  CHECK(CountAxisEvents(events) == 1);
+
+  // Centered and reported as such, so no more events
+  events.clear();
+  REQUIRE(CJoystickManager::Get().GetEvents(events));
+  CHECK(CountAxisEvents(events) == 0);
+
+  CJoystickManager::Get().Deinitialize();
+}
@@ -0,0 +1,413 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/SyntheticJoystick.h"
+
+#include "api/JoystickStateArena.h"
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <catch2/catch.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define RANDOM_SEED    1234 // Fixed so failures reproduce
+#define RANDOM_FRAMES  200  // Frames of random state per pass
+
+namespace
+{
+  typedef std::shared_ptr<CSyntheticJoystick> SyntheticPtr;
+
+  /*!
+   * \brief Inputs given to a synthetic joystick
+   *
+   * Axes aren't kept, because the joystick's axis filters may change them
+   * before they are published.
+   */
+  struct PadInputs
+  {
+    std::vector<bool>               buttons;
+    std::vector<JOYSTICK_STATE_HAT> hats;
+  };
+
+  /*!
+   * \brief A joystick's lanes, copied out of the arena
+   */
+  struct ArenaState
+  {
+    std::vector<uint32_t> currentButtons;
+    std::vector<uint32_t> previousButtons;
+    std::vector<float>    currentAxes;
+    std::vector<float>    previousAxes;
+  };
+
+  /*!
+   * \brief Joysticks whose lane counts aren't multiples of the vector or
+   *        word size
+   */
+  std::vector<SyntheticPtr> CreatePads(void)
+  {
+    std::vector<SyntheticPtr> pads;
+    pads.push_back(std::make_shared<CSyntheticJoystick>("Five inputs", 5, 1, 5));
+    pads.push_back(std::make_shared<CSyntheticJoystick>("Thirty-three inputs", 33, 2, 33));
+    pads.push_back(std::make_shared<CSyntheticJoystick>("One input", 1, 0, 1));
+    pads.push_back(std::make_shared<CSyntheticJoystick>("Five words", 129, 1, 8));
+
+    for (const SyntheticPtr& pad : pads)
+      REQUIRE(pad->Initialize());
+
+    return pads;
+  }
+
+  JoystickVector ToJoysticks(const std::vector<SyntheticPtr>& pads)
+  {
+    return JoystickVector(pads.begin(), pads.end());
+  }
+
+  /*!
+   * \brief Set random values, with most inputs released or centered
+   */
+  PadInputs Randomize(CSyntheticJoystick& pad, std::mt19937& random)
+  {
+    std::uniform_int_distribution<unsigned int> choice(0, 3);
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+
+    const JOYSTICK_STATE_HAT hats[] = {
+      JOYSTICK_STATE_HAT_UNPRESSED,
+      JOYSTICK_STATE_HAT_UP,
+      JOYSTICK_STATE_HAT_RIGHT_DOWN,
+      JOYSTICK_STATE_HAT_LEFT,
+    };
+
+    PadInputs inputs;
+
+    for (unsigned int i = 0; i < pad.ButtonCount(); i++)
+    {
+      inputs.buttons.push_back(choice(random) == 0);
+      pad.SetButton(i, inputs.buttons.back());
+    }
+
+    for (unsigned int i = 0; i < pad.HatCount(); i++)
+    {
+      inputs.hats.push_back(hats[choice(random)]);
+      pad.SetHat(i, inputs.hats.back());
+    }
+
+    for (unsigned int i = 0; i < pad.AxisCount(); i++)
+      pad.SetAxis(i, choice(random) == 0 ? position(random) : 0.0f);
+
+    return inputs;
+  }
+
+  ArenaState CopyState(CJoystickStateArena& arena, const JoystickStateSlot& slot)
+  {
+    ArenaState state;
+
+    const uint32_t* currentButtons = arena.CurrentButtons(slot);
+    const uint32_t* previousButtons = arena.PreviousButtons(slot);
+    state.currentButtons.assign(currentButtons, currentButtons + slot.buttonWordCount);
+    state.previousButtons.assign(previousButtons, previousButtons + slot.buttonWordCount);
+
+    const float* currentAxes = arena.CurrentAxes(slot);
+    const float* previousAxes = arena.PreviousAxes(slot);
+    state.currentAxes.assign(currentAxes, currentAxes + slot.axisCount);
+    state.previousAxes.assign(previousAxes, previousAxes + slot.axisCount);
+
+    return state;
+  }
+
+  unsigned int CountBits(uint32_t bits)
+  {
+    unsigned int count = 0;
+    for (; bits != 0; bits &= bits - 1)
+      count++;
+    return count;
+  }
+
+  /*!
+   * \brief Check that a joystick's published buttons are the values it was
+   *        given, and that the unused bits of its last word are clear
+   */
+  void CheckPublished(CJoystickStateArena& arena, const CSyntheticJoystick& pad, const PadInputs& inputs)
+  {
+    const JoystickStateSlot& slot = pad.StateSlot();
+    const uint32_t* words = arena.CurrentButtons(slot);
+
+    for (unsigned int word = 0; word < slot.buttonWordCount; word++)
+    {
+      uint32_t expected = 0;
+      for (unsigned int bit = 0; bit < 32 && word * 32 + bit < inputs.buttons.size(); bit++)
+      {
+        if (inputs.buttons[word * 32 + bit])
+          expected |= 1u << bit;
+      }
+
+      INFO(pad.Name() << ", button word " << word);
+      CHECK(words[word] == expected);
+    }
+  }
+
+  /*!
+   * \brief Check the diff of a joystick's lanes against a scalar reference,
+   *        including the padding up to the next whole vector
+   *
+   * \return The number of changed buttons and active axes
+   */
+  unsigned int CheckDiff(CJoystickStateArena& arena, const CSyntheticJoystick& pad)
+  {
+    const unsigned int LANES = CJoystickStateArena::LANES;
+    const JoystickStateSlot& slot = pad.StateSlot();
+
+    unsigned int activeCount = 0;
+
+    const uint32_t* currentButtons = arena.CurrentButtons(slot);
+    const uint32_t* previousButtons = arena.PreviousButtons(slot);
+    const uint32_t* buttonChanges = arena.ButtonChanges(slot);
+
+    const unsigned int paddedWords = (slot.buttonWordCount + LANES - 1) / LANES * LANES;
+    for (unsigned int word = 0; word < paddedWords; word++)
+    {
+      const uint32_t expected = word < slot.buttonWordCount ? currentButtons[word] ^ previousButtons[word] : 0;
+
+      INFO(pad.Name() << ", button word " << word);
+      CHECK(buttonChanges[word] == expected);
+
+      activeCount += CountBits(expected);
+    }
+
+    const float* currentAxes = arena.CurrentAxes(slot);
+    const float* previousAxes = arena.PreviousAxes(slot);
+    const uint8_t* axisMasks = arena.AxisMasks(slot);
+
+    for (unsigned int block = 0; block * LANES < slot.axisCount; block++)
+    {
+      unsigned int expected = 0;
+      for (unsigned int lane = 0; lane < LANES; lane++)
+      {
+        const unsigned int i = block * LANES + lane;
+        if (i < slot.axisCount && (currentAxes[i] != 0.0f || previousAxes[i] != 0.0f))
+          expected |= 1 << lane;
+      }
+
+      INFO(pad.Name() << ", axis block " << block);
+      CHECK(static_cast<unsigned int>(axisMasks[block]) == expected);
+
+      activeCount += CountBits(expected);
+    }
+
+    return activeCount;
+  }
+
+  /*!
+   * \brief Randomize, scan and diff every joystick, and check the diff and
+   *        the events it produces
+   */
+  void RunRandomFrames(CJoystickStateArena& arena, const std::vector<SyntheticPtr>& pads, std::vector<PadInputs>& lastInputs, std::mt19937& random)
+  {
+    std::vector<ADDON::PeripheralEvent> events;
+    std::vector<int64_t> eventTimes;
+
+    for (unsigned int frame = 0; frame < RANDOM_FRAMES; frame++)
+    {
+      std::vector<PadInputs> inputs;
+      for (const SyntheticPtr& pad : pads)
+      {
+        inputs.push_back(Randomize(*pad, random));
+        REQUIRE(pad->ScanState());
+      }
+
+      arena.Diff();
+
+      for (unsigned int i = 0; i < pads.size(); i++)
+      {
+        CSyntheticJoystick& pad = *pads[i];
+
+        CheckPublished(arena, pad, inputs[i]);
+        unsigned int expectedEvents = CheckDiff(arena, pad);
+
+        for (unsigned int hat = 0; hat < pad.HatCount(); hat++)
+        {
+          if (inputs[i].hats[hat] != lastInputs[i].hats[hat])
+            expectedEvents++;
+        }
+
+        events.clear();
+        eventTimes.clear();
+        pad.GetEvents(events, eventTimes);
+
+        INFO(pad.Name() << ", frame " << frame);
+        CHECK(events.size() == expectedEvents);
+      }
+
+      arena.Commit();
+
+      lastInputs.swap(inputs);
+    }
+  }
+
+  std::vector<PadInputs> ReleasedInputs(const std::vector<SyntheticPtr>& pads)
+  {
+    std::vector<PadInputs> inputs;
+    for (const SyntheticPtr& pad : pads)
+    {
+      PadInputs released;
+      released.buttons.assign(pad->ButtonCount(), false);
+      released.hats.assign(pad->HatCount(), JOYSTICK_STATE_HAT_UNPRESSED);
+      inputs.push_back(released);
+    }
+    return inputs;
+  }
+}
+
+TEST_CASE("CJoystickStateArena::Diff matches a scalar reference", "[arena]")
+{
+  std::vector<SyntheticPtr> pads = CreatePads();
+
+  CJoystickStateArena arena;
+  arena.Rebuild(ToJoysticks(pads));
+
+  for (const SyntheticPtr& pad : pads)
+  {
+    const JoystickStateSlot& slot = pad->StateSlot();
+    CHECK(slot.buttonWordCount == (pad->ButtonCount() + 31) / 32);
+    CHECK(slot.axisCount == pad->AxisCount());
+
+    // Slots start on whole vectors
+    CHECK(slot.buttonWord % CJoystickStateArena::LANES == 0);
+    CHECK(slot.axis % CJoystickStateArena::LANES == 0);
+  }
+
+  std::mt19937 random(RANDOM_SEED);
+  std::vector<PadInputs> lastInputs = ReleasedInputs(pads);
+
+  RunRandomFrames(arena, pads, lastInputs, random);
+}
+
+TEST_CASE("CJoystickStateArena::Commit makes the current state the previous state", "[arena]")
+{
+  std::vector<SyntheticPtr> pads = CreatePads();
+
+  CJoystickStateArena arena;
+  arena.Rebuild(ToJoysticks(pads));
+
+  std::mt19937 random(RANDOM_SEED);
+  for (const SyntheticPtr& pad : pads)
+  {
+    Randomize(*pad, random);
+    REQUIRE(pad->ScanState());
+  }
+
+  arena.Diff();
+  arena.Commit();
+
+  for (const SyntheticPtr& pad : pads)
+  {
+    const ArenaState state = CopyState(arena, pad->StateSlot());
+    CHECK(state.previousButtons == state.currentButtons);
+    CHECK(state.previousAxes == state.currentAxes);
+  }
+
+  // Nothing changes if the joysticks are scanned again with the same values
+  for (const SyntheticPtr& pad : pads)
+    REQUIRE(pad->ScanState());
+
+  arena.Diff();
+
+  for (const SyntheticPtr& pad : pads)
+  {
+    const JoystickStateSlot& slot = pad->StateSlot();
+    const uint32_t* changes = arena.ButtonChanges(slot);
+    for (unsigned int word = 0; word < slot.buttonWordCount; word++)
+      CHECK(changes[word] == 0);
+  }
+}
+
+TEST_CASE("CJoystickStateArena::Rebuild preserves the state of existing joysticks", "[arena]")
+{
+  std::vector<SyntheticPtr> pads = CreatePads();
+
+  CJoystickStateArena arena;
+  arena.Rebuild(ToJoysticks(pads));
+
+  std::mt19937 random(RANDOM_SEED);
+  std::vector<PadInputs> lastInputs = ReleasedInputs(pads);
+
+  RunRandomFrames(arena, pads, lastInputs, random);
+
+  // Scan a new state without diffing it, so the current and previous states
+  // differ when the arena is rebuilt
+  std::vector<PadInputs> inputs;
+  for (const SyntheticPtr& pad : pads)
+  {
+    inputs.push_back(Randomize(*pad, random));
+    REQUIRE(pad->ScanState());
+  }
+
+  std::vector<ArenaState> states;
+  for (const SyntheticPtr& pad : pads)
+    states.push_back(CopyState(arena, pad->StateSlot()));
+
+  // Add a joystick in front and reverse the rest, so that every slot moves
+  SyntheticPtr added = std::make_shared<CSyntheticJoystick>("Added", 7, 1, 3);
+  REQUIRE(added->Initialize());
+
+  std::vector<SyntheticPtr> rebuiltPads(pads.rbegin(), pads.rend());
+  rebuiltPads.insert(rebuiltPads.begin(), added);
+
+  arena.Rebuild(ToJoysticks(rebuiltPads));
+
+  for (unsigned int i = 0; i < pads.size(); i++)
+  {
+    const ArenaState state = CopyState(arena, pads[i]->StateSlot());
+
+    INFO(pads[i]->Name());
+    CHECK(state.currentButtons == states[i].currentButtons);
+    CHECK(state.previousButtons == states[i].previousButtons);
+    CHECK(state.currentAxes == states[i].currentAxes);
+    CHECK(state.previousAxes == states[i].previousAxes);
+  }
+
+  // The new joystick starts at the initial state
+  const ArenaState addedState = CopyState(arena, added->StateSlot());
+  CHECK(addedState.currentButtons == std::vector<uint32_t>(1, 0));
+  CHECK(addedState.previousAxes == std::vector<float>(3, 0.0f));
+
+  // The diff of the moved slots is the diff from before the rebuild
+  std::vector<ADDON::PeripheralEvent> events;
+  std::vector<int64_t> eventTimes;
+
+  arena.Diff();
+  for (const SyntheticPtr& pad : rebuiltPads)
+  {
+    CheckDiff(arena, *pad);
+    pad->GetEvents(events, eventTimes);
+  }
+
+  arena.Commit();
+
+  // And the moved joysticks keep diffing correctly
+  std::vector<PadInputs> rebuiltInputs(inputs.rbegin(), inputs.rend());
+  rebuiltInputs.insert(rebuiltInputs.begin(), ReleasedInputs({ added }).front());
+
+  RunRandomFrames(arena, rebuiltPads, rebuiltInputs, random);
+}
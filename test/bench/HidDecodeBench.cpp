@@ -0,0 +1,104 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/Benchmark.h"
+#include "support/HidTestData.h"
+
+#include "api/hidraw/HidDecodePlan.h"
+#include "api/hidraw/HidReportDecoder.h"
+#include "api/hidraw/JoystickHidraw.h"
+#include "log/Log.h"
+
+#include <linux/input.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define DECODE_ITERATIONS  1000000 // Reports decoded per case
+#define DECODE_BATCH_SIZE  1000    // Reports per sample
+
+namespace
+{
+  /*!
+   * \brief Time decoding recorded reports into a joystick's state
+   *
+   * Reports are decoded from memory, without the read() that precedes
+   * decoding on a real device.
+   *
+   * \param decoder The compile-time decoder, or nullptr to time the plan
+   */
+  void BenchDecode(CBenchmarkReport& report, const std::string& name, const std::string& descriptorFile,
+                   const std::string& reportsFile, const IHidReportDecoder* decoder)
+  {
+    CHidDecodePlan parsedPlan;
+    if (!descriptorFile.empty())
+    {
+      const std::vector<uint8_t> descriptor = CHidTestData::ReadDescriptor(descriptorFile);
+      if (!parsedPlan.Parse(descriptor.data(), descriptor.size()))
+      {
+        fprintf(stderr, "Failed to parse %s\n", descriptorFile.c_str());
+        return;
+      }
+    }
+
+    const std::vector<std::vector<uint8_t>> reports = CHidTestData::ReadReports(reportsFile);
+    if (reports.empty())
+    {
+      fprintf(stderr, "Failed to read %s\n", reportsFile.c_str());
+      return;
+    }
+
+    // Without an fd, the joystick is only decoded into
+    HidDecodePlanPtr plan = std::make_shared<CHidDecodePlan>(parsedPlan);
+    std::shared_ptr<CJoystickHidraw> joystick = std::make_shared<CJoystickHidraw>(-1, name, 0, plan, decoder);
+    if (!joystick->Initialize())
+      return;
+
+    report.Measure(name, { { "report_bytes", static_cast<double>(reports[0].size()) } },
+      DECODE_ITERATIONS, DECODE_BATCH_SIZE, [&](unsigned int i)
+      {
+        const std::vector<uint8_t>& hidReport = reports[i % reports.size()];
+        joystick->Decode(hidReport.data(), hidReport.size());
+      });
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  CLog::Get().SetLevel(SYS_LOG_ERROR);
+
+  CBenchmarkReport report("hid_decode_bench", argc, argv);
+
+  // The same DualShock 4 reports through both decoders
+  const IHidReportDecoder* dualShock4 = CHidReportDecoders::GetDecoder(BUS_USB, 0x054C, 0x05C4);
+  BenchDecode(report, "decode_specialized_ds4", "ds4.rdesc", "ds4.reports", dualShock4);
+  BenchDecode(report, "decode_generic_ds4", "ds4.rdesc", "ds4.reports", nullptr);
+
+  BenchDecode(report, "decode_generic_dragonrise", "dragonrise.rdesc", "dragonrise.reports", nullptr);
+
+  const IHidReportDecoder* switchPro = CHidReportDecoders::GetDecoder(BUS_BLUETOOTH, 0x057E, 0x2009);
+  BenchDecode(report, "decode_specialized_switchpro", "", "switchpro.reports", switchPro);
+
+  return report.Write() ? 0 : 1;
+}
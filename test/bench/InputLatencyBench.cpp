@@ -0,0 +1,221 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/Benchmark.h"
+#include "support/PipeJoystick.h"
+#include "support/SyntheticInterface.h"
+
+#include "api/JoystickManager.h"
+#include "log/Log.h"
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define LATENCY_FRAMES       2000 // Input frames written per case
+#define BUTTON_COUNT         64   // Buttons per joystick, cycled so that a poll never sees a button change twice
+#define WRITE_INTERVAL_MIN   1000 // Microseconds between writes, varied so writes drift against the polls
+#define WRITE_INTERVAL_SPAN  2000
+#define DRAIN_TIMEOUT_MS     1000 // Time to wait for the last events before giving up
+
+namespace
+{
+  struct LatencyHarness
+  {
+    std::vector<std::shared_ptr<CPipeJoystick>> pads;
+    CNullScanner scanner;
+  };
+
+  bool Open(LatencyHarness& harness, unsigned int joystickCount)
+  {
+    JoystickVector joysticks;
+    for (unsigned int i = 0; i < joystickCount; i++)
+    {
+      std::shared_ptr<CPipeJoystick> pad = std::make_shared<CPipeJoystick>("Pipe pad " + std::to_string(i), BUTTON_COUNT, 2);
+      if (!pad->Open())
+        return false;
+
+      harness.pads.push_back(pad);
+      joysticks.push_back(pad);
+    }
+
+    if (!CJoystickManager::Get().Initialize(&harness.scanner, { new CSyntheticInterface(joysticks) }))
+      return false;
+
+    JoystickVector scanned;
+    return CJoystickManager::Get().PerformJoystickScan(scanned) && scanned.size() == joystickCount;
+  }
+
+  /*!
+   * \brief Write the input frame with the given sequence number
+   *
+   * Frames go to each joystick in turn and press, then release, each of its
+   * buttons in turn.
+   */
+  void WriteFrame(LatencyHarness& harness, unsigned int frame)
+  {
+    const unsigned int joystickCount = harness.pads.size();
+    const unsigned int buttonFrame = frame / joystickCount;
+
+    CPipeJoystick& pad = *harness.pads[frame % joystickCount];
+    pad.WriteButton(buttonFrame % BUTTON_COUNT, (buttonFrame / BUTTON_COUNT) % 2 == 0);
+  }
+
+  unsigned int ExpectedButton(LatencyHarness& harness, unsigned int frame)
+  {
+    return (frame / harness.pads.size()) % BUTTON_COUNT;
+  }
+
+  /*!
+   * \brief Write a frame and read it back on the same thread
+   *
+   * This is the add-on's own cost: polling, reading, diffing, and merging.
+   */
+  void BenchInline(CBenchmarkReport& report, unsigned int joystickCount)
+  {
+    LatencyHarness harness;
+    if (!Open(harness, joystickCount))
+      return;
+
+    std::vector<ADDON::PeripheralEvent> events;
+    std::vector<double> samplesNs;
+
+    const unsigned int frames = report.Iterations(LATENCY_FRAMES);
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+      const int64_t writeTimeNs = CPipeJoystick::NowNs();
+      WriteFrame(harness, frame);
+
+      events.clear();
+      CJoystickManager::Get().GetEvents(events);
+
+      if (!events.empty())
+        samplesNs.push_back(CPipeJoystick::NowNs() - writeTimeNs);
+    }
+
+    CJoystickManager::Get().Deinitialize();
+
+    report.AddSamples("latency_inline", { { "joysticks", joystickCount } }, std::move(samplesNs));
+  }
+
+  /*!
+   * \brief Write frames on one thread while another thread polls, like the
+   *        frontend's input thread
+   *
+   * \param pollRateHz The polling rate, or 0 to poll continuously
+   */
+  void BenchThreaded(CBenchmarkReport& report, unsigned int joystickCount, unsigned int pollRateHz)
+  {
+    LatencyHarness harness;
+    if (!Open(harness, joystickCount))
+      return;
+
+    const unsigned int frames = report.Iterations(LATENCY_FRAMES);
+
+    std::unique_ptr<std::atomic<int64_t>[]> writeTimesNs(new std::atomic<int64_t>[frames]);
+
+    std::thread writer([&]()
+    {
+      for (unsigned int frame = 0; frame < frames; frame++)
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(WRITE_INTERVAL_MIN + (frame * 7919) % WRITE_INTERVAL_SPAN));
+
+        writeTimesNs[frame].store(CPipeJoystick::NowNs(), std::memory_order_release);
+        WriteFrame(harness, frame);
+      }
+    });
+
+    std::vector<ADDON::PeripheralEvent> events;
+    std::vector<double> samplesNs;
+    samplesNs.reserve(frames);
+
+    unsigned int received = 0;
+    bool bInOrder = true;
+
+    const auto period = pollRateHz > 0 ? std::chrono::nanoseconds(1000000000 / pollRateHz) : std::chrono::nanoseconds(0);
+    auto nextPoll = std::chrono::steady_clock::now();
+    auto deadline = std::chrono::steady_clock::time_point::max();
+
+    while (received < frames && bInOrder && std::chrono::steady_clock::now() < deadline)
+    {
+      if (pollRateHz > 0)
+      {
+        nextPoll += period;
+        std::this_thread::sleep_until(nextPoll);
+      }
+
+      events.clear();
+      CJoystickManager::Get().GetEvents(events);
+      const int64_t readTimeNs = CPipeJoystick::NowNs();
+
+      // Events are merged in the order they were written
+      for (const ADDON::PeripheralEvent& event : events)
+      {
+        if (event.Type() != PERIPHERAL_EVENT_TYPE_DRIVER_BUTTON)
+          continue;
+
+        if (received >= frames || event.DriverIndex() != ExpectedButton(harness, received))
+        {
+          bInOrder = false;
+          break;
+        }
+
+        samplesNs.push_back(readTimeNs - writeTimesNs[received].load(std::memory_order_acquire));
+        received++;
+      }
+
+      if (received + 1 >= frames && deadline == std::chrono::steady_clock::time_point::max())
+        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(DRAIN_TIMEOUT_MS);
+    }
+
+    writer.join();
+
+    CJoystickManager::Get().Deinitialize();
+
+    if (received < frames)
+      fprintf(stderr, "%u of %u frames were lost or out of order at %u Hz\n", frames - received, frames, pollRateHz);
+
+    report.AddSamples("latency_threaded", { { "joysticks", joystickCount }, { "poll_rate_hz", pollRateHz } }, std::move(samplesNs));
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  CLog::Get().SetLevel(SYS_LOG_ERROR);
+
+  CBenchmarkReport report("input_latency_bench", argc, argv);
+
+  for (unsigned int joystickCount : { 1, 8 })
+  {
+    BenchInline(report, joystickCount);
+
+    for (unsigned int pollRateHz : { 0, 60, 125, 250, 1000 })
+      BenchThreaded(report, joystickCount, pollRateHz);
+  }
+
+  return report.Write() ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/Benchmark.h"
+#include "support/PipeJoystick.h"
+
+#include "api/IInputPoller.h"
+#include "api/JoystickStateArena.h"
+#include "log/Log.h"
+
+#if defined(HAVE_EPOLL)
+  #include "api/poller/InputPollerEpoll.h"
+#endif
+#if defined(HAVE_IO_URING)
+  #include "api/poller/InputPollerIoUring.h"
+#endif
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define FRAME_ITERATIONS  20000 // Frames timed per case
+#define FRAME_BATCH_SIZE  100   // Frames per sample
+
+namespace
+{
+  /*!
+   * \brief Time a frame in which some of the joysticks have input
+   *
+   * Each frame writes an axis event to the active joysticks, then scans
+   * either every joystick or the ones the poller reports as ready. The
+   * writes cost the same in every mode.
+   *
+   * \param poller The poller, or nullptr to scan every joystick
+   */
+  void BenchPoll(CBenchmarkReport& report, IInputPoller* poller, unsigned int joystickCount, unsigned int activeCount)
+  {
+    if (poller != nullptr && !poller->Initialize())
+      return;
+
+    std::vector<std::shared_ptr<CPipeJoystick>> pads;
+    JoystickVector joysticks;
+    for (unsigned int i = 0; i < joystickCount; i++)
+    {
+      std::shared_ptr<CPipeJoystick> pad = std::make_shared<CPipeJoystick>("Pipe pad " + std::to_string(i), 16, 4);
+      if (!pad->Open() || !pad->Initialize())
+        return;
+
+      if (poller != nullptr && !poller->AddJoystick(pad.get()))
+        return;
+
+      pads.push_back(pad);
+      joysticks.push_back(pad);
+    }
+
+    CJoystickStateArena arena;
+    arena.Rebuild(joysticks);
+
+    std::vector<CJoystick*> readyJoysticks;
+
+    report.Measure(poller != nullptr ? std::string("poll_") + poller->Name() : std::string("poll_read_all"),
+      { { "joysticks", joystickCount }, { "active", activeCount } },
+      FRAME_ITERATIONS, FRAME_BATCH_SIZE, [&](unsigned int frame)
+      {
+        for (unsigned int i = 0; i < activeCount; i++)
+          pads[i]->WriteAxis(frame % 4, (frame % 2 == 0) ? 16000 : -16000);
+
+        if (poller != nullptr && poller->Poll(readyJoysticks))
+        {
+          for (CJoystick* joystick : readyJoysticks)
+            joystick->ScanState();
+        }
+        else
+        {
+          for (const std::shared_ptr<CPipeJoystick>& pad : pads)
+            pad->ScanState();
+        }
+      });
+
+    if (poller != nullptr)
+    {
+      for (const std::shared_ptr<CPipeJoystick>& pad : pads)
+        poller->RemoveJoystick(pad.get());
+      poller->Deinitialize();
+    }
+
+    arena.Clear(joysticks);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  CLog::Get().SetLevel(SYS_LOG_ERROR);
+
+  CBenchmarkReport report("input_poller_bench", argc, argv);
+
+  for (unsigned int joystickCount : { 1, 4, 16, 64 })
+  {
+    for (unsigned int activeCount : { 0, 1, 4 })
+    {
+      if (activeCount > joystickCount)
+        continue;
+
+      BenchPoll(report, nullptr, joystickCount, activeCount);
+
+#if defined(HAVE_EPOLL)
+      CInputPollerEpoll epoll;
+      BenchPoll(report, &epoll, joystickCount, activeCount);
+#endif
+#if defined(HAVE_IO_URING)
+      CInputPollerIoUring ioUring;
+      BenchPoll(report, &ioUring, joystickCount, activeCount);
+#endif
+    }
+  }
+
+  return report.Write() ? 0 : 1;
+}
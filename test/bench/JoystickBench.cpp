@@ -0,0 +1,218 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/Benchmark.h"
+#include "support/PipeJoystick.h"
+#include "support/SyntheticInterface.h"
+#include "support/SyntheticJoystick.h"
+
+#include "api/AnomalousTrigger.h"
+#include "api/JoystickManager.h"
+#include "api/JoystickStateArena.h"
+#include "log/Log.h"
+
+#include "kodi_peripheral_utils.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define FRAME_ITERATIONS   100000 // Frames timed per case
+#define FRAME_BATCH_SIZE   100    // Frames per sample
+#define FILTER_ITERATIONS  1000000
+#define FILTER_BATCH_SIZE  1000
+
+namespace
+{
+  /*!
+   * \brief Change the given number of inputs, cycling through buttons, hats
+   *        and axes so that every frame produces events
+   */
+  void SimulateFrame(CSyntheticJoystick& joystick, unsigned int frame, unsigned int changes)
+  {
+    for (unsigned int i = 0; i < changes; i++)
+    {
+      const unsigned int input = frame * changes + i;
+      const bool bOn = (input / changes) % 2 == 0;
+
+      switch (i % 3)
+      {
+      case 0:
+        joystick.SetButton(input % joystick.ButtonCount(), bOn);
+        break;
+      case 1:
+        joystick.SetHat(input % joystick.HatCount(), bOn ? JOYSTICK_STATE_HAT_LEFT : JOYSTICK_STATE_HAT_UNPRESSED);
+        break;
+      default:
+        joystick.SetAxis(input % joystick.AxisCount(), bOn ? 0.75f : -0.25f);
+        break;
+      }
+    }
+  }
+
+  void BenchJoystickGetEvents(CBenchmarkReport& report, unsigned int inputCount, unsigned int changes)
+  {
+    std::shared_ptr<CSyntheticJoystick> joystick = std::make_shared<CSyntheticJoystick>("Synthetic pad", inputCount, inputCount / 4, inputCount / 2);
+    joystick->Initialize();
+
+    CJoystickStateArena arena;
+    arena.Rebuild(JoystickVector{ joystick });
+
+    std::vector<ADDON::PeripheralEvent> events;
+    std::vector<int64_t> eventTimes;
+
+    report.Measure("joystick_get_events", { { "buttons", inputCount }, { "changes_per_frame", changes } },
+      FRAME_ITERATIONS, FRAME_BATCH_SIZE, [&](unsigned int frame)
+      {
+        SimulateFrame(*joystick, frame, changes);
+
+        events.clear();
+        eventTimes.clear();
+
+        joystick->ScanState();
+        arena.Diff();
+        joystick->GetEvents(events, eventTimes);
+        arena.Commit();
+      });
+
+    arena.Clear(JoystickVector{ joystick });
+  }
+
+  void BenchAnomalousTrigger(CBenchmarkReport& report)
+  {
+    ADDON::Joystick joystickInfo(INTERFACE_SYNTHETIC, "Synthetic pad");
+    CAnomalousTrigger trigger(0, &joystickInfo);
+
+    // Rest at -1.0 like an anomalous trigger so the filter rescales values
+    for (float value : { -1.0f, -0.5f, 0.0f, 0.5f, 1.0f })
+      trigger.Filter(value);
+
+    float sum = 0.0f;
+
+    report.Measure("anomalous_trigger_filter", { },
+      FILTER_ITERATIONS, FILTER_BATCH_SIZE, [&](unsigned int i)
+      {
+        sum += trigger.Filter((i % 200) / 100.0f - 1.0f);
+      });
+
+    // Keep the filter from being optimized away
+    if (sum == 1.0f)
+      fprintf(stderr, "\n");
+  }
+
+  void BenchPipeScan(CBenchmarkReport& report, unsigned int eventsPerFrame)
+  {
+    std::shared_ptr<CPipeJoystick> joystick = std::make_shared<CPipeJoystick>("Pipe pad", 16, 8);
+    if (!joystick->Open() || !joystick->Initialize())
+      return;
+
+    CJoystickStateArena arena;
+    arena.Rebuild(JoystickVector{ joystick });
+
+    std::vector<input_event> frameEvents(eventsPerFrame + 1);
+    std::vector<ADDON::PeripheralEvent> events;
+    std::vector<int64_t> eventTimes;
+
+    report.Measure("pipe_write_scan", { { "events_per_frame", eventsPerFrame } },
+      FRAME_ITERATIONS, FRAME_BATCH_SIZE, [&](unsigned int frame)
+      {
+        // Axes are normalized on the way in, like evdev ABS events
+        for (unsigned int i = 0; i < eventsPerFrame; i++)
+        {
+          frameEvents[i].type  = EV_ABS;
+          frameEvents[i].code  = ABS_X + i % 8;
+          frameEvents[i].value = (frame % 2 == 0) ? 16000 : -16000;
+        }
+        frameEvents[eventsPerFrame].type = EV_SYN;
+        frameEvents[eventsPerFrame].code = SYN_REPORT;
+
+        joystick->WriteEvents(frameEvents.data(), frameEvents.size());
+
+        events.clear();
+        eventTimes.clear();
+
+        joystick->ScanState();
+        arena.Diff();
+        joystick->GetEvents(events, eventTimes);
+        arena.Commit();
+      });
+
+    arena.Clear(JoystickVector{ joystick });
+  }
+
+  void BenchManagerGetEvents(CBenchmarkReport& report, unsigned int joystickCount)
+  {
+    std::vector<std::shared_ptr<CSyntheticJoystick>> pads;
+    JoystickVector joysticks;
+    for (unsigned int i = 0; i < joystickCount; i++)
+    {
+      pads.push_back(std::make_shared<CSyntheticJoystick>("Synthetic pad " + std::to_string(i), 16, 1, 6));
+      joysticks.push_back(pads.back());
+    }
+
+    CNullScanner scanner;
+    if (!CJoystickManager::Get().Initialize(&scanner, { new CSyntheticInterface(joysticks) }))
+      return;
+
+    JoystickVector scanned;
+    CJoystickManager::Get().PerformJoystickScan(scanned);
+
+    std::vector<ADDON::PeripheralEvent> events;
+
+    report.Measure("manager_get_events", { { "joysticks", joystickCount } },
+      FRAME_ITERATIONS / joystickCount, std::max(FRAME_BATCH_SIZE / joystickCount, 1u), [&](unsigned int frame)
+      {
+        for (unsigned int i = 0; i < pads.size(); i++)
+          SimulateFrame(*pads[i], frame + i, 2);
+
+        events.clear();
+        CJoystickManager::Get().GetEvents(events);
+      });
+
+    CJoystickManager::Get().Deinitialize();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  CLog::Get().SetLevel(SYS_LOG_ERROR);
+
+  CBenchmarkReport report("joystick_bench", argc, argv);
+
+  for (unsigned int inputCount : { 16, 64 })
+  {
+    for (unsigned int changes : { 1, 4, 16 })
+      BenchJoystickGetEvents(report, inputCount, changes);
+  }
+
+  BenchAnomalousTrigger(report);
+
+  for (unsigned int eventsPerFrame : { 1, 4, 16 })
+    BenchPipeScan(report, eventsPerFrame);
+
+  for (unsigned int joystickCount : { 1, 2, 4, 8, 16, 32, 64 })
+    BenchManagerGetEvents(report, joystickCount);
+
+  return report.Write() ? 0 : 1;
+}
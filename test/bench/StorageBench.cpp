@@ -0,0 +1,309 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "support/Benchmark.h"
+
+#include "buttonmapper/ButtonMapper.h"
+#include "buttonmapper/ControllerTransformer.h"
+#include "buttonmapper/JoystickFamily.h"
+#include "filesystem/DirectoryUtils.h"
+#include "filesystem/FileUtils.h"
+#include "filesystem/Filesystem.h"
+#include "log/Log.h"
+#include "storage/Device.h"
+#include "storage/StorageManager.h"
+#include "storage/xml/ButtonMapXml.h"
+#include "storage/xml/DatabaseXml.h"
+
+#include "kodi_peripheral_types.h"
+#include "kodi_peripheral_utils.hpp"
+
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define CORPUS_BUTTONMAP_FOLDER  "/resources/buttonmaps" // Under the corpus's user folder
+#define DEFAULT_CONTROLLER       "game.controller.default"
+#define DERIVED_CONTROLLER       "game.controller.snes" // Derived from the default controller by the transformer
+#define INITIALIZE_ITERATIONS    20
+#define GET_FEATURES_ITERATIONS  100000
+#define GET_FEATURES_BATCH_SIZE  100
+#define SAVE_ITERATIONS          1000
+
+namespace
+{
+  /*!
+   * \brief Exposes the stages that CButtonMap::Refresh() runs together
+   */
+  class CBenchButtonMap : public CButtonMapXml
+  {
+  public:
+    using CButtonMapXml::CButtonMapXml;
+
+    bool LoadOnly(void) { return Load(); }
+    bool SaveOnly(void) const { return Save(); }
+
+    const ButtonMap& Features(void) const { return m_buttonMap; }
+    void SetFeatures(const ButtonMap& buttonMap) { m_buttonMap = buttonMap; }
+
+    static void SanitizeFeatures(FeatureVector& features, const std::string& controllerId) { Sanitize(features, controllerId); }
+  };
+
+  typedef std::unique_ptr<CBenchButtonMap> BenchButtonMapPtr;
+
+  double ElapsedNs(const std::chrono::steady_clock::time_point& start)
+  {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void ListButtonMaps(const std::string& path, unsigned int folderDepth, std::vector<std::string>& files)
+  {
+    std::vector<ADDON::CVFSDirEntry> items;
+    CDirectoryUtils::GetDirectory(path, ".xml|", items);
+
+    for (const ADDON::CVFSDirEntry& item : items)
+    {
+      if (!item.IsFolder())
+        files.push_back(item.Path());
+      else if (folderDepth > 0)
+        ListButtonMaps(item.Path(), folderDepth - 1, files);
+    }
+  }
+
+  /*!
+   * \brief Startup as the add-on sees it: create the databases, then index
+   *        and load every button map on the first request for features
+   *
+   * The first run reads the corpus from disk. Later runs find the files in
+   * the page cache, but rebuild all of the add-on's state.
+   */
+  void BenchInitialize(CBenchmarkReport& report, const BenchmarkParameters& parameters, const std::string& corpus, const ADDON::Joystick& probe)
+  {
+    PERIPHERAL_PROPERTIES props = { };
+    props.user_path = corpus.c_str();
+    props.addon_path = ADDON_PATH;
+
+    FeatureVector features;
+
+    auto initialize = [&](unsigned int)
+    {
+      CStorageManager::Get().Initialize(nullptr, props);
+      CStorageManager::Get().GetFeatures(probe, DEFAULT_CONTROLLER, features);
+      CStorageManager::Get().Deinitialize();
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    initialize(0);
+    report.AddSamples("initialize_cold", parameters, { ElapsedNs(start) });
+
+    report.Measure("initialize_warm", parameters, INITIALIZE_ITERATIONS, 1, initialize);
+  }
+
+  void BenchIndexDirectory(CBenchmarkReport& report, const BenchmarkParameters& parameters, const std::string& buttonMapPath, const ADDON::Joystick& probe)
+  {
+    CJoystickFamilyManager familyManager;
+    CControllerTransformer transformer(familyManager);
+    CDatabaseXml database(buttonMapPath, false, &transformer);
+
+    // The first index loads every button map it finds
+    const auto start = std::chrono::steady_clock::now();
+    database.GetButtonMap(probe);
+    report.AddSamples("index_directory_cold", parameters, { ElapsedNs(start) });
+
+    // Later indexes only look for changes
+    report.Measure("index_directory_warm", parameters, INITIALIZE_ITERATIONS, 1, [&](unsigned int)
+    {
+      database.GetButtonMap(probe);
+    });
+  }
+
+  void BenchLoadSave(CBenchmarkReport& report, const BenchmarkParameters& parameters, const std::vector<std::string>& files, const std::vector<BenchButtonMapPtr>& buttonMaps)
+  {
+    report.Measure("load", parameters, files.size(), 1, [&](unsigned int i)
+    {
+      CBenchButtonMap buttonMap(files[i % files.size()]);
+      buttonMap.LoadOnly();
+    });
+
+    char folder[] = "/tmp/storage_bench_XXXXXX";
+    if (mkdtemp(folder) == nullptr)
+      return;
+
+    const std::string path = std::string(folder) + "/buttonmap.xml";
+
+    report.Measure("save", parameters, SAVE_ITERATIONS, 1, [&](unsigned int i)
+    {
+      const CBenchButtonMap& source = *buttonMaps[i % buttonMaps.size()];
+
+      CBenchButtonMap buttonMap(path, source.Device());
+      buttonMap.SetFeatures(source.Features());
+      buttonMap.SaveOnly();
+    });
+
+    CFileUtils::Delete(path);
+    rmdir(folder);
+  }
+
+  void BenchGetFeatures(CBenchmarkReport& report, const BenchmarkParameters& parameters, const std::string& buttonMapPath, const std::vector<BenchButtonMapPtr>& buttonMaps)
+  {
+    CJoystickFamilyManager familyManager;
+    CButtonMapper buttonMapper(nullptr);
+    if (!buttonMapper.Initialize(familyManager))
+      return;
+
+    buttonMapper.RegisterDatabase(DatabasePtr(new CDatabaseXml(buttonMapPath, false, buttonMapper.GetCallbacks())));
+
+    const std::string controllerId = DEFAULT_CONTROLLER;
+    const ADDON::Joystick& probe = *buttonMaps.front()->Device();
+
+    FeatureVector features;
+    buttonMapper.GetFeatures(probe, controllerId, features);
+
+    report.Measure("get_features_cached", parameters, GET_FEATURES_ITERATIONS, GET_FEATURES_BATCH_SIZE, [&](unsigned int)
+    {
+      buttonMapper.GetFeatures(probe, controllerId, features);
+    });
+
+    // Also covers merging the button maps of all databases
+    report.Measure("get_features_uncached", parameters, buttonMaps.size(), 1, [&](unsigned int i)
+    {
+      buttonMapper.InvalidateFeatures();
+      buttonMapper.GetFeatures(*buttonMaps[i % buttonMaps.size()]->Device(), controllerId, features);
+    });
+
+    buttonMapper.Deinitialize();
+  }
+
+  void BenchTransformer(CBenchmarkReport& report, const BenchmarkParameters& parameters, const std::vector<BenchButtonMapPtr>& buttonMaps)
+  {
+    CJoystickFamilyManager familyManager;
+    CControllerTransformer transformer(familyManager);
+
+    std::vector<double> samplesNs;
+    for (const BenchButtonMapPtr& buttonMap : buttonMaps)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      transformer.OnAdd(buttonMap->Device(), buttonMap->Features());
+      samplesNs.push_back(ElapsedNs(start));
+    }
+    report.AddSamples("transformer_learn", parameters, std::move(samplesNs));
+
+    FeatureVector transformedFeatures;
+
+    report.Measure("transformer_transform", parameters, buttonMaps.size(), 1, [&](unsigned int i)
+    {
+      const CBenchButtonMap& buttonMap = *buttonMaps[i % buttonMaps.size()];
+
+      auto it = buttonMap.Features().find(DEFAULT_CONTROLLER);
+      if (it == buttonMap.Features().end())
+        return;
+
+      transformedFeatures.clear();
+      transformer.TransformFeatures(*buttonMap.Device(), DEFAULT_CONTROLLER, DERIVED_CONTROLLER, it->second, transformedFeatures);
+    });
+  }
+
+  void BenchSanitize(CBenchmarkReport& report, const BenchmarkParameters& parameters, const std::vector<BenchButtonMapPtr>& buttonMaps)
+  {
+    std::vector<double> samplesNs;
+
+    const unsigned int count = report.Iterations(buttonMaps.size());
+    for (unsigned int i = 0; i < count; i++)
+    {
+      for (const auto& controller : buttonMaps[i]->Features())
+      {
+        // Sanitizing modifies the features, so time it on a copy
+        FeatureVector features = controller.second;
+
+        const auto start = std::chrono::steady_clock::now();
+        CBenchButtonMap::SanitizeFeatures(features, controller.first);
+        samplesNs.push_back(ElapsedNs(start));
+      }
+    }
+
+    report.AddSamples("sanitize", parameters, std::move(samplesNs));
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  CLog::Get().SetLevel(SYS_LOG_ERROR);
+
+  CBenchmarkReport report("storage_bench", argc, argv);
+
+  std::string corpus;
+  for (int i = 1; i + 1 < argc; i++)
+  {
+    if (strcmp(argv[i], "--corpus") == 0)
+      corpus = argv[i + 1];
+  }
+
+  if (corpus.empty())
+  {
+    fprintf(stderr, "usage: %s --corpus <folder> [--quick] [--output <path>]\n", argv[0]);
+    fprintf(stderr, "The corpus folder is created with:\n");
+    fprintf(stderr, "  generate_buttonmap_corpus.py <folder>" CORPUS_BUTTONMAP_FOLDER "/xml\n");
+    return 1;
+  }
+
+  if (!CFilesystem::Initialize(nullptr))
+    return 1;
+
+  const std::string buttonMapPath = corpus + CORPUS_BUTTONMAP_FOLDER;
+
+  std::vector<std::string> files;
+  ListButtonMaps(buttonMapPath, 2, files);
+
+  std::vector<BenchButtonMapPtr> buttonMaps;
+  for (const std::string& file : files)
+  {
+    BenchButtonMapPtr buttonMap(new CBenchButtonMap(file));
+    if (buttonMap->LoadOnly())
+      buttonMaps.push_back(std::move(buttonMap));
+  }
+
+  if (buttonMaps.empty())
+  {
+    fprintf(stderr, "No button maps found in %s\n", buttonMapPath.c_str());
+    return 1;
+  }
+
+  const BenchmarkParameters parameters = { { "button_maps", buttonMaps.size() } };
+  const ADDON::Joystick& probe = *buttonMaps.front()->Device();
+
+  BenchInitialize(report, parameters, corpus, probe);
+  BenchIndexDirectory(report, parameters, buttonMapPath, probe);
+  BenchLoadSave(report, parameters, files, buttonMaps);
+  BenchGetFeatures(report, parameters, buttonMapPath, buttonMaps);
+  BenchTransformer(report, parameters, buttonMaps);
+  BenchSanitize(report, parameters, buttonMaps);
+
+  buttonMaps.clear();
+  CFilesystem::Deinitialize();
+
+  return report.Write() ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string.h>
+
+using namespace JOYSTICK;
+
+#define QUICK_ITERATION_DIVISOR  100 // Quick runs only check that the cases work
+
+CBenchmarkReport::CBenchmarkReport(const std::string& suite, int argc, char* argv[])
+ : m_suite(suite),
+   m_bQuick(false)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--quick") == 0)
+      m_bQuick = true;
+    else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+      m_outputPath = argv[++i];
+  }
+}
+
+unsigned int CBenchmarkReport::Iterations(unsigned int iterations) const
+{
+  if (m_bQuick)
+    return std::max(iterations / QUICK_ITERATION_DIVISOR, 1u);
+
+  return iterations;
+}
+
+void CBenchmarkReport::AddSamples(const std::string& name, const BenchmarkParameters& parameters, std::vector<double> samplesNs)
+{
+  Result result = { name, parameters, samplesNs.size(), 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+  if (!samplesNs.empty())
+  {
+    std::sort(samplesNs.begin(), samplesNs.end());
+
+    result.meanNs = std::accumulate(samplesNs.begin(), samplesNs.end(), 0.0) / samplesNs.size();
+    result.p50Ns  = Quantile(samplesNs, 0.5);
+    result.p90Ns  = Quantile(samplesNs, 0.9);
+    result.p99Ns  = Quantile(samplesNs, 0.99);
+    result.maxNs  = samplesNs.back();
+  }
+
+  m_results.push_back(std::move(result));
+}
+
+bool CBenchmarkReport::Write(void) const
+{
+  std::ostringstream out;
+
+  out << "{\n  \"suite\": \"" << m_suite << "\",\n  \"results\": [";
+
+  for (unsigned int i = 0; i < m_results.size(); i++)
+  {
+    const Result& result = m_results[i];
+
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\"name\": \"" << result.name << "\", \"parameters\": {";
+
+    for (unsigned int j = 0; j < result.parameters.size(); j++)
+      out << (j == 0 ? "" : ", ") << "\"" << result.parameters[j].first << "\": " << result.parameters[j].second;
+
+    out << "}, "
+        << "\"samples\": " << result.samples << ", "
+        << "\"mean_ns\": " << result.meanNs << ", "
+        << "\"p50_ns\": " << result.p50Ns << ", "
+        << "\"p90_ns\": " << result.p90Ns << ", "
+        << "\"p99_ns\": " << result.p99Ns << ", "
+        << "\"max_ns\": " << result.maxNs << "}";
+  }
+
+  out << "\n  ]\n}\n";
+
+  if (m_outputPath.empty())
+  {
+    std::cout << out.str();
+    return std::cout.good();
+  }
+
+  std::ofstream file(m_outputPath.c_str());
+  file << out.str();
+
+  return file.good();
+}
+
+double CBenchmarkReport::Quantile(const std::vector<double>& sortedSamples, double quantile)
+{
+  const size_t index = static_cast<size_t>(quantile * (sortedSamples.size() - 1) + 0.5);
+  return sortedSamples[std::min(index, sortedSamples.size() - 1)];
+}
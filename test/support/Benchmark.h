@@ -0,0 +1,124 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Named numeric parameters of a benchmark case, in output order
+   */
+  typedef std::vector<std::pair<std::string, double>> BenchmarkParameters;
+
+  /*!
+   * \brief Collects benchmark results and writes them as JSON
+   *
+   * The output has one entry per case with its parameters, the number of
+   * samples, and the mean, p50, p90, p99 and max of the samples in
+   * nanoseconds, so runs can be compared by a script.
+   */
+  class CBenchmarkReport
+  {
+  public:
+    /*!
+     * \param suite Name of the benchmark executable
+     * \param argc, argv Command line. "--quick" runs fewer iterations, and
+     *        "--output <path>" writes the report to a file instead of stdout.
+     */
+    CBenchmarkReport(const std::string& suite, int argc, char* argv[]);
+
+    /*!
+     * \brief Scale an iteration count down for quick runs, such as the smoke
+     *        tests run by ctest
+     */
+    unsigned int Iterations(unsigned int iterations) const;
+
+    /*!
+     * \brief Time an operation
+     *
+     * The operation is run in batches, and each sample is the mean time of
+     * one batch, so that fast operations aren't dominated by reading the
+     * clock.
+     *
+     * \param operation Called with the index of the iteration
+     */
+    template <typename OPERATION>
+    void Measure(const std::string& name, const BenchmarkParameters& parameters, unsigned int iterations, unsigned int batchSize, OPERATION operation)
+    {
+      iterations = Iterations(iterations);
+
+      // Warm up caches and buffers
+      for (unsigned int i = 0; i < iterations / 10; i++)
+        operation(i);
+
+      std::vector<double> samplesNs;
+      samplesNs.reserve(iterations / batchSize + 1);
+
+      for (unsigned int i = 0; i < iterations; i += batchSize)
+      {
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned int j = i; j < i + batchSize; j++)
+          operation(j);
+        const auto end = std::chrono::steady_clock::now();
+
+        samplesNs.push_back(std::chrono::duration<double, std::nano>(end - start).count() / batchSize);
+      }
+
+      AddSamples(name, parameters, samplesNs);
+    }
+
+    /*!
+     * \brief Add samples measured by the caller, such as latencies
+     */
+    void AddSamples(const std::string& name, const BenchmarkParameters& parameters, std::vector<double> samplesNs);
+
+    /*!
+     * \brief Write the report
+     *
+     * \return true if the report was written
+     */
+    bool Write(void) const;
+
+  private:
+    struct Result
+    {
+      std::string         name;
+      BenchmarkParameters parameters;
+      size_t              samples;
+      double              meanNs;
+      double              p50Ns;
+      double              p90Ns;
+      double              p99Ns;
+      double              maxNs;
+    };
+
+    static double Quantile(const std::vector<double>& sortedSamples, double quantile);
+
+    const std::string   m_suite;
+    bool                m_bQuick;
+    std::string         m_outputPath;
+    std::vector<Result> m_results;
+  };
+}
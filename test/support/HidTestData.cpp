@@ -0,0 +1,58 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "HidTestData.h"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+using namespace JOYSTICK;
+
+#define HID_DATA_DIR  TEST_DATA_DIR "/hid/"
+
+std::vector<uint8_t> CHidTestData::ReadDescriptor(const std::string& filename)
+{
+  std::ifstream file(HID_DATA_DIR + filename, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::vector<std::vector<uint8_t>> CHidTestData::ReadReports(const std::string& filename)
+{
+  std::vector<std::vector<uint8_t>> reports;
+
+  std::ifstream file(HID_DATA_DIR + filename);
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream bytes(line);
+    std::vector<uint8_t> report;
+    unsigned int byte;
+    while (bytes >> std::hex >> byte)
+      report.push_back(static_cast<uint8_t>(byte));
+
+    reports.push_back(std::move(report));
+  }
+
+  return reports;
+}
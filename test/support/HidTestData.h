@@ -0,0 +1,46 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Reads the HID descriptors and reports in test/data/hid
+   */
+  class CHidTestData
+  {
+  public:
+    /*!
+     * \brief Read a binary report descriptor
+     *
+     * \return The descriptor, or empty if the file can't be read
+     */
+    static std::vector<uint8_t> ReadDescriptor(const std::string& filename);
+
+    /*!
+     * \brief Read reports written in hex, one per line, skipping comments
+     */
+    static std::vector<std::vector<uint8_t>> ReadReports(const std::string& filename);
+  };
+}
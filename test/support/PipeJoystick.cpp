@@ -0,0 +1,151 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PipeJoystick.h"
+#include "SyntheticJoystick.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#define AXIS_MAX          32767
+#define READ_BATCH_SIZE   64 // Events read per read()
+
+// Defined by kernel headers since 4.16
+#ifndef input_event_sec
+  #define input_event_sec   time.tv_sec
+  #define input_event_usec  time.tv_usec
+#endif
+
+CPipeJoystick::CPipeJoystick(const std::string& strName, unsigned int buttonCount, unsigned int axisCount)
+ : CJoystick(INTERFACE_SYNTHETIC),
+   m_readFd(-1),
+   m_writeFd(-1)
+{
+  SetName(strName);
+  SetButtonCount(buttonCount);
+  SetAxisCount(axisCount);
+}
+
+CPipeJoystick::~CPipeJoystick(void)
+{
+  if (m_readFd >= 0)
+    close(m_readFd);
+  if (m_writeFd >= 0)
+    close(m_writeFd);
+}
+
+bool CPipeJoystick::Open(void)
+{
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) < 0)
+    return false;
+
+  m_readFd = fds[0];
+  m_writeFd = fds[1];
+
+  return true;
+}
+
+int64_t CPipeJoystick::WriteButton(unsigned int buttonIndex, bool bPressed)
+{
+  return WriteEvent(EV_KEY, BTN_MISC + buttonIndex, bPressed ? 1 : 0);
+}
+
+int64_t CPipeJoystick::WriteAxis(unsigned int axisIndex, int value)
+{
+  return WriteEvent(EV_ABS, ABS_X + axisIndex, value);
+}
+
+bool CPipeJoystick::WriteEvents(const input_event* events, size_t count)
+{
+  const size_t size = count * sizeof(input_event);
+
+  // Writes up to PIPE_BUF bytes are atomic, so a reader never sees half an event
+  ssize_t written;
+  do
+  {
+    written = write(m_writeFd, events, size);
+  } while (written < 0 && errno == EINTR);
+
+  return written == static_cast<ssize_t>(size);
+}
+
+int64_t CPipeJoystick::NowNs(void)
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void CPipeJoystick::GetInputFds(std::vector<int>& fds) const
+{
+  if (m_readFd >= 0)
+    fds.push_back(m_readFd);
+}
+
+bool CPipeJoystick::ScanEvents(void)
+{
+  input_event events[READ_BATCH_SIZE];
+
+  ssize_t len;
+  while ((len = read(m_readFd, events, sizeof(events))) > 0)
+  {
+    const size_t count = len / sizeof(input_event);
+
+    for (size_t i = 0; i < count; i++)
+    {
+      const input_event& event = events[i];
+
+      SetEventTime(static_cast<int64_t>(event.input_event_sec) * 1000000000 + event.input_event_usec * 1000);
+
+      if (event.type == EV_KEY && event.code >= BTN_MISC)
+        SetButtonValue(event.code - BTN_MISC, event.value ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED);
+      else if (event.type == EV_ABS)
+        SetAxisValue(event.code - ABS_X, event.value, AXIS_MAX);
+    }
+  }
+
+  return len == 0 || errno == EAGAIN;
+}
+
+int64_t CPipeJoystick::WriteEvent(unsigned int type, unsigned int code, int value)
+{
+  const int64_t nowNs = NowNs();
+
+  input_event events[2] = { };
+
+  events[0].input_event_sec  = nowNs / 1000000000;
+  events[0].input_event_usec = (nowNs % 1000000000) / 1000;
+  events[0].type  = type;
+  events[0].code  = code;
+  events[0].value = value;
+
+  events[1] = events[0];
+  events[1].type  = EV_SYN;
+  events[1].code  = SYN_REPORT;
+  events[1].value = 0;
+
+  return WriteEvents(events, 2) ? nowNs : -1;
+}
@@ -0,0 +1,81 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "api/Joystick.h"
+
+#include <linux/input.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Joystick that reads evdev input_event records from a pipe, the
+   *        way CJoystickUdev reads them from an event node
+   *
+   * The capabilities are preset instead of queried with ioctls, so the
+   * joystick works without /dev/input. Key codes from BTN_MISC are buttons
+   * and absolute codes from ABS_X are axes with a range of +/-32767.
+   * Events are stamped with their timestamps on the monotonic clock.
+   */
+  class CPipeJoystick : public CJoystick
+  {
+  public:
+    CPipeJoystick(const std::string& strName, unsigned int buttonCount, unsigned int axisCount);
+    virtual ~CPipeJoystick(void);
+
+    /*!
+     * \brief Create the pipe
+     */
+    bool Open(void);
+
+    /*!
+     * \brief Write events followed by a SYN_REPORT, stamped with the current
+     *        time
+     *
+     * \return The write time in nanoseconds of the monotonic clock, or -1 on
+     *         error
+     */
+    int64_t WriteButton(unsigned int buttonIndex, bool bPressed);
+    int64_t WriteAxis(unsigned int axisIndex, int value);
+
+    /*!
+     * \brief Write raw events, which must be stamped by the caller
+     */
+    bool WriteEvents(const input_event* events, size_t count);
+
+    static int64_t NowNs(void);
+
+    // implementation of CJoystick
+    virtual void GetInputFds(std::vector<int>& fds) const override;
+
+  protected:
+    // implementation of CJoystick
+    virtual bool ScanEvents(void) override;
+
+  private:
+    int64_t WriteEvent(unsigned int type, unsigned int code, int value);
+
+    int m_readFd;
+    int m_writeFd;
+  };
+}
@@ -0,0 +1,54 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "SyntheticJoystick.h"
+#include "api/IJoystickInterface.h"
+#include "api/JoystickManager.h"
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Interface that discovers the joysticks given to it by the test
+   */
+  class CSyntheticInterface : public IJoystickInterface
+  {
+  public:
+    CSyntheticInterface(const JoystickVector& joysticks) : m_joysticks(joysticks) { }
+    virtual ~CSyntheticInterface(void) = default;
+
+    // implementation of IJoystickInterface
+    virtual const char* Name(void) const override { return INTERFACE_SYNTHETIC; }
+    virtual bool ScanForJoysticks(JoystickVector& joysticks) override;
+
+  private:
+    const JoystickVector m_joysticks;
+  };
+
+  /*!
+   * \brief Scanner callback that ignores scan requests
+   */
+  class CNullScanner : public IScannerCallback
+  {
+  public:
+    // implementation of IScannerCallback
+    virtual void TriggerScan(void) override { }
+  };
+}
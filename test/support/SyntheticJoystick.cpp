@@ -0,0 +1,70 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SyntheticJoystick.h"
+
+using namespace JOYSTICK;
+
+CSyntheticJoystick::CSyntheticJoystick(const std::string& strName, unsigned int buttonCount, unsigned int hatCount, unsigned int axisCount)
+ : CJoystick(INTERFACE_SYNTHETIC),
+   m_buttons(buttonCount, JOYSTICK_STATE_BUTTON_UNPRESSED),
+   m_hats(hatCount, JOYSTICK_STATE_HAT_UNPRESSED),
+   m_axes(axisCount, 0.0f),
+   m_scanCount(0)
+{
+  SetName(strName);
+  SetButtonCount(buttonCount);
+  SetHatCount(hatCount);
+  SetAxisCount(axisCount);
+}
+
+void CSyntheticJoystick::SetButton(unsigned int buttonIndex, bool bPressed)
+{
+  if (buttonIndex < m_buttons.size())
+    m_buttons[buttonIndex] = bPressed ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED;
+}
+
+void CSyntheticJoystick::SetHat(unsigned int hatIndex, JOYSTICK_STATE_HAT hat)
+{
+  if (hatIndex < m_hats.size())
+    m_hats[hatIndex] = hat;
+}
+
+void CSyntheticJoystick::SetAxis(unsigned int axisIndex, float position)
+{
+  if (axisIndex < m_axes.size())
+    m_axes[axisIndex] = position;
+}
+
+bool CSyntheticJoystick::ScanEvents(void)
+{
+  for (unsigned int i = 0; i < m_buttons.size(); i++)
+    SetButtonValue(i, m_buttons[i]);
+
+  for (unsigned int i = 0; i < m_hats.size(); i++)
+    SetHatValue(i, m_hats[i]);
+
+  for (unsigned int i = 0; i < m_axes.size(); i++)
+    SetAxisValue(i, m_axes[i]);
+
+  m_scanCount++;
+
+  return true;
+}
@@ -0,0 +1,62 @@
+/*
+ *      Copyright (C) 2016 Garrett Brown
+ *      Copyright (C) 2016 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this Program; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "api/Joystick.h"
+
+#include <string>
+#include <vector>
+
+#define INTERFACE_SYNTHETIC  "synthetic"
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Joystick whose values are set by the test instead of a driver
+   *
+   * Values set through the public setters are applied by the next scan, as
+   * if the driver had reported them.
+   */
+  class CSyntheticJoystick : public CJoystick
+  {
+  public:
+    CSyntheticJoystick(const std::string& strName, unsigned int buttonCount, unsigned int hatCount, unsigned int axisCount);
+    virtual ~CSyntheticJoystick(void) = default;
+
+    void SetButton(unsigned int buttonIndex, bool bPressed);
+    void SetHat(unsigned int hatIndex, JOYSTICK_STATE_HAT hat);
+    void SetAxis(unsigned int axisIndex, float position);
+
+    /*!
+     * \brief Number of times the joystick has been scanned
+     */
+    unsigned int ScanCount(void) const { return m_scanCount; }
+
+  protected:
+    // implementation of CJoystick
+    virtual bool ScanEvents(void) override;
+
+  private:
+    std::vector<JOYSTICK_STATE_BUTTON> m_buttons;
+    std::vector<JOYSTICK_STATE_HAT>    m_hats;
+    std::vector<JOYSTICK_STATE_AXIS>   m_axes;
+    unsigned int                       m_scanCount;
+  };
+}
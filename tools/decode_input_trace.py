@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+#  Copyright (C) 2016 Garrett Brown
+#  Copyright (C) 2016 Team Kodi
+#
+#  This Program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2, or (at your option)
+#  any later version.
+#
+#  This Program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this Program; see the file COPYING.  If not, see
+#  <http://www.gnu.org/licenses/>.
+#
+
+"""Decode an input trace written by CInputTrace (src/api/InputTrace.h).
+
+Traces are written to the add-on's user folder as input_trace_<index>.bin
+when the add-on receives the announcement:
+
+  JSONRPC.NotifyAll {"sender": "peripheral.joystick", "message": "DumpInputTrace"}
+
+Usage: decode_input_trace.py input_trace_0.bin
+"""
+
+import struct
+import sys
+
+HEADER = struct.Struct("<8sIIIIQ16s64s")
+RECORD = struct.Struct("<QBBHi")
+
+MAGIC = b"JSTRACE1"
+VERSION = 1
+
+POLL, RAW, BUTTON, HAT, AXIS, EMIT_BUTTON, EMIT_HAT, EMIT_AXIS = range(8)
+
+KIND_NAMES = {
+    POLL: "poll",
+    RAW: "raw",
+    BUTTON: "button",
+    HAT: "hat",
+    AXIS: "axis",
+    EMIT_BUTTON: "emit-button",
+    EMIT_HAT: "emit-hat",
+    EMIT_AXIS: "emit-axis",
+}
+
+HAT_NAMES = {
+    0x0: "centered",
+    0x1: "left",
+    0x2: "right",
+    0x4: "up",
+    0x8: "down",
+    0x5: "left-up",
+    0x9: "left-down",
+    0x6: "right-up",
+    0xA: "right-down",
+}
+
+
+def to_float(bits):
+    return struct.unpack("<f", struct.pack("<i", bits))[0]
+
+
+def format_value(kind, value):
+    if kind in (AXIS, EMIT_AXIS):
+        return "%+.4f" % to_float(value)
+    if kind in (BUTTON, EMIT_BUTTON):
+        return "pressed" if value else "released"
+    if kind in (HAT, EMIT_HAT):
+        return HAT_NAMES.get(value, "0x%x" % value)
+    return str(value)
+
+
+def decode(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size:
+        raise ValueError("%s: file is too small" % path)
+
+    magic, version, record_size, record_count, _, dropped, provider, name = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+        raise ValueError("%s: not a version %d input trace" % (path, VERSION))
+
+    provider = provider.rstrip(b"\0").decode("utf-8", "replace")
+    name = name.rstrip(b"\0").decode("utf-8", "replace")
+
+    print("# %s joystick \"%s\": %d records, %d older records overwritten" % (provider, name, record_count, dropped))
+
+    start_ns = None
+    for i in range(record_count):
+        timestamp_ns, kind, type_, index, value = RECORD.unpack_from(data, HEADER.size + i * RECORD.size)
+        if start_ns is None:
+            start_ns = timestamp_ns
+
+        time_ms = (timestamp_ns - start_ns) / 1e6
+        kind_name = KIND_NAMES.get(kind, "kind-%d" % kind)
+
+        if kind == POLL:
+            print("%12.3f ms  %s" % (time_ms, kind_name))
+        elif kind == RAW:
+            print("%12.3f ms    %-11s type=0x%02x code=0x%03x value=%d" % (time_ms, kind_name, type_, index, value))
+        else:
+            print("%12.3f ms    %-11s %-3d %s" % (time_ms, kind_name, index, format_value(kind, value)))
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write(__doc__)
+        return 1
+
+    for path in argv[1:]:
+        decode(path)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+#
+#  Copyright (C) 2016 Garrett Brown
+#  Copyright (C) 2016 Team Kodi
+#
+#  This Program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2, or (at your option)
+#  any later version.
+#
+#  This Program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this Program; see the file COPYING.  If not, see
+#  <http://www.gnu.org/licenses/>.
+#
+
+"""Generate a synthetic corpus of button map XML files.
+
+The corpus mimics community button maps: devices from several providers,
+each mapped to a random selection of controller profiles, with digital,
+hat and analog features. Use it to measure how startup and the mapping UI
+scale with the number of button maps.
+
+Files are written in the layout indexed by the add-on, one folder per
+provider. Point the add-on at the corpus by generating it into the user
+folder's button map directory:
+
+  generate_buttonmap_corpus.py --count 10000 \\
+      ~/.kodi/userdata/addon_data/peripheral.joystick/resources/buttonmaps/xml
+
+Timings are then available from the metrics written by the add-on
+(metrics.prom, or metrics.json after the "DumpMetrics" announcement).
+
+The storage_bench target times each stage offline. Its corpus folder plays
+the role of the user folder:
+
+  generate_buttonmap_corpus.py --count 10000 corpus/resources/buttonmaps/xml
+  test/storage_bench --corpus corpus
+"""
+
+import argparse
+import os
+import random
+import re
+
+PROVIDERS = ["linux", "udev", "android", "cocoa", "directinput", "xinput"]
+
+VENDORS = [
+    ("Generic", 0x0079), ("Logitech", 0x046D), ("Microsoft", 0x045E),
+    ("Sony", 0x054C), ("Nintendo", 0x057E), ("8Bitdo", 0x2DC8),
+    ("PowerA", 0x20D6), ("Hori", 0x0F0D), ("Mad Catz", 0x0738),
+    ("Thrustmaster", 0x044F), ("Nacon", 0x146B), ("Saitek", 0x06A3),
+]
+
+MODELS = [
+    "Gamepad", "Wireless Controller", "USB Joystick", "Pro Controller",
+    "Arcade Stick", "Fight Pad", "Dual Analog Pad", "Retro Controller",
+    "Bluetooth Gamepad", "Wired Controller",
+]
+
+# Controller profile -> (digital features, analog sticks, analog triggers)
+CONTROLLERS = {
+    "game.controller.default": (
+        ["a", "b", "x", "y", "start", "back", "guide", "leftbumper",
+         "rightbumper", "leftthumb", "rightthumb", "up", "down", "right",
+         "left"],
+        ["leftstick", "rightstick"],
+        ["lefttrigger", "righttrigger"],
+    ),
+    "game.controller.nes": (
+        ["a", "b", "start", "select", "up", "down", "right", "left"], [], []),
+    "game.controller.snes": (
+        ["a", "b", "x", "y", "start", "select", "leftbumper", "rightbumper",
+         "up", "down", "right", "left"], [], []),
+    "game.controller.genesis": (
+        ["a", "b", "c", "x", "y", "z", "start", "mode", "up", "down",
+         "right", "left"], [], []),
+    "game.controller.gba": (
+        ["a", "b", "start", "select", "leftbumper", "rightbumper", "up",
+         "down", "right", "left"], [], []),
+    "game.controller.n64": (
+        ["a", "b", "start", "leftbumper", "rightbumper", "z", "up", "down",
+         "right", "left", "cup", "cdown", "cright", "cleft"],
+        ["analogstick"], []),
+    "game.controller.ps": (
+        ["cross", "circle", "square", "triangle", "start", "select",
+         "leftbumper", "rightbumper", "lefttrigger", "righttrigger", "up",
+         "down", "right", "left"], [], []),
+    "game.controller.dreamcast": (
+        ["a", "b", "x", "y", "start", "up", "down", "right", "left"],
+        ["analogstick"], ["lefttrigger", "righttrigger"]),
+}
+
+DIRECTIONS = ["up", "down", "right", "left"]
+
+
+def safe_name(name):
+    """Mirror CStorageUtils::RootFileName()"""
+    name = re.sub(r"[^A-Za-z0-9\-._~]", "_", name)
+    name = re.sub(r"_+", "_", name)
+    return name[:50].strip("_")
+
+
+class Device(object):
+    def __init__(self, rng, provider, index):
+        vendor, vid = rng.choice(VENDORS)
+        self.name = "%s %s %d" % (vendor, rng.choice(MODELS), index)
+        self.provider = provider
+        self.vid = vid
+        self.pid = rng.randint(0x0001, 0xFFFF)
+        self.buttons = rng.randint(8, 24)
+        self.hats = rng.choice([0, 0, 1])
+        self.axes = rng.choice([2, 4, 6, 8])
+
+    def filename(self):
+        name = "%s_v%04X_p%04X_%db" % (safe_name(self.name), self.vid, self.pid, self.buttons)
+        if self.hats:
+            name += "_%dh" % self.hats
+        if self.axes:
+            name += "_%da" % self.axes
+        return name + ".xml"
+
+
+def digital_primitive(rng, device, feature):
+    if device.hats and feature in DIRECTIONS:
+        return 'hat="h0%s"' % feature
+    if rng.random() < 0.1 and device.axes:
+        return 'axis="%s%d"' % (rng.choice("+-"), rng.randrange(device.axes))
+    return 'button="%d"' % rng.randrange(device.buttons)
+
+
+def write_controller(out, rng, device, controller_id):
+    digital, sticks, triggers = CONTROLLERS[controller_id]
+
+    # Community maps are often incomplete
+    mapped = sorted(f for f in digital if rng.random() < 0.9)
+
+    out.append('        <controller id="%s">' % controller_id)
+
+    for feature in mapped:
+        out.append('            <feature name="%s" %s />' % (feature, digital_primitive(rng, device, feature)))
+
+    for i, stick in enumerate(sticks):
+        if device.axes < 2 * (i + 1):
+            break
+        x, y = 2 * i, 2 * i + 1
+        out.append('            <feature name="%s">' % stick)
+        out.append('                <up axis="-%d" />' % y)
+        out.append('                <down axis="+%d" />' % y)
+        out.append('                <right axis="+%d" />' % x)
+        out.append('                <left axis="-%d" />' % x)
+        out.append('            </feature>')
+
+    for i, trigger in enumerate(triggers):
+        axis = device.axes - len(triggers) + i
+        if axis >= 2 * len(sticks):
+            out.append('            <feature name="%s" axis="+%d" />' % (trigger, axis))
+
+    out.append('        </controller>')
+
+
+def write_buttonmap(path, rng, device):
+    out = ['<?xml version="1.0" ?>', '<buttonmap>']
+
+    attrs = 'name="%s" provider="%s" vid="%04X" pid="%04X" buttoncount="%d"' % (
+        device.name, device.provider, device.vid, device.pid, device.buttons)
+    if device.hats:
+        attrs += ' hatcount="%d"' % device.hats
+    if device.axes:
+        attrs += ' axiscount="%d"' % device.axes
+    out.append('    <device %s>' % attrs)
+
+    # Analog triggers that rest at -1
+    if device.axes >= 6 and rng.random() < 0.5:
+        out.append('        <configuration>')
+        for axis in range(device.axes - 2, device.axes):
+            out.append('            <axis index="%d" center="-1" range="2" />' % axis)
+        out.append('        </configuration>')
+
+    profiles = ["game.controller.default"]
+    others = sorted(c for c in CONTROLLERS if c != "game.controller.default")
+    profiles += rng.sample(others, rng.randint(0, len(others)))
+
+    for controller_id in sorted(profiles):
+        write_controller(out, rng, device, controller_id)
+
+    out.append('    </device>')
+    out.append('</buttonmap>')
+
+    with open(path, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("output", help="button map folder to write provider folders into")
+    parser.add_argument("--count", type=int, default=1000, help="number of button maps (default: 1000)")
+    parser.add_argument("--providers", default=",".join(PROVIDERS), help="comma-separated list of providers")
+    parser.add_argument("--seed", type=int, default=0, help="random seed, for reproducible corpora")
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    providers = [p for p in args.providers.split(",") if p]
+
+    for provider in providers:
+        os.makedirs(os.path.join(args.output, provider), exist_ok=True)
+
+    for index in range(args.count):
+        device = Device(rng, providers[index % len(providers)], index)
+        write_buttonmap(os.path.join(args.output, device.provider, device.filename()), rng, device)
+
+    print("Wrote %d button maps to %s" % (args.count, args.output))
+
+
+if __name__ == "__main__":
+    main()